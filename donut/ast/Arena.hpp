@@ -0,0 +1,93 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace donut {
+
+// Bump allocator for AST nodes.
+// Every node allocated from an arena lives until the arena is cleared or destroyed.
+class Arena final {
+public:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+public:
+  Arena() = default;
+  Arena(Arena const&) = delete;
+  Arena(Arena&&) = default;
+  Arena& operator=(Arena const&) = delete;
+  Arena& operator=(Arena&&) = default;
+  ~Arena() noexcept {
+    this->clear();
+  }
+
+public:
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    void* const mem = this->allocate(sizeof(T), alignof(T));
+    T* const obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      this->destructors_.emplace_back(Destructor{obj, [](void* ptr) { static_cast<T*>(ptr)->~T(); }});
+    }
+    return obj;
+  }
+
+  // Destroys all the nodes, but keeps the memory for reuse.
+  void clear() noexcept {
+    for (auto it = this->destructors_.rbegin(); it != this->destructors_.rend(); ++it) {
+      it->destroy(it->obj);
+    }
+    this->destructors_.clear();
+    this->current_ = 0;
+    this->used_ = 0;
+  }
+
+private:
+  void* allocate(size_t const size, size_t const align) {
+    for (;;) {
+      if (this->current_ < this->chunks_.size()) {
+        auto const base = reinterpret_cast<uintptr_t>(this->chunks_[this->current_].get());
+        uintptr_t const ptr = (base + this->used_ + align - 1) & ~(uintptr_t(align) - 1);
+        if (ptr + size <= base + this->chunkSizes_[this->current_]) {
+          this->used_ = ptr + size - base;
+          return reinterpret_cast<void*>(ptr);
+        }
+        if (this->current_ + 1 < this->chunks_.size()) {
+          this->current_++;
+          this->used_ = 0;
+          continue;
+        }
+      }
+      size_t const chunkSize = std::max(kChunkSize, size + align);
+      this->chunks_.emplace_back(std::make_unique<uint8_t[]>(chunkSize));
+      this->chunkSizes_.emplace_back(chunkSize);
+      this->current_ = this->chunks_.size() - 1;
+      this->used_ = 0;
+    }
+  }
+
+private:
+  struct Destructor final {
+    void* obj;
+    void (*destroy)(void*);
+  };
+  std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+  std::vector<size_t> chunkSizes_;
+  size_t current_ = 0;
+  size_t used_ = 0;
+  std::vector<Destructor> destructors_;
+};
+
+}
@@ -0,0 +1,122 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "./Node.hpp"
+#include "../runtime/Interner.hpp"
+
+namespace donut {
+
+class Expr : public Node {
+protected:
+  inline Expr(NodeKind kind, Range&& range)
+  :Node(kind, std::forward<Range>(range))
+  {
+  }
+};
+
+class NumberLiteral final : public Expr {
+public:
+  NumberLiteral(Range&& range, double value)
+  :Expr(NodeKind::Number, std::forward<Range>(range))
+  ,value_(value)
+  {
+  }
+public:
+  [[nodiscard]] double value() const { return this->value_; }
+private:
+  double const value_;
+};
+
+class Identifier final : public Expr {
+public:
+  Identifier(Range&& range, Name name)
+  :Expr(NodeKind::Identifier, std::forward<Range>(range))
+  ,name_(name)
+  {
+  }
+public:
+  [[nodiscard]] Name name() const { return this->name_; }
+private:
+  Name const name_;
+};
+
+enum class UnaryOp : uint8_t {
+  Neg,
+  Not,
+};
+
+class Unary final : public Expr {
+public:
+  Unary(Range&& range, UnaryOp op, Expr* operand)
+  :Expr(NodeKind::Unary, std::forward<Range>(range))
+  ,op_(op)
+  ,operand_(operand)
+  {
+  }
+public:
+  [[nodiscard]] UnaryOp op() const { return this->op_; }
+  [[nodiscard]] Expr* operand() const { return this->operand_; }
+private:
+  UnaryOp const op_;
+  Expr* operand_;
+};
+
+enum class BinaryOp : uint8_t {
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Mod,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  Eq,
+  Ne,
+  And,
+  Or,
+};
+
+class Binary final : public Expr {
+public:
+  Binary(Range&& range, BinaryOp op, Expr* lhs, Expr* rhs)
+  :Expr(NodeKind::Binary, std::forward<Range>(range))
+  ,op_(op)
+  ,lhs_(lhs)
+  ,rhs_(rhs)
+  {
+  }
+public:
+  [[nodiscard]] BinaryOp op() const { return this->op_; }
+  [[nodiscard]] Expr* lhs() const { return this->lhs_; }
+  [[nodiscard]] Expr* rhs() const { return this->rhs_; }
+private:
+  BinaryOp const op_;
+  Expr* lhs_;
+  Expr* rhs_;
+};
+
+class Call final : public Expr {
+public:
+  Call(Range&& range, Name callee, std::vector<Expr*> args)
+  :Expr(NodeKind::Call, std::forward<Range>(range))
+  ,callee_(callee)
+  ,args_(std::move(args))
+  {
+  }
+public:
+  [[nodiscard]] Name callee() const { return this->callee_; }
+  [[nodiscard]] std::vector<Expr*> const& args() const { return this->args_; }
+private:
+  Name const callee_;
+  std::vector<Expr*> args_;
+};
+
+}
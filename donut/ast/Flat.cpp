@@ -0,0 +1,487 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <fmt/format.h>
+#include "../../util/MappedFile.hpp"
+#include "Flat.hpp"
+#include "Arena.hpp"
+#include "Module.hpp"
+
+namespace donut {
+
+namespace {
+
+struct Header final {
+  char magic[4];
+  uint32_t formatVersion;
+  uint32_t numNodes;
+  uint32_t numChildren;
+  uint32_t numParams;
+  uint32_t numNames;
+  uint32_t numStrings;
+  uint32_t filename;
+};
+static_assert(sizeof(Header) % alignof(FlatNode) == 0);
+static_assert(sizeof(FlatNode) % alignof(FlatNode) == 0);
+
+constexpr char kMagic[4] = {'D', 'N', 'A', 'S'};
+
+class Encoder final {
+public:
+  explicit Encoder(Module const& module)
+  :filename_(this->intern(module.filename()))
+  {
+    this->node(&module);
+  }
+
+public:
+  std::vector<uint8_t> bytes() const {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = FlatModule::kFormatVersion;
+    header.numNodes = static_cast<uint32_t>(this->nodes_.size());
+    header.numChildren = static_cast<uint32_t>(this->children_.size());
+    header.numParams = static_cast<uint32_t>(this->params_.size());
+    header.numNames = static_cast<uint32_t>(this->names_.size());
+    header.numStrings = static_cast<uint32_t>(this->strings_.size());
+    header.filename = this->filename_;
+    std::vector<uint8_t> out;
+    out.reserve(sizeof(Header) +
+        sizeof(FlatNode) * this->nodes_.size() +
+        sizeof(uint32_t) * (this->children_.size() + this->params_.size()) +
+        sizeof(FlatString) * this->names_.size() +
+        this->strings_.size());
+    append(out, &header, 1);
+    append(out, this->nodes_.data(), this->nodes_.size());
+    append(out, this->children_.data(), this->children_.size());
+    append(out, this->params_.data(), this->params_.size());
+    append(out, this->names_.data(), this->names_.size());
+    append(out, this->strings_.data(), this->strings_.size());
+    return out;
+  }
+
+private:
+  template <typename T>
+  static void append(std::vector<uint8_t>& out, T const* const data, size_t const count) {
+    auto const ptr = reinterpret_cast<uint8_t const*>(data);
+    out.insert(out.end(), ptr, ptr + sizeof(T) * count);
+  }
+
+  uint32_t node(Node const* n) {
+    auto const idx = static_cast<uint32_t>(this->nodes_.size());
+    Range const& range = n->range();
+    this->nodes_.emplace_back(FlatNode{
+        n->kind(), 0, 0, 0, 0, 0, 0, 0,
+        static_cast<uint32_t>(range.begin().line()),
+        static_cast<uint32_t>(range.begin().column()),
+        static_cast<uint32_t>(range.end().line()),
+        static_cast<uint32_t>(range.end().column()),
+        0.0,
+    });
+    std::vector<uint32_t> children;
+    switch (n->kind()) {
+      case NodeKind::Number:
+        this->nodes_[idx].value = static_cast<NumberLiteral const*>(n)->value();
+        break;
+      case NodeKind::Identifier:
+        this->nodes_[idx].name = this->intern(static_cast<Identifier const*>(n)->name().str());
+        break;
+      case NodeKind::Unary: {
+        auto const* e = static_cast<Unary const*>(n);
+        this->nodes_[idx].op = static_cast<uint8_t>(e->op());
+        children.emplace_back(this->node(e->operand()));
+        break;
+      }
+      case NodeKind::Binary: {
+        auto const* e = static_cast<Binary const*>(n);
+        this->nodes_[idx].op = static_cast<uint8_t>(e->op());
+        children.emplace_back(this->node(e->lhs()));
+        children.emplace_back(this->node(e->rhs()));
+        break;
+      }
+      case NodeKind::Call: {
+        auto const* e = static_cast<Call const*>(n);
+        this->nodes_[idx].name = this->intern(e->callee().str());
+        for (Expr const* arg : e->args()) {
+          children.emplace_back(this->node(arg));
+        }
+        break;
+      }
+      case NodeKind::Block:
+        for (Stmt const* s : static_cast<Block const*>(n)->stmts()) {
+          children.emplace_back(this->node(s));
+        }
+        break;
+      case NodeKind::Var: {
+        auto const* s = static_cast<Var const*>(n);
+        this->nodes_[idx].name = this->intern(s->name().str());
+        children.emplace_back(this->node(s->init()));
+        break;
+      }
+      case NodeKind::Assign: {
+        auto const* s = static_cast<Assign const*>(n);
+        this->nodes_[idx].name = this->intern(s->name().str());
+        children.emplace_back(this->node(s->value()));
+        break;
+      }
+      case NodeKind::If: {
+        auto const* s = static_cast<If const*>(n);
+        children.emplace_back(this->node(s->cond()));
+        children.emplace_back(this->node(s->then()));
+        if (s->otherwise() != nullptr) {
+          children.emplace_back(this->node(s->otherwise()));
+        }
+        break;
+      }
+      case NodeKind::While: {
+        auto const* s = static_cast<While const*>(n);
+        children.emplace_back(this->node(s->cond()));
+        children.emplace_back(this->node(s->body()));
+        break;
+      }
+      case NodeKind::Return:
+        if (Expr const* value = static_cast<Return const*>(n)->value()) {
+          children.emplace_back(this->node(value));
+        }
+        break;
+      case NodeKind::ExprStmt:
+        children.emplace_back(this->node(static_cast<ExprStmt const*>(n)->expr()));
+        break;
+      case NodeKind::Function: {
+        auto const* decl = static_cast<FunctionDecl const*>(n);
+        this->nodes_[idx].name = this->intern(decl->name().str());
+        this->nodes_[idx].params = static_cast<uint32_t>(this->params_.size());
+        this->nodes_[idx].numParams = static_cast<uint32_t>(decl->params().size());
+        for (Name const param : decl->params()) {
+          this->params_.emplace_back(this->intern(param.str()));
+        }
+        children.emplace_back(this->node(decl->body()));
+        break;
+      }
+      case NodeKind::Module:
+        for (FunctionDecl const* decl : static_cast<Module const*>(n)->functions()) {
+          children.emplace_back(this->node(decl));
+        }
+        break;
+    }
+    // Grandchildren have been appended while visiting the children; this node's span comes after them.
+    this->nodes_[idx].children = static_cast<uint32_t>(this->children_.size());
+    this->nodes_[idx].numChildren = static_cast<uint32_t>(children.size());
+    this->children_.insert(this->children_.end(), children.begin(), children.end());
+    return idx;
+  }
+
+  uint32_t intern(std::string_view const str) {
+    auto const it = this->indices_.find(std::string(str));
+    if (it != this->indices_.end()) {
+      return it->second;
+    }
+    auto const idx = static_cast<uint32_t>(this->names_.size());
+    this->names_.emplace_back(FlatString{static_cast<uint32_t>(this->strings_.size()), static_cast<uint32_t>(str.size())});
+    this->strings_.append(str);
+    this->indices_.emplace(std::string(str), idx);
+    return idx;
+  }
+
+private:
+  std::vector<FlatNode> nodes_;
+  std::vector<uint32_t> children_;
+  std::vector<uint32_t> params_;
+  std::vector<FlatString> names_;
+  std::string strings_;
+  std::unordered_map<std::string, uint32_t> indices_;
+  uint32_t filename_;
+};
+
+bool isExpr(NodeKind const kind) {
+  return kind <= NodeKind::Call;
+}
+
+bool isStmt(NodeKind const kind) {
+  return NodeKind::Block <= kind && kind <= NodeKind::ExprStmt;
+}
+
+class Decoder final {
+public:
+  Decoder(FlatModule const& flat, Arena& arena)
+  :flat_(flat)
+  ,arena_(arena)
+  ,filename_(flat.filename())
+  {
+  }
+
+public:
+  template <typename T>
+  T* decode(FlatNode const& n) {
+    return static_cast<T*>(this->node(n));
+  }
+
+private:
+  Node* node(FlatNode const& n) {
+    FlatModule const& flat = this->flat_;
+    Range range(std::string(this->filename_), Position(n.line, n.column), Position(n.endLine, n.endColumn));
+    auto const name = [&]() { return Name::of(flat.str(n.name)); };
+    auto const child = [&](uint32_t const i) { return this->node(flat.child(n, i)); };
+    switch (n.kind) {
+      case NodeKind::Number:
+        return this->arena_.make<NumberLiteral>(std::move(range), n.value);
+      case NodeKind::Identifier:
+        return this->arena_.make<Identifier>(std::move(range), name());
+      case NodeKind::Unary:
+        return this->arena_.make<Unary>(std::move(range), static_cast<UnaryOp>(n.op), static_cast<Expr*>(child(0)));
+      case NodeKind::Binary:
+        return this->arena_.make<Binary>(std::move(range), static_cast<BinaryOp>(n.op), static_cast<Expr*>(child(0)), static_cast<Expr*>(child(1)));
+      case NodeKind::Call: {
+        std::vector<Expr*> args;
+        args.reserve(n.numChildren);
+        for (uint32_t i = 0; i < n.numChildren; ++i) {
+          args.emplace_back(static_cast<Expr*>(child(i)));
+        }
+        return this->arena_.make<Call>(std::move(range), name(), std::move(args));
+      }
+      case NodeKind::Block: {
+        std::vector<Stmt*> stmts;
+        stmts.reserve(n.numChildren);
+        for (uint32_t i = 0; i < n.numChildren; ++i) {
+          stmts.emplace_back(static_cast<Stmt*>(child(i)));
+        }
+        return this->arena_.make<Block>(std::move(range), std::move(stmts));
+      }
+      case NodeKind::Var:
+        return this->arena_.make<Var>(std::move(range), name(), static_cast<Expr*>(child(0)));
+      case NodeKind::Assign:
+        return this->arena_.make<Assign>(std::move(range), name(), static_cast<Expr*>(child(0)));
+      case NodeKind::If: {
+        Stmt* otherwise = n.numChildren > 2 ? static_cast<Stmt*>(child(2)) : nullptr;
+        return this->arena_.make<If>(std::move(range), static_cast<Expr*>(child(0)), static_cast<Block*>(child(1)), otherwise);
+      }
+      case NodeKind::While:
+        return this->arena_.make<While>(std::move(range), static_cast<Expr*>(child(0)), static_cast<Block*>(child(1)));
+      case NodeKind::Return: {
+        Expr* value = n.numChildren > 0 ? static_cast<Expr*>(child(0)) : nullptr;
+        return this->arena_.make<Return>(std::move(range), value);
+      }
+      case NodeKind::ExprStmt:
+        return this->arena_.make<ExprStmt>(std::move(range), static_cast<Expr*>(child(0)));
+      case NodeKind::Function: {
+        std::vector<Name> params;
+        params.reserve(n.numParams);
+        for (uint32_t const param : flat.params(n)) {
+          params.emplace_back(Name::of(flat.str(param)));
+        }
+        return this->arena_.make<FunctionDecl>(std::move(range), name(), std::move(params), static_cast<Block*>(child(0)));
+      }
+      case NodeKind::Module: {
+        std::vector<FunctionDecl*> functions;
+        functions.reserve(n.numChildren);
+        for (uint32_t i = 0; i < n.numChildren; ++i) {
+          functions.emplace_back(static_cast<FunctionDecl*>(child(i)));
+        }
+        return this->arena_.make<Module>(std::move(range), std::move(functions));
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  FlatModule const& flat_;
+  Arena& arena_;
+  std::string_view filename_;
+};
+
+template <typename T> std::span<T const> sliceOf(uint8_t const* const data, size_t& offset, size_t const count) {
+  auto const ptr = reinterpret_cast<T const*>(data + offset);
+  offset += sizeof(T) * count;
+  return std::span<T const>(ptr, count);
+}
+
+}
+
+FlatModule::FlatModule(std::shared_ptr<void const> owner)
+:owner_(std::move(owner))
+{
+}
+
+std::vector<uint8_t> FlatModule::encode(Module const& module) {
+  return Encoder(module).bytes();
+}
+
+void FlatModule::write(std::filesystem::path const& path, Module const& module) {
+  std::vector<uint8_t> const bytes = FlatModule::encode(module);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  if (!out) {
+    throw std::runtime_error(fmt::format("Failed to write AST file: {}", path.string()));
+  }
+}
+
+FlatModule FlatModule::view(std::shared_ptr<void const> owner, std::span<uint8_t const> const bytes) {
+  Header header{};
+  if (bytes.size() < sizeof(Header)) {
+    throw std::runtime_error("Invalid AST file: too short.");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Invalid AST file: bad magic.");
+  }
+  if (header.formatVersion != kFormatVersion) {
+    throw std::runtime_error(fmt::format("Invalid AST file: version {} (expected {}).", header.formatVersion, kFormatVersion));
+  }
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(FlatNode) != 0) {
+    throw std::runtime_error("Invalid AST file: misaligned.");
+  }
+  uint64_t const expectedSize = sizeof(Header) +
+      uint64_t(sizeof(FlatNode)) * header.numNodes +
+      uint64_t(sizeof(uint32_t)) * header.numChildren +
+      uint64_t(sizeof(uint32_t)) * header.numParams +
+      uint64_t(sizeof(FlatString)) * header.numNames +
+      header.numStrings;
+  if (bytes.size() != expectedSize) {
+    throw std::runtime_error(fmt::format("Invalid AST file: {} bytes (expected {}).", bytes.size(), expectedSize));
+  }
+  FlatModule flat(std::move(owner));
+  size_t offset = sizeof(Header);
+  flat.nodes_ = sliceOf<FlatNode>(bytes.data(), offset, header.numNodes);
+  flat.children_ = sliceOf<uint32_t>(bytes.data(), offset, header.numChildren);
+  flat.params_ = sliceOf<uint32_t>(bytes.data(), offset, header.numParams);
+  flat.names_ = sliceOf<FlatString>(bytes.data(), offset, header.numNames);
+  flat.strings_ = std::string_view(reinterpret_cast<char const*>(bytes.data() + offset), header.numStrings);
+  flat.filename_ = header.filename;
+  flat.validate();
+  return flat;
+}
+
+FlatModule FlatModule::from(std::vector<uint8_t> bytes) {
+  auto owner = std::make_shared<std::vector<uint8_t> const>(std::move(bytes));
+  std::span<uint8_t const> const span(*owner);
+  return FlatModule::view(std::move(owner), span);
+}
+
+FlatModule FlatModule::open(std::filesystem::path const& path) {
+  auto file = std::make_shared<util::MappedFile>(path);
+  std::span<uint8_t const> const span(file->data(), file->size());
+  try {
+    return FlatModule::view(std::move(file), span);
+  } catch (std::runtime_error const& err) {
+    throw std::runtime_error(fmt::format("{}: {}", path.string(), err.what()));
+  }
+}
+
+Module const* FlatModule::decode(Arena& arena) const {
+  return Decoder(*this, arena).decode<Module>(this->root());
+}
+
+// Checks everything the accessors and decode() rely on, so that they do not have to.
+void FlatModule::validate() const {
+  auto const fail = [](uint32_t const idx, std::string_view const what) {
+    throw std::runtime_error(fmt::format("Invalid AST file: node {}: {}.", idx, what));
+  };
+  if (this->nodes_.empty() || this->nodes_.front().kind != NodeKind::Module) {
+    fail(0, "the root is not a module");
+  }
+  for (FlatString const& s : this->names_) {
+    if (uint64_t(s.offset) + s.length > this->strings_.size()) {
+      throw std::runtime_error("Invalid AST file: a name is out of the string table.");
+    }
+  }
+  if (this->filename_ >= this->names_.size()) {
+    throw std::runtime_error("Invalid AST file: no file name.");
+  }
+  auto const numNodes = static_cast<uint32_t>(this->nodes_.size());
+  // Every node but the root has exactly one parent, so the nodes form a tree and decode() visits each once.
+  std::vector<bool> parented(numNodes);
+  for (uint32_t idx = 0; idx < numNodes; ++idx) {
+    FlatNode const& n = this->nodes_[idx];
+    if (uint64_t(n.children) + n.numChildren > this->children_.size()) {
+      fail(idx, "children out of range");
+    }
+    // Children come after their parent and in order, which rules out cycles.
+    uint32_t last = idx;
+    for (uint32_t const c : this->children(n)) {
+      if (c <= last || c >= numNodes) {
+        fail(idx, "bad child index");
+      }
+      if (parented[c]) {
+        fail(idx, "child shared with another node");
+      }
+      parented[c] = true;
+      last = c;
+    }
+    auto const kindOf = [&](uint32_t const i) { return this->child(n, i).kind; };
+    auto const allOf = [&](auto const& pred) {
+      for (uint32_t i = 0; i < n.numChildren; ++i) {
+        if (!pred(kindOf(i))) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto const named = [&]() { return n.name < this->names_.size(); };
+    bool ok = false;
+    switch (n.kind) {
+      case NodeKind::Number:
+        ok = n.numChildren == 0;
+        break;
+      case NodeKind::Identifier:
+        ok = n.numChildren == 0 && named();
+        break;
+      case NodeKind::Unary:
+        ok = n.numChildren == 1 && allOf(isExpr) && n.op <= static_cast<uint8_t>(UnaryOp::Not);
+        break;
+      case NodeKind::Binary:
+        ok = n.numChildren == 2 && allOf(isExpr) && n.op <= static_cast<uint8_t>(BinaryOp::Or);
+        break;
+      case NodeKind::Call:
+        ok = named() && allOf(isExpr);
+        break;
+      case NodeKind::Block:
+        ok = allOf(isStmt);
+        break;
+      case NodeKind::Var:
+      case NodeKind::Assign:
+        ok = n.numChildren == 1 && named() && allOf(isExpr);
+        break;
+      case NodeKind::If:
+        ok = (n.numChildren == 2 || n.numChildren == 3) &&
+            isExpr(kindOf(0)) && kindOf(1) == NodeKind::Block &&
+            (n.numChildren == 2 || kindOf(2) == NodeKind::Block || kindOf(2) == NodeKind::If);
+        break;
+      case NodeKind::While:
+        ok = n.numChildren == 2 && isExpr(kindOf(0)) && kindOf(1) == NodeKind::Block;
+        break;
+      case NodeKind::Return:
+        ok = n.numChildren <= 1 && allOf(isExpr);
+        break;
+      case NodeKind::ExprStmt:
+        ok = n.numChildren == 1 && allOf(isExpr);
+        break;
+      case NodeKind::Function:
+        ok = n.numChildren == 1 && named() && kindOf(0) == NodeKind::Block &&
+            uint64_t(n.params) + n.numParams <= this->params_.size();
+        for (uint32_t const param : ok ? this->params(n) : std::span<uint32_t const>()) {
+          ok = ok && param < this->names_.size();
+        }
+        break;
+      case NodeKind::Module:
+        ok = idx == 0 && allOf([](NodeKind const kind) { return kind == NodeKind::Function; });
+        break;
+    }
+    if (!ok) {
+      fail(idx, "malformed");
+    }
+  }
+  for (uint32_t idx = 1; idx < numNodes; ++idx) {
+    if (!parented[idx]) {
+      fail(idx, "no parent");
+    }
+  }
+}
+
+}
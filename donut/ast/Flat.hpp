@@ -0,0 +1,112 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string_view>
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include "./Node.hpp"
+
+namespace donut {
+
+class Arena;
+class Module;
+
+// A string in FlatModule::strings().
+struct FlatString final {
+  uint32_t offset;
+  uint32_t length;
+};
+
+// A node of FlatModule. Children are listed in FlatModule::children(), in this order:
+//   Unary: operand       Binary: lhs, rhs       Call: args...
+//   Block: stmts...      Var: init              Assign: value
+//   If: cond, then[, otherwise]                 While: cond, body
+//   Return: [value]      ExprStmt: expr
+//   Function: body       Module: functions...
+struct FlatNode final {
+  NodeKind kind;
+  uint8_t op;            // UnaryOp or BinaryOp
+  uint16_t reserved;
+  uint32_t name;         // index of FlatModule::names(): Identifier, Call, Var, Assign and Function
+  uint32_t children;     // the first index of FlatModule::children()
+  uint32_t numChildren;
+  uint32_t params;       // the first index of FlatModule::params(), for Function
+  uint32_t numParams;
+  uint32_t line;
+  uint32_t column;
+  uint32_t endLine;
+  uint32_t endColumn;
+  double value;          // NumberLiteral
+};
+
+// Pointer-free encoding of a parsed Module, for the editor tooling and caches.
+// Nodes are stored in pre-order, so the root is node 0 and every child comes after its parent.
+// The encoding is validated once when it is viewed, and can then be traversed in place, e.g. from a mapped file.
+// Integers are in the native byte order.
+class FlatModule final {
+public:
+  // Bump this when the layout changes.
+  static constexpr uint32_t kFormatVersion = 1;
+
+public:
+  FlatModule() = delete;
+  FlatModule(FlatModule const&) = delete;
+  FlatModule(FlatModule&&) = default;
+  FlatModule& operator=(FlatModule const&) = delete;
+  FlatModule& operator=(FlatModule&&) = default;
+
+public:
+  [[nodiscard]] static std::vector<uint8_t> encode(Module const& module);
+  static void write(std::filesystem::path const& path, Module const& module);
+  // Throws if the bytes are not a valid encoding. `owner` keeps the bytes alive.
+  [[nodiscard]] static FlatModule view(std::shared_ptr<void const> owner, std::span<uint8_t const> bytes);
+  [[nodiscard]] static FlatModule from(std::vector<uint8_t> bytes);
+  [[nodiscard]] static FlatModule open(std::filesystem::path const& path);
+
+public:
+  // Rebuilds the tree, with names interned.
+  Module const* decode(Arena& arena) const;
+
+public:
+  [[nodiscard]] FlatNode const& root() const { return this->nodes_.front(); }
+  [[nodiscard]] FlatNode const& node(uint32_t const idx) const { return this->nodes_[idx]; }
+  [[nodiscard]] std::span<FlatNode const> nodes() const { return this->nodes_; }
+  [[nodiscard]] std::span<uint32_t const> children(FlatNode const& node) const {
+    return this->children_.subspan(node.children, node.numChildren);
+  }
+  [[nodiscard]] FlatNode const& child(FlatNode const& node, uint32_t const i) const {
+    return this->nodes_[this->children_[node.children + i]];
+  }
+  [[nodiscard]] std::span<uint32_t const> params(FlatNode const& node) const {
+    return this->params_.subspan(node.params, node.numParams);
+  }
+  [[nodiscard]] std::span<FlatString const> names() const { return this->names_; }
+  [[nodiscard]] std::string_view str(uint32_t const name) const {
+    FlatString const s = this->names_[name];
+    return this->strings_.substr(s.offset, s.length);
+  }
+  [[nodiscard]] std::string_view filename() const { return this->str(this->filename_); }
+
+private:
+  explicit FlatModule(std::shared_ptr<void const> owner);
+  void validate() const;
+
+private:
+  std::shared_ptr<void const> owner_;
+  std::span<FlatNode const> nodes_;
+  std::span<uint32_t const> children_;
+  std::span<uint32_t const> params_;
+  std::span<FlatString const> names_;
+  std::string_view strings_;
+  uint32_t filename_ = 0;
+};
+
+}
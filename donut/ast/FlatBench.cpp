@@ -0,0 +1,41 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include "../../util/Bench.hpp"
+#include "../../util/File.hpp"
+#include "./Flat.hpp"
+#include "./Arena.hpp"
+#include "./Module.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+
+// Parsing the source vs viewing (validating) and decoding its flat encoding.
+BENCH(DonutFlat) {
+  std::printf("%-8s %8s %12s %12s %12s\n", "pattern", "nodes", "parse", "view", "decode");
+  for (std::string const name : {"ring", "spiral", "aimed", "petals"}) {
+    std::string const filename = "resources/test/patterns/" + name + ".donut";
+    std::string const content = util::readAllFromFileAsString(filename);
+    donut::Arena arena;
+    std::vector<uint8_t> const bytes = donut::FlatModule::encode(*donut::Parser(arena).parse(donut::Stream::from(filename, content)));
+    auto const owner = std::make_shared<std::vector<uint8_t> const>(bytes);
+    double const parse = util::measure([&]() {
+      arena.clear();
+      donut::Parser(arena).parse(donut::Stream::from(filename, content));
+    });
+    size_t nodes = 0;
+    double const view = util::measure([&]() {
+      nodes = donut::FlatModule::view(owner, *owner).nodes().size();
+    });
+    donut::FlatModule const flat = donut::FlatModule::view(owner, *owner);
+    double const decode = util::measure([&]() {
+      arena.clear();
+      flat.decode(arena);
+    });
+    std::printf("%-8s %8zu %9.2f us %9.2f us %9.2f us\n", name.c_str(), nodes, parse * 1e6, view * 1e6, decode * 1e6);
+  }
+}
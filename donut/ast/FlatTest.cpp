@@ -0,0 +1,279 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fmt/format.h>
+#include "./Flat.hpp"
+#include "./Arena.hpp"
+#include "./Module.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../../util/TempDir.hpp"
+
+namespace donut {
+
+namespace {
+
+void expectSameTree(Node const* a, Node const* b);
+
+template <typename T>
+void expectSameList(std::vector<T*> const& a, std::vector<T*> const& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    expectSameTree(a[i], b[i]);
+  }
+}
+
+void expectSameTree(Node const* a, Node const* b) {
+  if (a == nullptr || b == nullptr) {
+    ASSERT_EQ(a, b);
+    return;
+  }
+  ASSERT_EQ(a->kind(), b->kind());
+  EXPECT_EQ(a->range().filename(), b->range().filename());
+  EXPECT_EQ(a->range().begin().line(), b->range().begin().line());
+  EXPECT_EQ(a->range().begin().column(), b->range().begin().column());
+  EXPECT_EQ(a->range().end().line(), b->range().end().line());
+  EXPECT_EQ(a->range().end().column(), b->range().end().column());
+  switch (a->kind()) {
+    case NodeKind::Number: {
+      double const x = static_cast<NumberLiteral const*>(a)->value();
+      double const y = static_cast<NumberLiteral const*>(b)->value();
+      EXPECT_EQ(0, std::memcmp(&x, &y, sizeof(double)));
+      break;
+    }
+    case NodeKind::Identifier:
+      EXPECT_EQ(static_cast<Identifier const*>(a)->name(), static_cast<Identifier const*>(b)->name());
+      break;
+    case NodeKind::Unary: {
+      auto const* x = static_cast<Unary const*>(a);
+      auto const* y = static_cast<Unary const*>(b);
+      EXPECT_EQ(x->op(), y->op());
+      expectSameTree(x->operand(), y->operand());
+      break;
+    }
+    case NodeKind::Binary: {
+      auto const* x = static_cast<Binary const*>(a);
+      auto const* y = static_cast<Binary const*>(b);
+      EXPECT_EQ(x->op(), y->op());
+      expectSameTree(x->lhs(), y->lhs());
+      expectSameTree(x->rhs(), y->rhs());
+      break;
+    }
+    case NodeKind::Call: {
+      auto const* x = static_cast<Call const*>(a);
+      auto const* y = static_cast<Call const*>(b);
+      EXPECT_EQ(x->callee(), y->callee());
+      expectSameList(x->args(), y->args());
+      break;
+    }
+    case NodeKind::Block:
+      expectSameList(static_cast<Block const*>(a)->stmts(), static_cast<Block const*>(b)->stmts());
+      break;
+    case NodeKind::Var: {
+      auto const* x = static_cast<Var const*>(a);
+      auto const* y = static_cast<Var const*>(b);
+      EXPECT_EQ(x->name(), y->name());
+      expectSameTree(x->init(), y->init());
+      break;
+    }
+    case NodeKind::Assign: {
+      auto const* x = static_cast<Assign const*>(a);
+      auto const* y = static_cast<Assign const*>(b);
+      EXPECT_EQ(x->name(), y->name());
+      expectSameTree(x->value(), y->value());
+      break;
+    }
+    case NodeKind::If: {
+      auto const* x = static_cast<If const*>(a);
+      auto const* y = static_cast<If const*>(b);
+      expectSameTree(x->cond(), y->cond());
+      expectSameTree(x->then(), y->then());
+      expectSameTree(x->otherwise(), y->otherwise());
+      break;
+    }
+    case NodeKind::While: {
+      auto const* x = static_cast<While const*>(a);
+      auto const* y = static_cast<While const*>(b);
+      expectSameTree(x->cond(), y->cond());
+      expectSameTree(x->body(), y->body());
+      break;
+    }
+    case NodeKind::Return:
+      expectSameTree(static_cast<Return const*>(a)->value(), static_cast<Return const*>(b)->value());
+      break;
+    case NodeKind::ExprStmt:
+      expectSameTree(static_cast<ExprStmt const*>(a)->expr(), static_cast<ExprStmt const*>(b)->expr());
+      break;
+    case NodeKind::Function: {
+      auto const* x = static_cast<FunctionDecl const*>(a);
+      auto const* y = static_cast<FunctionDecl const*>(b);
+      EXPECT_EQ(x->name(), y->name());
+      EXPECT_EQ(x->params(), y->params());
+      expectSameTree(x->body(), y->body());
+      break;
+    }
+    case NodeKind::Module:
+      expectSameList(static_cast<Module const*>(a)->functions(), static_cast<Module const*>(b)->functions());
+      break;
+  }
+}
+
+}
+
+TEST(DonutFlatTest, RoundTripTest) {
+  for (std::string const filename : {
+      "resources/test/patterns/ring.donut",
+      "resources/test/patterns/spiral.donut",
+      "resources/test/patterns/aimed.donut",
+      "resources/test/patterns/petals.donut",
+      "resources/test/stage/main.donut",
+      "resources/test/stage/util.donut",
+  }) {
+    SCOPED_TRACE(filename);
+    Arena arena;
+    Module const* parsed = Parser(arena).parse(Stream::open(filename));
+    std::vector<uint8_t> const bytes = FlatModule::encode(*parsed);
+    FlatModule const flat = FlatModule::from(bytes);
+    EXPECT_EQ(filename, flat.filename());
+    Module const* decoded = flat.decode(arena);
+    expectSameTree(parsed, decoded);
+    EXPECT_EQ(bytes, FlatModule::encode(*decoded));
+  }
+}
+
+TEST(DonutFlatTest, TraverseTest) {
+  Arena arena;
+  Module const* module = Parser(arena).parse(Stream::from("flat.donut", R"(
+fn main(a, b) {
+  if (a < 1) {
+    emit(1.5, a);
+  } else if (b) {
+    return;
+  }
+  while (a) {
+    a = a - 1;
+    emit(-a);
+  }
+}
+fn other() {
+}
+)"));
+  FlatModule const flat = FlatModule::from(FlatModule::encode(*module));
+  FlatNode const& root = flat.root();
+  ASSERT_EQ(NodeKind::Module, root.kind);
+  ASSERT_EQ(2, root.numChildren);
+  FlatNode const& main = flat.child(root, 0);
+  EXPECT_EQ("main", flat.str(main.name));
+  ASSERT_EQ(2, main.numParams);
+  EXPECT_EQ("a", flat.str(flat.params(main)[0]));
+  EXPECT_EQ("b", flat.str(flat.params(main)[1]));
+  EXPECT_EQ(2, main.line);
+  EXPECT_EQ("other", flat.str(flat.child(root, 1).name));
+
+  FlatNode const& branch = flat.child(flat.child(main, 0), 0);
+  ASSERT_EQ(NodeKind::If, branch.kind);
+  ASSERT_EQ(3, branch.numChildren);
+  FlatNode const& cond = flat.child(branch, 0);
+  EXPECT_EQ(static_cast<uint8_t>(BinaryOp::Lt), cond.op);
+  EXPECT_EQ(1.0, flat.child(cond, 1).value);
+  FlatNode const& otherwise = flat.child(branch, 2);
+  ASSERT_EQ(NodeKind::If, otherwise.kind);
+  EXPECT_EQ(NodeKind::Return, flat.child(flat.child(otherwise, 1), 0).kind);
+  EXPECT_EQ(0, flat.child(flat.child(otherwise, 1), 0).numChildren);
+
+  // Names are stored once.
+  size_t emits = 0;
+  uint32_t emit = UINT32_MAX;
+  for (FlatNode const& n : flat.nodes()) {
+    if (n.kind == NodeKind::Call) {
+      emits++;
+      EXPECT_TRUE(emit == UINT32_MAX || emit == n.name);
+      emit = n.name;
+    }
+  }
+  EXPECT_EQ(2, emits);
+}
+
+TEST(DonutFlatTest, FileTest) {
+  util::TempDir const dir("donut-flat-test");
+  std::filesystem::path const path = dir / "flat.dnas";
+  Arena arena;
+  Module const* parsed = Parser(arena).parse(Stream::open("resources/test/patterns/spiral.donut"));
+  FlatModule::write(path, *parsed);
+  FlatModule const flat = FlatModule::open(path);
+  expectSameTree(parsed, flat.decode(arena));
+  std::filesystem::remove(path);
+  EXPECT_THROW(FlatModule::open(path), std::runtime_error);
+}
+
+TEST(DonutFlatTest, InvalidTest) {
+  Arena arena;
+  Module const* module = Parser(arena).parse(Stream::from("flat.donut", "fn main() { emit(1 + 2); }"));
+  std::vector<uint8_t> const bytes = FlatModule::encode(*module);
+  EXPECT_NO_THROW(FlatModule::from(bytes));
+  {
+    std::vector<uint8_t> broken = bytes;
+    broken.pop_back();
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  {
+    std::vector<uint8_t> broken = bytes;
+    broken[0] = 'X';
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  // Offset of a part of the encoding.
+  auto const offsetOf = [&bytes](auto const& part) {
+    FlatModule const flat = FlatModule::view(nullptr, bytes);
+    return static_cast<size_t>(reinterpret_cast<uint8_t const*>(part(flat)) - bytes.data());
+  };
+  {
+    // The module becomes its own child.
+    std::vector<uint8_t> broken = bytes;
+    size_t const at = offsetOf([](FlatModule const& flat) { return flat.children(flat.root()).data(); });
+    uint32_t const root = 0;
+    std::memcpy(&broken[at], &root, sizeof(uint32_t));
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  // The children of `1 + 2`.
+  auto const operands = [](FlatModule const& flat) {
+    FlatNode const& binary = *std::find_if(flat.nodes().begin(), flat.nodes().end(), [](FlatNode const& n) {
+      return n.kind == NodeKind::Binary;
+    });
+    return flat.children(binary).data();
+  };
+  {
+    // `1 + 1`, sharing the node: a file of such nodes would take exponential time to decode.
+    std::vector<uint8_t> broken = bytes;
+    size_t const at = offsetOf(operands);
+    std::memcpy(&broken[at + sizeof(uint32_t)], &broken[at], sizeof(uint32_t));
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  {
+    // `2 + 1`, out of order.
+    std::vector<uint8_t> broken = bytes;
+    size_t const at = offsetOf(operands);
+    std::swap_ranges(&broken[at], &broken[at + sizeof(uint32_t)], &broken[at + sizeof(uint32_t)]);
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  {
+    std::vector<uint8_t> broken = bytes;
+    broken[offsetOf([](FlatModule const& flat) { return &flat.node(1).kind; })] = 0xff;
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+  {
+    // The function becomes a block.
+    std::vector<uint8_t> broken = bytes;
+    broken[offsetOf([](FlatModule const& flat) { return &flat.node(1).kind; })] = static_cast<uint8_t>(NodeKind::Block);
+    EXPECT_THROW(FlatModule::from(broken), std::runtime_error);
+  }
+}
+
+}
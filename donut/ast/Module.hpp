@@ -0,0 +1,51 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "./Node.hpp"
+#include "./Stmt.hpp"
+
+namespace donut {
+
+// fn name(params...) { body }
+class FunctionDecl final : public Node {
+public:
+  FunctionDecl(Range&& range, Name name, std::vector<Name> params, Block* body)
+  :Node(NodeKind::Function, std::forward<Range>(range))
+  ,name_(name)
+  ,params_(std::move(params))
+  ,body_(body)
+  {
+  }
+public:
+  [[nodiscard]] Name name() const { return this->name_; }
+  [[nodiscard]] std::vector<Name> const& params() const { return this->params_; }
+  [[nodiscard]] Block* body() const { return this->body_; }
+private:
+  Name const name_;
+  std::vector<Name> const params_;
+  Block* body_;
+};
+
+// A script file.
+class Module final : public Node {
+public:
+  Module(Range&& range, std::vector<FunctionDecl*> functions)
+  :Node(NodeKind::Module, std::forward<Range>(range))
+  ,functions_(std::move(functions))
+  {
+  }
+public:
+  [[nodiscard]] std::string const& filename() const { return this->range().filename(); }
+  [[nodiscard]] std::vector<FunctionDecl*> const& functions() const { return this->functions_; }
+private:
+  std::vector<FunctionDecl*> functions_;
+};
+
+}
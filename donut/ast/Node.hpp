@@ -6,21 +6,47 @@
  */
 
 #pragma once
+#include <cstdint>
 #include "./Position.hpp"
 
 namespace donut {
 
+enum class NodeKind : uint8_t {
+  // Expressions
+  Number = 0,
+  Identifier,
+  Unary,
+  Binary,
+  Call,
+  // Statements
+  Block,
+  Var,
+  Assign,
+  If,
+  While,
+  Return,
+  ExprStmt,
+  // Declarations
+  Function,
+  Module,
+};
+
 class Node {
 protected:
-  inline Node(Range&& range)
-  :range_(std::forward<Range>(range))
+  inline Node(NodeKind kind, Range&& range)
+  :kind_(kind)
+  ,range_(std::forward<Range>(range))
   {
   }
 public:
   Node() = delete;
+  Node(Node const&) = delete;
+  Node& operator=(Node const&) = delete;
 public:
+  [[nodiscard]] NodeKind kind() const { return this->kind_; }
   [[nodiscard]] Range const& range() const { return this->range_; }
 private:
+  NodeKind const kind_;
   Range const range_;
 };
 
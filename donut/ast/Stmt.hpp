@@ -0,0 +1,134 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "./Node.hpp"
+#include "./Expr.hpp"
+
+namespace donut {
+
+class Stmt : public Node {
+protected:
+  inline Stmt(NodeKind kind, Range&& range)
+  :Node(kind, std::forward<Range>(range))
+  {
+  }
+};
+
+class Block final : public Stmt {
+public:
+  Block(Range&& range, std::vector<Stmt*> stmts)
+  :Stmt(NodeKind::Block, std::forward<Range>(range))
+  ,stmts_(std::move(stmts))
+  {
+  }
+public:
+  [[nodiscard]] std::vector<Stmt*> const& stmts() const { return this->stmts_; }
+private:
+  std::vector<Stmt*> stmts_;
+};
+
+// var name = init;
+class Var final : public Stmt {
+public:
+  Var(Range&& range, Name name, Expr* init)
+  :Stmt(NodeKind::Var, std::forward<Range>(range))
+  ,name_(name)
+  ,init_(init)
+  {
+  }
+public:
+  [[nodiscard]] Name name() const { return this->name_; }
+  [[nodiscard]] Expr* init() const { return this->init_; }
+private:
+  Name const name_;
+  Expr* init_;
+};
+
+// name = value;
+class Assign final : public Stmt {
+public:
+  Assign(Range&& range, Name name, Expr* value)
+  :Stmt(NodeKind::Assign, std::forward<Range>(range))
+  ,name_(name)
+  ,value_(value)
+  {
+  }
+public:
+  [[nodiscard]] Name name() const { return this->name_; }
+  [[nodiscard]] Expr* value() const { return this->value_; }
+private:
+  Name const name_;
+  Expr* value_;
+};
+
+class If final : public Stmt {
+public:
+  If(Range&& range, Expr* cond, Block* then, Stmt* otherwise)
+  :Stmt(NodeKind::If, std::forward<Range>(range))
+  ,cond_(cond)
+  ,then_(then)
+  ,otherwise_(otherwise)
+  {
+  }
+public:
+  [[nodiscard]] Expr* cond() const { return this->cond_; }
+  [[nodiscard]] Block* then() const { return this->then_; }
+  // Block, If, or nullptr.
+  [[nodiscard]] Stmt* otherwise() const { return this->otherwise_; }
+private:
+  Expr* cond_;
+  Block* then_;
+  Stmt* otherwise_;
+};
+
+class While final : public Stmt {
+public:
+  While(Range&& range, Expr* cond, Block* body)
+  :Stmt(NodeKind::While, std::forward<Range>(range))
+  ,cond_(cond)
+  ,body_(body)
+  {
+  }
+public:
+  [[nodiscard]] Expr* cond() const { return this->cond_; }
+  [[nodiscard]] Block* body() const { return this->body_; }
+private:
+  Expr* cond_;
+  Block* body_;
+};
+
+class Return final : public Stmt {
+public:
+  Return(Range&& range, Expr* value)
+  :Stmt(NodeKind::Return, std::forward<Range>(range))
+  ,value_(value)
+  {
+  }
+public:
+  // nullptr for `return;`
+  [[nodiscard]] Expr* value() const { return this->value_; }
+private:
+  Expr* value_;
+};
+
+class ExprStmt final : public Stmt {
+public:
+  ExprStmt(Range&& range, Expr* expr)
+  :Stmt(NodeKind::ExprStmt, std::forward<Range>(range))
+  ,expr_(expr)
+  {
+  }
+public:
+  [[nodiscard]] Expr* expr() const { return this->expr_; }
+private:
+  Expr* expr_;
+};
+
+}
@@ -0,0 +1,370 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Compiler.hpp"
+#include "Types.hpp"
+#include "../ast/Module.hpp"
+#include "../vm/Spawn.hpp"
+
+namespace donut {
+
+namespace {
+
+// Registers are allocated as a stack: locals first, then temporaries above them.
+class FunctionCompiler final {
+public:
+  FunctionCompiler(Source& src, FunctionDecl const& decl, FunctionTypes const* types)
+  :src_(src)
+  ,decl_(decl)
+  ,types_(types)
+  {
+  }
+
+public:
+  void compile() {
+    // Calls to these names are compiled as builtins, so a function of the same name could never be called.
+    static Name const wait = Name::of("wait");
+    if (this->decl_.name() == wait || spawnKindOf(this->decl_.name().str()).has_value()) {
+      this->fail(this->decl_, fmt::format("{} is a builtin and cannot be redefined.", this->decl_.name()));
+    }
+    for (Name const param : this->decl_.params()) {
+      this->locals_.emplace_back(param, this->alloc(this->decl_));
+    }
+    this->compileBlock(*this->decl_.body());
+    // implicit `return 0;`
+    this->line_ = static_cast<uint32_t>(this->decl_.range().end().line());
+    uint8_t const r = this->alloc(this->decl_);
+    this->emit(Instruction::abx(Opcode::LoadK, r, this->src_.constant(Box::integer(0))));
+    this->emit(Instruction::abc(Opcode::Ret, r, 0, 0));
+    this->free(r);
+    this->src_.addFunction(
+        std::string(this->decl_.name().str()),
+        static_cast<uint8_t>(this->decl_.params().size()),
+        static_cast<uint8_t>(this->maxRegisters_),
+        this->code_,
+        DebugInfo{this->decl_.range().filename(), static_cast<uint32_t>(this->decl_.range().begin().line()), this->lines_});
+  }
+
+private:
+  void compileBlock(Block const& block) {
+    size_t const numLocals = this->locals_.size();
+    uint8_t const top = this->top_;
+    for (Stmt const* stmt : block.stmts()) {
+      this->compileStmt(*stmt);
+    }
+    this->locals_.resize(numLocals);
+    this->top_ = top;
+  }
+
+  void compileStmt(Stmt const& stmt) {
+    LineScope const scope(*this, stmt);
+    switch (stmt.kind()) {
+      case NodeKind::Block:
+        this->compileBlock(static_cast<Block const&>(stmt));
+        break;
+      case NodeKind::Var: {
+        auto const& var = static_cast<Var const&>(stmt);
+        uint8_t const r = this->alloc(stmt);
+        this->compileExpr(*var.init(), r);
+        this->locals_.emplace_back(var.name(), r);
+        break;
+      }
+      case NodeKind::Assign: {
+        auto const& assign = static_cast<Assign const&>(stmt);
+        uint8_t const local = this->lookup(assign.name(), stmt);
+        uint8_t const r = this->alloc(stmt);
+        this->compileExpr(*assign.value(), r);
+        this->emit(Instruction::abc(Opcode::Move, local, r, 0));
+        this->free(r);
+        break;
+      }
+      case NodeKind::If: {
+        auto const& branch = static_cast<If const&>(stmt);
+        uint8_t const cond = this->alloc(stmt);
+        this->compileExpr(*branch.cond(), cond);
+        this->free(cond);
+        size_t const toElse = this->emitJump(this->branch(false, *branch.cond()), cond);
+        this->compileBlock(*branch.then());
+        if (branch.otherwise() == nullptr) {
+          this->patchJump(stmt, toElse);
+          break;
+        }
+        size_t const toEnd = this->emitJump(Opcode::Jmp, 0);
+        this->patchJump(stmt, toElse);
+        this->compileStmt(*branch.otherwise());
+        this->patchJump(stmt, toEnd);
+        break;
+      }
+      case NodeKind::While: {
+        auto const& loop = static_cast<While const&>(stmt);
+        size_t const beg = this->code_.size();
+        uint8_t const cond = this->alloc(stmt);
+        this->compileExpr(*loop.cond(), cond);
+        this->free(cond);
+        size_t const toEnd = this->emitJump(this->branch(false, *loop.cond()), cond);
+        this->compileBlock(*loop.body());
+        this->emit(Instruction::asbx(Opcode::Jmp, 0, this->jumpOffset(stmt, this->code_.size(), beg)));
+        this->patchJump(stmt, toEnd);
+        break;
+      }
+      case NodeKind::Return: {
+        auto const& ret = static_cast<Return const&>(stmt);
+        uint8_t const r = this->alloc(stmt);
+        if (ret.value() != nullptr) {
+          this->compileExpr(*ret.value(), r);
+        } else {
+          this->emit(Instruction::abx(Opcode::LoadK, r, this->src_.constant(Box::integer(0))));
+        }
+        this->emit(Instruction::abc(Opcode::Ret, r, 0, 0));
+        this->free(r);
+        break;
+      }
+      case NodeKind::ExprStmt: {
+        uint8_t const r = this->alloc(stmt);
+        this->compileExpr(*static_cast<ExprStmt const&>(stmt).expr(), r);
+        this->free(r);
+        break;
+      }
+      default:
+        this->fail(stmt, "Unknown statement.");
+    }
+  }
+
+  void compileExpr(Expr const& expr, uint8_t const dst) {
+    LineScope const scope(*this, expr);
+    switch (expr.kind()) {
+      case NodeKind::Number: {
+        double const v = static_cast<NumberLiteral const&>(expr).value();
+        // Typed Num when it meets a double; see FunctionTypes.
+        Box const k = this->typeOf(expr) == Type::Num ? Box(v) : boxOf(v);
+        this->emit(Instruction::abx(Opcode::LoadK, dst, this->src_.constant(k)));
+        break;
+      }
+      case NodeKind::Identifier: {
+        uint8_t const local = this->lookup(static_cast<Identifier const&>(expr).name(), expr);
+        this->emit(Instruction::abc(Opcode::Move, dst, local, 0));
+        break;
+      }
+      case NodeKind::Unary: {
+        auto const& unary = static_cast<Unary const&>(expr);
+        this->compileExpr(*unary.operand(), dst);
+        Type const t = this->typeOf(*unary.operand());
+        Opcode op;
+        if (unary.op() == UnaryOp::Neg) {
+          op = t == Type::Num ? Opcode::NegF : Opcode::Neg;
+        } else {
+          op = t == Type::Bool ? Opcode::NotB : Opcode::Not;
+        }
+        this->emit(Instruction::abc(op, dst, dst, 0));
+        break;
+      }
+      case NodeKind::Binary:
+        this->compileBinary(static_cast<Binary const&>(expr), dst);
+        break;
+      case NodeKind::Call:
+        this->compileCall(static_cast<Call const&>(expr), dst);
+        break;
+      default:
+        this->fail(expr, "Unknown expression.");
+    }
+  }
+
+  void compileBinary(Binary const& expr, uint8_t const dst) {
+    this->compileExpr(*expr.lhs(), dst);
+    if (expr.op() == BinaryOp::And || expr.op() == BinaryOp::Or) {
+      size_t const toEnd = this->emitJump(this->branch(expr.op() == BinaryOp::Or, *expr.lhs()), dst);
+      this->compileExpr(*expr.rhs(), dst);
+      this->patchJump(expr, toEnd);
+      return;
+    }
+    uint8_t const rhs = this->alloc(expr);
+    this->compileExpr(*expr.rhs(), rhs);
+    Type const lt = this->typeOf(*expr.lhs());
+    Type const rt = this->typeOf(*expr.rhs());
+    // Either of them a double and the other a number of any kind; or both ints.
+    bool const floats = (lt == Type::Num && isNumeric(rt)) || (rt == Type::Num && isNumeric(lt));
+    bool const ints = lt == Type::Int && rt == Type::Int;
+    bool const numerics = isNumeric(lt) && isNumeric(rt);
+    auto const pick = [&](Opcode const f, Opcode const i, Opcode const generic) {
+      return floats ? f : ints ? i : generic;
+    };
+    switch (expr.op()) {
+      case BinaryOp::Add: this->emit(Instruction::abc(pick(Opcode::AddF, Opcode::AddI, Opcode::Add), dst, dst, rhs)); break;
+      case BinaryOp::Sub: this->emit(Instruction::abc(pick(Opcode::SubF, Opcode::SubI, Opcode::Sub), dst, dst, rhs)); break;
+      case BinaryOp::Mul: this->emit(Instruction::abc(pick(Opcode::MulF, Opcode::MulI, Opcode::Mul), dst, dst, rhs)); break;
+      case BinaryOp::Div: this->emit(Instruction::abc(numerics ? Opcode::DivF : Opcode::Div, dst, dst, rhs)); break;
+      case BinaryOp::Mod: this->emit(Instruction::abc(floats ? Opcode::ModF : Opcode::Mod, dst, dst, rhs)); break;
+      case BinaryOp::Lt: this->emit(Instruction::abc(numerics ? Opcode::LtN : Opcode::Lt, dst, dst, rhs)); break;
+      case BinaryOp::Le: this->emit(Instruction::abc(numerics ? Opcode::LeN : Opcode::Le, dst, dst, rhs)); break;
+      case BinaryOp::Gt: this->emit(Instruction::abc(numerics ? Opcode::LtN : Opcode::Lt, dst, rhs, dst)); break;
+      case BinaryOp::Ge: this->emit(Instruction::abc(numerics ? Opcode::LeN : Opcode::Le, dst, rhs, dst)); break;
+      case BinaryOp::Eq: this->emit(Instruction::abc(numerics ? Opcode::EqN : Opcode::Eq, dst, dst, rhs)); break;
+      case BinaryOp::Ne:
+        this->emit(Instruction::abc(numerics ? Opcode::EqN : Opcode::Eq, dst, dst, rhs));
+        this->emit(Instruction::abc(this->types_ ? Opcode::NotB : Opcode::Not, dst, dst, 0));
+        break;
+      default:
+        this->fail(expr, "Unknown binary operator.");
+    }
+    this->free(rhs);
+  }
+
+  void compileCall(Call const& call, uint8_t const dst) {
+    static Name const wait = Name::of("wait");
+    if (call.callee() == wait) {
+      if (call.args().size() != 1) {
+        this->fail(call, "wait() takes exactly one argument.");
+      }
+      this->compileExpr(*call.args()[0], dst);
+      this->emit(Instruction::abc(Opcode::Wait, dst, 0, 0));
+      return;
+    }
+    std::optional<SpawnKind> const spawn = spawnKindOf(call.callee().str());
+    if (spawn.has_value() && call.args().size() != arityOf(spawn.value())) {
+      this->fail(call, fmt::format("{}() takes exactly {} arguments.", call.callee(), arityOf(spawn.value())));
+    }
+    if (call.args().size() > UINT8_MAX) {
+      this->fail(call, "Too many arguments.");
+    }
+    // Arguments are placed on the top of the registers, where the callee's frame begins.
+    uint8_t const top = this->top_;
+    uint8_t const base = this->alloc(call);
+    for (size_t i = 0; i < call.args().size(); ++i) {
+      uint8_t const r = i == 0 ? base : this->alloc(call);
+      this->compileExpr(*call.args()[i], r);
+    }
+    auto const argc = static_cast<uint8_t>(call.args().size());
+    if (spawn.has_value()) {
+      this->emit(Instruction::abc(Opcode::Spawn, base, static_cast<uint8_t>(spawn.value()), argc));
+    } else {
+      this->emit(Instruction::abc(Opcode::Native, base, this->src_.native(std::string(call.callee().str())), argc));
+    }
+    if (base != dst) {
+      this->emit(Instruction::abc(Opcode::Move, dst, base, 0));
+    }
+    this->top_ = top;
+  }
+
+private:
+  // Instructions emitted while it lives are attributed to the line of the node.
+  class LineScope final {
+  public:
+    LineScope(FunctionCompiler& compiler, Node const& node)
+    :compiler_(compiler)
+    ,saved_(std::exchange(compiler.line_, static_cast<uint32_t>(node.range().begin().line())))
+    {
+    }
+    ~LineScope() noexcept {
+      this->compiler_.line_ = this->saved_;
+    }
+  private:
+    FunctionCompiler& compiler_;
+    uint32_t const saved_;
+  };
+
+  uint8_t alloc(Node const& node) {
+    if (this->top_ == UINT8_MAX) {
+      this->fail(node, "Too many registers.");
+    }
+    uint8_t const r = this->top_++;
+    this->maxRegisters_ = std::max<uint32_t>(this->maxRegisters_, this->top_);
+    return r;
+  }
+
+  void free(uint8_t const r) {
+    if (r + 1 != this->top_) {
+      throw std::logic_error("Registers must be freed in LIFO order.");
+    }
+    this->top_--;
+  }
+
+  [[nodiscard]] Type typeOf(Node const& node) const {
+    return this->types_ ? this->types_->of(&node) : Type::Any;
+  }
+
+  // The conditional jump taken when `cond` is (not) true.
+  [[nodiscard]] Opcode branch(bool const ifTrue, Expr const& cond) const {
+    bool const boolean = this->typeOf(cond) == Type::Bool;
+    if (ifTrue) {
+      return boolean ? Opcode::JmpIfB : Opcode::JmpIf;
+    }
+    return boolean ? Opcode::JmpIfNotB : Opcode::JmpIfNot;
+  }
+
+  uint8_t lookup(Name const name, Node const& node) const {
+    for (auto it = this->locals_.rbegin(); it != this->locals_.rend(); ++it) {
+      if (it->first == name) {
+        return it->second;
+      }
+    }
+    this->fail(node, fmt::format("Undefined variable: {}", name));
+  }
+
+  void emit(Instruction const inst) {
+    this->code_.emplace_back(inst);
+    this->lines_.emplace_back(this->line_);
+  }
+
+  size_t emitJump(Opcode const op, uint8_t const a) {
+    this->emit(Instruction::asbx(op, a, 0));
+    return this->code_.size() - 1;
+  }
+
+  // Lets the jump at `at` jump to the next instruction to be emitted.
+  void patchJump(Node const& node, size_t const at) {
+    Instruction const inst = this->code_[at];
+    this->code_[at] = Instruction::asbx(inst.op(), inst.a(), this->jumpOffset(node, at, this->code_.size()));
+  }
+
+  // The sBx of a jump at `from` to `to`, which has to fit in 16 bits.
+  int32_t jumpOffset(Node const& node, size_t const from, size_t const to) const {
+    int64_t const offset = static_cast<int64_t>(to) - static_cast<int64_t>(from + 1);
+    if (offset < Instruction::kMinSBx || Instruction::kMaxSBx < offset) {
+      this->fail(node, fmt::format("Jump too far: {} instructions, at most {}. Split the function.", offset, Instruction::kMaxSBx));
+    }
+    return static_cast<int32_t>(offset);
+  }
+
+  [[noreturn]] void fail(Node const& node, std::string const& msg) const {
+    Range const& range = node.range();
+    throw std::runtime_error(fmt::format("{}:{}:{}: {}", range.filename(), range.begin().line(), range.begin().column(), msg));
+  }
+
+private:
+  Source& src_;
+  FunctionDecl const& decl_;
+  FunctionTypes const* types_; // nullptr when not specializing
+  std::vector<Instruction> code_;
+  std::vector<uint32_t> lines_;
+  std::vector<std::pair<Name, uint8_t>> locals_;
+  uint8_t top_ = 0;
+  uint32_t maxRegisters_ = 0;
+  uint32_t line_ = 0;
+};
+
+}
+
+Source Compiler::compile(Module const& module) {
+  Source src;
+  for (FunctionDecl const* decl : module.functions()) {
+    if (this->specialize_) {
+      FunctionTypes const types(*decl);
+      FunctionCompiler(src, *decl, &types).compile();
+    } else {
+      FunctionCompiler(src, *decl, nullptr).compile();
+    }
+  }
+  return src;
+}
+
+}
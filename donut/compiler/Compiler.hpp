@@ -0,0 +1,40 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <cstdint>
+#include "../vm/Source.hpp"
+
+namespace donut {
+
+class Module;
+
+// Compiles a module into a Source.
+// Every call is emitted as a Native with the callee's name, and resolved later by link().
+class Compiler final {
+public:
+  // Bump this when the generated code changes, to invalidate cached bytecode.
+  static constexpr uint32_t kVersion = 6;
+
+public:
+  // With `specialize`, arithmetic, comparisons and branches whose operand types are proven
+  // by FunctionTypes are emitted as the specialized opcodes, which skip the type checks.
+  explicit Compiler(bool specialize = true)
+  :specialize_(specialize)
+  {
+  }
+  Compiler(Compiler const&) = delete;
+  Compiler& operator=(Compiler const&) = delete;
+
+public:
+  Source compile(Module const& module);
+
+private:
+  bool specialize_;
+};
+
+}
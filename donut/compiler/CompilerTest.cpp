@@ -0,0 +1,71 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "./Compiler.hpp"
+#include "./Linker.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Module.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../vm/Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+Source compile(std::string const& content) {
+  Arena arena;
+  Module const* module = Parser(arena).parse(Stream::from("compiler.donut", content));
+  return Compiler().compile(*module);
+}
+
+// A loop whose body is `n` increments.
+std::string longLoop(size_t const n) {
+  std::string body;
+  for (size_t i = 0; i < n; ++i) {
+    body += "    a = a + 1;\n";
+  }
+  return "fn main() {\n  var a = 0;\n  var i = 0;\n  while (i < 2) {\n" + body + "    i = i + 1;\n  }\n  return a;\n}\n";
+}
+
+}
+
+TEST(DonutCompilerTest, JumpTest) {
+  Source const unit = compile(longLoop(1000));
+  auto const src = std::make_shared<Source const>(link({&unit}));
+  Clock<16> clock;
+  Machine<16> machine(clock);
+  machine.load(src);
+  uint32_t const fiber = machine.spawn("main");
+  machine.step();
+  EXPECT_EQ(2000, machine.stateOf(fiber).value().result.toNumber());
+
+  // Both the exit and the jump back would need more than 16 bits.
+  try {
+    compile(longLoop(Instruction::kMaxSBx));
+    FAIL() << "A jump too far must not be compiled.";
+  } catch (std::runtime_error const& e) {
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("Jump too far")) << e.what();
+  }
+}
+
+TEST(DonutCompilerTest, BuiltinTest) {
+  // Otherwise `ring(...)` in main would spawn bullets instead of calling it.
+  for (std::string const name : {"ring", "fan", "spread", "wait"}) {
+    SCOPED_TRACE(name);
+    try {
+      compile("fn " + name + "(a, b, c, d, e) { return a; }\nfn main() { return " + name + "(1, 2, 3, 4, 5); }\n");
+      FAIL() << "A builtin must not be redefined.";
+    } catch (std::runtime_error const& e) {
+      EXPECT_NE(std::string::npos, std::string(e.what()).find(name + " is a builtin")) << e.what();
+    }
+  }
+}
+
+}
@@ -0,0 +1,62 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include "Driver.hpp"
+#include "Compiler.hpp"
+#include "Optimizer.hpp"
+#include "Linker.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../ast/Module.hpp"
+#include "../vm/Cache.hpp"
+
+namespace donut {
+
+Driver::Driver(size_t const numWorkers, std::shared_ptr<Cache> cache, bool const optimize)
+:pool_(numWorkers)
+,arenas_(pool_.numWorkers())
+,cache_(std::move(cache))
+,optimize_(optimize)
+{
+}
+
+Source Driver::build(std::vector<std::string> const& filenames) {
+  std::vector<std::shared_ptr<Source const>> const units = this->compile(filenames);
+  std::vector<Source const*> linked;
+  linked.reserve(units.size());
+  for (auto const& unit : units) {
+    linked.emplace_back(unit.get());
+  }
+  return link(linked);
+}
+
+std::vector<std::shared_ptr<Source const>> Driver::compile(std::vector<std::string> const& filenames) {
+  std::vector<std::shared_ptr<Source const>> units(filenames.size());
+  this->pool_.run(filenames.size(), [&](size_t const worker, size_t const i) {
+    units[i] = this->compileFile(worker, filenames[i]);
+  });
+  return units;
+}
+
+std::shared_ptr<Source const> Driver::compileFile(size_t const worker, std::string const& filename) {
+  Arena& arena = this->arenas_[worker];
+  auto const compile = [this, &arena](Module const* module) -> Source {
+    if (this->optimize_) {
+      module = Optimizer(arena).optimize(*module);
+    }
+    return Compiler().compile(*module);
+  };
+  arena.clear();
+  if (this->cache_) {
+    return this->cache_->load(filename, this->optimize_ ? kOptimized : kUnoptimized, [&](std::string const& name, std::string const& content) {
+      return compile(Parser(arena).parse(Stream::from(name, content)));
+    });
+  }
+  // Large generated files are streamed.
+  return std::make_shared<Source const>(compile(Parser(arena).parseFile(filename)));
+}
+
+}
@@ -0,0 +1,50 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "../ast/Arena.hpp"
+#include "../vm/Source.hpp"
+#include "../../util/ThreadPool.hpp"
+
+namespace donut {
+
+class Cache;
+
+// Parses, optimizes and compiles all the script files of a stage concurrently, then links them into one Source.
+class Driver final {
+public:
+  Driver() = delete;
+  Driver(Driver const&) = delete;
+  Driver(Driver&&) = delete;
+  Driver& operator=(Driver const&) = delete;
+  Driver& operator=(Driver&&) = delete;
+  // Optimized and unoptimized units are cached as different variants, so the two modes can share a cache.
+  static constexpr uint32_t kUnoptimized = 0;
+  static constexpr uint32_t kOptimized = 1;
+  explicit Driver(size_t numWorkers, std::shared_ptr<Cache> cache = nullptr, bool optimize = true);
+
+public:
+  // The result is the same regardless of the number of workers.
+  Source build(std::vector<std::string> const& filenames);
+  // Compiles each file into a unit to be linked.
+  std::vector<std::shared_ptr<Source const>> compile(std::vector<std::string> const& filenames);
+  [[nodiscard]] size_t numWorkers() const { return this->pool_.numWorkers(); }
+
+private:
+  std::shared_ptr<Source const> compileFile(size_t worker, std::string const& filename);
+
+private:
+  util::ThreadPool pool_;
+  std::vector<Arena> arenas_; // one for each worker
+  std::shared_ptr<Cache> cache_;
+  bool optimize_;
+};
+
+}
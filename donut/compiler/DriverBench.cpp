@@ -0,0 +1,52 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <fmt/format.h>
+#include "../../util/Bench.hpp"
+#include "./Driver.hpp"
+
+BENCH(DonutDriverScaling) {
+  std::filesystem::path const dir = std::filesystem::temp_directory_path() / "donut-driver-bench";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::vector<std::string> files;
+  for (int i = 0; i < 64; ++i) {
+    std::string const filename = (dir / fmt::format("pattern{}.donut", i)).string();
+    std::ofstream out(filename);
+    for (int j = 0; j < 50; ++j) {
+      out << fmt::format(R"(
+fn pattern{0}_{1}(n, speed) {{
+  var i = 0;
+  while (i < n) {{
+    var angle = 360 / n * i + {1};
+    if (angle > 180 && speed < 3) {{
+      fire(angle - 360, speed * 1.5);
+    }} else {{
+      fire(angle, speed);
+    }}
+    wait(2);
+    i = i + 1;
+  }}
+}}
+)", i, j);
+    }
+    files.emplace_back(filename);
+  }
+  double base = 0;
+  for (size_t const workers : {1, 2, 4, 8, 16}) {
+    donut::Driver driver(workers);
+    double const secs = util::measure([&]() { driver.build(files); });
+    if (workers == 1) {
+      base = secs;
+    }
+    std::printf("%2zu workers: %8.3f ms  (x%.2f)\n", workers, secs * 1000, base / secs);
+  }
+  std::filesystem::remove_all(dir);
+}
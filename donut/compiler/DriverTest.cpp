@@ -0,0 +1,115 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <fmt/format.h>
+#include "./Driver.hpp"
+#include "../vm/Cache.hpp"
+#include "../../util/TempDir.hpp"
+#include "../vm/Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+bool sameSource(Source const& a, Source const& b) {
+  auto const sameBytes = [](auto const x, auto const y) {
+    return x.size_bytes() == y.size_bytes() && std::memcmp(x.data(), y.data(), x.size_bytes()) == 0;
+  };
+  return sameBytes(a.constants(), b.constants()) &&
+      sameBytes(a.code(), b.code()) &&
+      sameBytes(a.functions(), b.functions()) &&
+      sameBytes(a.natives(), b.natives()) &&
+      a.strings() == b.strings();
+}
+
+}
+
+TEST(DonutDriverTest, RunTest) {
+  Driver driver(2);
+  auto src = std::make_shared<Source>(driver.build({
+      "resources/test/stage/main.donut",
+      "resources/test/stage/util.donut",
+  }));
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<std::pair<uint32_t, double>> out;
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    out.emplace_back(clock.current(), args[0].toNumber());
+    return 0;
+  });
+  machine.load(src);
+  uint32_t const fiber = machine.spawn("main");
+  for (int i = 0; i < 40; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  std::vector<std::pair<uint32_t, double>> const expected = {
+      {1, 0}, {11, 120}, {21, 240},
+  };
+  EXPECT_EQ(expected, out);
+  EXPECT_FALSE(machine.isRunning(fiber));
+  EXPECT_EQ(126, machine.stateOf(fiber).value().result.toNumber());
+}
+
+TEST(DonutDriverTest, DeterministicTest) {
+  util::TempDir const dir("donut-driver-test");
+  std::vector<std::string> files;
+  for (int i = 0; i < 32; ++i) {
+    std::string const filename = (dir / fmt::format("file{}.donut", i)).string();
+    std::ofstream out(filename);
+    out << fmt::format("fn f{0}(x) {{ return x * {0} + f{1}(x - 1) + g(x); }}\n", i, (i + 1) % 32);
+    out << fmt::format("fn h{0}() {{ var a = {0}.5; while (a > 0) {{ a = a - 1; wait(1); }} }}\n", i);
+    files.emplace_back(filename);
+  }
+  Source const expected = Driver(1).build(files);
+  EXPECT_EQ(64, expected.functions().size());
+  EXPECT_EQ("f0", expected.str(expected.functions()[0].name));
+  EXPECT_EQ(1, expected.natives().size());
+  EXPECT_EQ("g", expected.str(expected.natives()[0]));
+  for (size_t const workers : {2, 4, 16}) {
+    EXPECT_TRUE(sameSource(expected, Driver(workers).build(files))) << workers << " workers";
+  }
+  std::reverse(files.begin(), files.end());
+  EXPECT_TRUE(sameSource(expected, Driver(4).build(files)));
+}
+
+TEST(DonutDriverTest, LinkErrorTest) {
+  util::TempDir const dir("donut-driver-error-test");
+  std::string const filename = (dir / "dup.donut").string();
+  {
+    std::ofstream out(filename);
+    out << "fn main() { return 1; }\n";
+  }
+  EXPECT_THROW(Driver(2).build({filename, "resources/test/stage/main.donut"}), std::runtime_error);
+}
+
+// Optimized and unoptimized builds sharing a cache never get each other's units.
+TEST(DonutDriverTest, CacheTest) {
+  util::TempDir const dir("donut-driver-cache-test");
+  std::string const filename = (dir / "fold.donut").string();
+  {
+    std::ofstream out(filename);
+    out << "fn main() { var a = 2 * 3 + 1; return a; }\n";
+  }
+  Source const optimized = Driver(1, nullptr, true).build({filename});
+  Source const unoptimized = Driver(1, nullptr, false).build({filename});
+  ASSERT_FALSE(sameSource(optimized, unoptimized));
+
+  auto const cache = std::make_shared<Cache>(dir / "cache", 1);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(sameSource(optimized, Driver(1, cache, true).build({filename})));
+    EXPECT_TRUE(sameSource(unoptimized, Driver(1, cache, false).build({filename})));
+  }
+  EXPECT_TRUE(std::filesystem::exists(cache->entryPathOf(filename, Driver::kOptimized)));
+  EXPECT_TRUE(std::filesystem::exists(cache->entryPathOf(filename, Driver::kUnoptimized)));
+}
+
+}
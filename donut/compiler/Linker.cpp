@@ -0,0 +1,100 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Linker.hpp"
+
+namespace donut {
+
+namespace {
+
+struct Entry final {
+  std::string_view name;
+  Name key;
+  Source const* unit;
+  Function const* function;
+};
+
+}
+
+Source link(std::vector<Source const*> const& units) {
+  std::vector<Entry> entries;
+  for (Source const* unit : units) {
+    for (Function const& f : unit->functions()) {
+      entries.emplace_back(Entry{unit->str(f.name), Name::of(unit->str(f.name)), unit, &f});
+    }
+  }
+  // Sorted by the strings, not by the ids, so that the result does not depend on the order of interning.
+  std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) { return a.name < b.name; });
+  std::unordered_map<Name, uint32_t> indices;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (!indices.emplace(entries[i].key, static_cast<uint32_t>(i)).second) {
+      throw std::runtime_error(fmt::format("Function \"{}\" is defined more than once.", entries[i].name));
+    }
+  }
+  if (entries.size() > UINT16_MAX) {
+    throw std::runtime_error("Too many functions.");
+  }
+
+  Source linked;
+  std::vector<Instruction> code;
+  for (Entry const& entry : entries) {
+    Source const& unit = *entry.unit;
+    Function const& f = *entry.function;
+    std::span<Instruction const> const unitCode = unit.code();
+    // A function ends where the next one begins.
+    uint32_t end = static_cast<uint32_t>(unitCode.size());
+    for (Function const& other : unit.functions()) {
+      if (other.entry > f.entry) {
+        end = std::min(end, other.entry);
+      }
+    }
+    code.clear();
+    std::span<uint32_t const> const lines = unit.lines().subspan(f.entry, end - f.entry);
+    for (uint32_t pc = f.entry; pc < end; ++pc) {
+      Instruction const inst = unitCode[pc];
+      switch (inst.op()) {
+        case Opcode::LoadK:
+          code.emplace_back(Instruction::abx(Opcode::LoadK, inst.a(), linked.constant(unit.constants()[inst.bx()])));
+          break;
+        case Opcode::Native: {
+          std::string_view const name = unit.str(unit.natives()[inst.b()]);
+          auto const it = indices.find(Name::of(name));
+          if (it == indices.end()) {
+            code.emplace_back(Instruction::abc(Opcode::Native, inst.a(), linked.native(std::string(name)), inst.c()));
+            break;
+          }
+          Function const& callee = *entries[it->second].function;
+          if (callee.arity != inst.c()) {
+            throw std::runtime_error(fmt::format(
+                "Function \"{}\" takes {} arguments, but called with {} in \"{}\".", name, callee.arity, inst.c(), entry.name));
+          }
+          code.emplace_back(Instruction::abx(Opcode::Call, inst.a(), static_cast<uint16_t>(it->second)));
+          break;
+        }
+        case Opcode::Call: {
+          // Already linked.
+          std::string_view const name = unit.str(unit.functions()[inst.bx()].name);
+          code.emplace_back(Instruction::abx(Opcode::Call, inst.a(), static_cast<uint16_t>(indices.at(Name::of(name)))));
+          break;
+        }
+        default:
+          code.emplace_back(inst);
+          break;
+      }
+    }
+    DebugInfo const debug{std::string(unit.str(f.file)), f.line, std::vector<uint32_t>(lines.begin(), lines.end())};
+    linked.addFunction(std::string(entry.name), f.arity, f.registers, code, debug);
+  }
+  return linked;
+}
+
+}
@@ -0,0 +1,19 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <vector>
+#include "../vm/Source.hpp"
+
+namespace donut {
+
+// Merges compiled modules into one Source.
+// Functions are ordered by name, so the result does not depend on the order of the units.
+// Natives whose name matches a function are turned into Calls.
+Source link(std::vector<Source const*> const& units);
+
+}
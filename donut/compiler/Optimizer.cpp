@@ -0,0 +1,443 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_set>
+#include "Optimizer.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Module.hpp"
+
+namespace donut {
+
+namespace {
+
+bool truthy(double const v) {
+  return v != 0.0;
+}
+
+bool isNumber(Expr const* expr) {
+  return expr->kind() == NodeKind::Number;
+}
+
+double numberOf(Expr const* expr) {
+  return static_cast<NumberLiteral const*>(expr)->value();
+}
+
+// Calls may have side effects (natives, wait()); everything else does not.
+bool isPure(Expr const* expr) {
+  switch (expr->kind()) {
+    case NodeKind::Number:
+    case NodeKind::Identifier:
+      return true;
+    case NodeKind::Unary:
+      return isPure(static_cast<Unary const*>(expr)->operand());
+    case NodeKind::Binary:
+      return isPure(static_cast<Binary const*>(expr)->lhs()) && isPure(static_cast<Binary const*>(expr)->rhs());
+    default:
+      return false;
+  }
+}
+
+size_t countNodes(Expr const* expr) {
+  switch (expr->kind()) {
+    case NodeKind::Unary:
+      return 1 + countNodes(static_cast<Unary const*>(expr)->operand());
+    case NodeKind::Binary:
+      return 1 + countNodes(static_cast<Binary const*>(expr)->lhs()) + countNodes(static_cast<Binary const*>(expr)->rhs());
+    case NodeKind::Call: {
+      size_t n = 1;
+      for (Expr const* arg : static_cast<Call const*>(expr)->args()) {
+        n += countNodes(arg);
+      }
+      return n;
+    }
+    default:
+      return 1;
+  }
+}
+
+// Visits every identifier and callee name in the expression.
+template <typename F>
+void forEachName(Expr const* expr, F&& f) {
+  switch (expr->kind()) {
+    case NodeKind::Identifier:
+      f(static_cast<Identifier const*>(expr)->name(), false);
+      break;
+    case NodeKind::Unary:
+      forEachName(static_cast<Unary const*>(expr)->operand(), f);
+      break;
+    case NodeKind::Binary:
+      forEachName(static_cast<Binary const*>(expr)->lhs(), f);
+      forEachName(static_cast<Binary const*>(expr)->rhs(), f);
+      break;
+    case NodeKind::Call:
+      f(static_cast<Call const*>(expr)->callee(), true);
+      for (Expr const* arg : static_cast<Call const*>(expr)->args()) {
+        forEachName(arg, f);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// True when control never reaches the next statement.
+bool returns(Stmt const* stmt) {
+  switch (stmt->kind()) {
+    case NodeKind::Return:
+      return true;
+    case NodeKind::Block: {
+      std::vector<Stmt*> const& stmts = static_cast<Block const*>(stmt)->stmts();
+      return !stmts.empty() && returns(stmts.back());
+    }
+    case NodeKind::If: {
+      auto const* branch = static_cast<If const*>(stmt);
+      return branch->otherwise() != nullptr && returns(branch->then()) && returns(branch->otherwise());
+    }
+    default:
+      return false;
+  }
+}
+
+void collectVariables(Stmt const* stmt, std::unordered_map<Name, int>& decls, std::unordered_set<Name>& assigned) {
+  switch (stmt->kind()) {
+    case NodeKind::Block:
+      for (Stmt const* s : static_cast<Block const*>(stmt)->stmts()) {
+        collectVariables(s, decls, assigned);
+      }
+      break;
+    case NodeKind::Var:
+      decls[static_cast<Var const*>(stmt)->name()]++;
+      break;
+    case NodeKind::Assign:
+      assigned.emplace(static_cast<Assign const*>(stmt)->name());
+      break;
+    case NodeKind::If: {
+      auto const* branch = static_cast<If const*>(stmt);
+      collectVariables(branch->then(), decls, assigned);
+      if (branch->otherwise() != nullptr) {
+        collectVariables(branch->otherwise(), decls, assigned);
+      }
+      break;
+    }
+    case NodeKind::While:
+      collectVariables(static_cast<While const*>(stmt)->body(), decls, assigned);
+      break;
+    default:
+      break;
+  }
+}
+
+class FunctionOptimizer final {
+public:
+  FunctionOptimizer(Arena& arena, std::unordered_map<Name, FunctionDecl const*> const* inlinable)
+  :arena_(arena)
+  ,inlinable_(inlinable)
+  {
+  }
+
+public:
+  FunctionDecl* run(FunctionDecl const& decl) {
+    std::unordered_set<Name> assigned;
+    collectVariables(decl.body(), this->decls_, assigned);
+    for (Name const param : decl.params()) {
+      this->decls_[param] += 2; // never propagated
+    }
+    for (Name const name : assigned) {
+      this->decls_[name] += 2;
+    }
+    Block* body = this->block(*decl.body());
+    return this->arena_.make<FunctionDecl>(Range(decl.range()), decl.name(), decl.params(), body);
+  }
+
+private:
+  Block* block(Block const& blk) {
+    size_t const numConstants = this->constants_.size();
+    std::vector<Stmt*> stmts;
+    for (Stmt const* s : blk.stmts()) {
+      Stmt* const optimized = this->stmt(*s);
+      if (optimized == nullptr) {
+        continue;
+      }
+      stmts.emplace_back(optimized);
+      if (returns(optimized)) {
+        break; // unreachable after here.
+      }
+    }
+    this->constants_.resize(numConstants);
+    return this->arena_.make<Block>(Range(blk.range()), std::move(stmts));
+  }
+
+  // Returns nullptr when the statement is removed.
+  Stmt* stmt(Stmt const& s) {
+    switch (s.kind()) {
+      case NodeKind::Block:
+        return this->block(static_cast<Block const&>(s));
+      case NodeKind::Var: {
+        auto const& var = static_cast<Var const&>(s);
+        Expr* init = this->fold(var.init(), 0);
+        if (isNumber(init) && this->decls_[var.name()] == 1) {
+          this->constants_.emplace_back(var.name(), numberOf(init));
+          return nullptr;
+        }
+        return this->arena_.make<Var>(Range(s.range()), var.name(), init);
+      }
+      case NodeKind::Assign: {
+        auto const& assign = static_cast<Assign const&>(s);
+        return this->arena_.make<Assign>(Range(s.range()), assign.name(), this->fold(assign.value(), 0));
+      }
+      case NodeKind::If: {
+        auto const& branch = static_cast<If const&>(s);
+        Expr* cond = this->fold(branch.cond(), 0);
+        if (isNumber(cond)) {
+          if (truthy(numberOf(cond))) {
+            return this->block(*branch.then());
+          }
+          return branch.otherwise() != nullptr ? this->stmt(*branch.otherwise()) : nullptr;
+        }
+        Block* then = this->block(*branch.then());
+        Stmt* otherwise = branch.otherwise() != nullptr ? this->stmt(*branch.otherwise()) : nullptr;
+        return this->arena_.make<If>(Range(s.range()), cond, then, otherwise);
+      }
+      case NodeKind::While: {
+        auto const& loop = static_cast<While const&>(s);
+        Expr* cond = this->fold(loop.cond(), 0);
+        if (isNumber(cond) && !truthy(numberOf(cond))) {
+          return nullptr;
+        }
+        return this->arena_.make<While>(Range(s.range()), cond, this->block(*loop.body()));
+      }
+      case NodeKind::Return: {
+        auto const& ret = static_cast<Return const&>(s);
+        Expr* value = ret.value() != nullptr ? this->fold(ret.value(), 0) : nullptr;
+        return this->arena_.make<Return>(Range(s.range()), value);
+      }
+      case NodeKind::ExprStmt: {
+        Expr* expr = this->fold(static_cast<ExprStmt const&>(s).expr(), 0);
+        if (isPure(expr)) {
+          return nullptr; // no side effects.
+        }
+        return this->arena_.make<ExprStmt>(Range(s.range()), expr);
+      }
+      default:
+        return nullptr;
+    }
+  }
+
+  // Returns the expression itself when nothing changed.
+  Expr* fold(Expr* expr, int const depth) {
+    switch (expr->kind()) {
+      case NodeKind::Identifier: {
+        Name const name = static_cast<Identifier const*>(expr)->name();
+        for (auto it = this->constants_.rbegin(); it != this->constants_.rend(); ++it) {
+          if (it->first == name) {
+            return this->number(expr, it->second);
+          }
+        }
+        return expr;
+      }
+      case NodeKind::Unary: {
+        auto const* unary = static_cast<Unary const*>(expr);
+        Expr* operand = this->fold(unary->operand(), depth);
+        if (isNumber(operand)) {
+          double const v = numberOf(operand);
+          return this->number(expr, unary->op() == UnaryOp::Neg ? -v : (truthy(v) ? 0.0 : 1.0));
+        }
+        if (operand == unary->operand()) {
+          return expr;
+        }
+        return this->arena_.make<Unary>(Range(expr->range()), unary->op(), operand);
+      }
+      case NodeKind::Binary:
+        return this->foldBinary(static_cast<Binary*>(expr), depth);
+      case NodeKind::Call:
+        return this->foldCall(static_cast<Call*>(expr), depth);
+      default:
+        return expr;
+    }
+  }
+
+  Expr* foldBinary(Binary* expr, int const depth) {
+    Expr* lhs = this->fold(expr->lhs(), depth);
+    Expr* rhs = this->fold(expr->rhs(), depth);
+    BinaryOp const op = expr->op();
+    if ((op == BinaryOp::And || op == BinaryOp::Or) && isNumber(lhs)) {
+      bool const t = truthy(numberOf(lhs));
+      return (op == BinaryOp::And) == t ? rhs : lhs;
+    }
+    if (isNumber(lhs) && isNumber(rhs)) {
+      double const l = numberOf(lhs);
+      double const r = numberOf(rhs);
+      switch (op) {
+        case BinaryOp::Add: return this->number(expr, l + r);
+        case BinaryOp::Sub: return this->number(expr, l - r);
+        case BinaryOp::Mul: return this->number(expr, l * r);
+        case BinaryOp::Div: return this->number(expr, l / r);
+        case BinaryOp::Mod: return this->number(expr, std::fmod(l, r));
+        case BinaryOp::Lt: return this->number(expr, l < r ? 1.0 : 0.0);
+        case BinaryOp::Le: return this->number(expr, l <= r ? 1.0 : 0.0);
+        case BinaryOp::Gt: return this->number(expr, l > r ? 1.0 : 0.0);
+        case BinaryOp::Ge: return this->number(expr, l >= r ? 1.0 : 0.0);
+        case BinaryOp::Eq: return this->number(expr, l == r ? 1.0 : 0.0);
+        case BinaryOp::Ne: return this->number(expr, l != r ? 1.0 : 0.0);
+        default: break;
+      }
+    }
+    // Identities that hold exactly in IEEE 754, including -0 and NaN.
+    if (isNumber(rhs) && numberOf(rhs) == 1.0 && (op == BinaryOp::Mul || op == BinaryOp::Div)) {
+      return lhs;
+    }
+    if (isNumber(lhs) && numberOf(lhs) == 1.0 && op == BinaryOp::Mul) {
+      return rhs;
+    }
+    if (isNumber(rhs) && numberOf(rhs) == 0.0 && !std::signbit(numberOf(rhs)) && op == BinaryOp::Sub) {
+      return lhs;
+    }
+    if (lhs == expr->lhs() && rhs == expr->rhs()) {
+      return expr;
+    }
+    return this->arena_.make<Binary>(Range(expr->range()), op, lhs, rhs);
+  }
+
+  Expr* foldCall(Call* call, int const depth) {
+    std::vector<Expr*> args;
+    bool changed = false;
+    for (Expr* arg : call->args()) {
+      args.emplace_back(this->fold(arg, depth));
+      changed |= args.back() != arg;
+    }
+    if (Expr* inlined = this->inlineCall(call, args, depth); inlined != nullptr) {
+      return inlined;
+    }
+    if (!changed) {
+      return call;
+    }
+    return this->arena_.make<Call>(Range(call->range()), call->callee(), std::move(args));
+  }
+
+  Expr* inlineCall(Call const* call, std::vector<Expr*> const& args, int const depth) {
+    if (this->inlinable_ == nullptr || depth >= Optimizer::kMaxInlineDepth) {
+      return nullptr;
+    }
+    auto const it = this->inlinable_->find(call->callee());
+    if (it == this->inlinable_->end() || it->second->params().size() != args.size()) {
+      return nullptr;
+    }
+    FunctionDecl const& callee = *it->second;
+    Expr* body = static_cast<Return const*>(callee.body()->stmts()[0])->value();
+    std::vector<std::pair<Name, Expr*>> bindings;
+    for (size_t i = 0; i < args.size(); ++i) {
+      Name const param = callee.params()[i];
+      size_t uses = 0;
+      forEachName(body, [&](Name const name, bool isCallee) {
+        uses += (!isCallee && name == param) ? 1 : 0;
+      });
+      bool const trivial = args[i]->kind() == NodeKind::Number || args[i]->kind() == NodeKind::Identifier;
+      // Arguments with side effects must be evaluated exactly once, in order.
+      if (!isPure(args[i]) || (uses > 1 && !trivial)) {
+        return nullptr;
+      }
+      bindings.emplace_back(param, args[i]);
+    }
+    return this->fold(this->substitute(body, bindings), depth + 1);
+  }
+
+  Expr* substitute(Expr* expr, std::vector<std::pair<Name, Expr*>> const& bindings) {
+    switch (expr->kind()) {
+      case NodeKind::Identifier: {
+        Name const name = static_cast<Identifier const*>(expr)->name();
+        for (auto const& [param, arg] : bindings) {
+          if (param == name) {
+            return arg;
+          }
+        }
+        return expr;
+      }
+      case NodeKind::Unary: {
+        auto const* unary = static_cast<Unary const*>(expr);
+        return this->arena_.make<Unary>(Range(expr->range()), unary->op(), this->substitute(unary->operand(), bindings));
+      }
+      case NodeKind::Binary: {
+        auto const* binary = static_cast<Binary const*>(expr);
+        return this->arena_.make<Binary>(
+            Range(expr->range()),
+            binary->op(),
+            this->substitute(binary->lhs(), bindings),
+            this->substitute(binary->rhs(), bindings));
+      }
+      case NodeKind::Call: {
+        auto const* call = static_cast<Call const*>(expr);
+        std::vector<Expr*> args;
+        for (Expr* arg : call->args()) {
+          args.emplace_back(this->substitute(arg, bindings));
+        }
+        return this->arena_.make<Call>(Range(expr->range()), call->callee(), std::move(args));
+      }
+      default:
+        return expr;
+    }
+  }
+
+  Expr* number(Expr const* from, double const v) {
+    return this->arena_.make<NumberLiteral>(Range(from->range()), v);
+  }
+
+private:
+  Arena& arena_;
+  std::unordered_map<Name, FunctionDecl const*> const* inlinable_;
+  std::unordered_map<Name, int> decls_;
+  std::vector<std::pair<Name, double>> constants_; // scoped, like the locals in Compiler
+};
+
+bool isInlinable(FunctionDecl const& decl) {
+  std::vector<Stmt*> const& stmts = decl.body()->stmts();
+  if (stmts.size() != 1 || stmts[0]->kind() != NodeKind::Return) {
+    return false;
+  }
+  Expr const* value = static_cast<Return const*>(stmts[0])->value();
+  if (value == nullptr || countNodes(value) > Optimizer::kMaxInlineNodes) {
+    return false;
+  }
+  // It must not refer anything but its parameters, nor call itself.
+  static Name const wait = Name::of("wait");
+  bool ok = true;
+  forEachName(value, [&](Name const name, bool const isCallee) {
+    if (isCallee) {
+      ok &= name != decl.name() && name != wait;
+    } else {
+      ok &= std::find(decl.params().begin(), decl.params().end(), name) != decl.params().end();
+    }
+  });
+  return ok;
+}
+
+}
+
+Optimizer::Optimizer(Arena& arena)
+:arena_(arena)
+{
+}
+
+Module* Optimizer::optimize(Module const& module) {
+  // Fold the bodies first, then inline the small ones into the others.
+  this->inlinable_.clear();
+  for (FunctionDecl const* decl : module.functions()) {
+    FunctionDecl const* folded = FunctionOptimizer(this->arena_, nullptr).run(*decl);
+    if (isInlinable(*folded)) {
+      this->inlinable_.emplace(folded->name(), folded);
+    }
+  }
+  std::vector<FunctionDecl*> functions;
+  for (FunctionDecl const* decl : module.functions()) {
+    functions.emplace_back(FunctionOptimizer(this->arena_, &this->inlinable_).run(*decl));
+  }
+  return this->arena_.make<Module>(Range(module.range()), std::move(functions));
+}
+
+}
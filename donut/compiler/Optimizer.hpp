@@ -0,0 +1,43 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "../runtime/Interner.hpp"
+
+namespace donut {
+
+class Arena;
+class Module;
+class FunctionDecl;
+
+// AST to AST optimization between Parser and Compiler:
+//  - constant folding, and propagation of constant `var`s that are never assigned
+//  - dead branch elimination
+//  - inlining of small functions of the same module (`fn f(...) { return <expr>; }`)
+// Rewritten nodes are allocated from the arena; the original tree is left untouched.
+class Optimizer final {
+public:
+  static constexpr size_t kMaxInlineNodes = 24;
+  static constexpr int kMaxInlineDepth = 4;
+
+public:
+  Optimizer() = delete;
+  Optimizer(Optimizer const&) = delete;
+  Optimizer& operator=(Optimizer const&) = delete;
+  explicit Optimizer(Arena& arena);
+
+public:
+  Module* optimize(Module const& module);
+
+private:
+  Arena& arena_;
+  std::unordered_map<Name, FunctionDecl const*> inlinable_;
+};
+
+}
@@ -0,0 +1,54 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include "../../util/Bench.hpp"
+#include "./Driver.hpp"
+#include "../vm/Machine.hpp"
+
+namespace {
+
+constexpr int kFrames = 300;
+
+// Returns the number of VM instructions executed in kFrames frames.
+uint64_t runPattern(std::string const& filename, bool const optimize, double& secs) {
+  auto src = std::make_shared<donut::Source>(donut::Driver(1, nullptr, optimize).build({filename}));
+  uint64_t executed = 0;
+  secs = util::measure([&]() {
+    donut::Clock<3600> clock;
+    donut::Machine<3600> machine(clock);
+    for (char const* name : {"emit", "aim", "log"}) {
+      machine.registerNative(name, [](donut::Box const*, uint8_t) -> donut::Box { return 0; });
+    }
+    machine.load(src);
+    machine.spawn("main");
+    for (int i = 0; i < kFrames; ++i) {
+      clock.tick();
+      machine.step();
+    }
+    executed = machine.numExecuted();
+  });
+  return executed;
+}
+
+}
+
+BENCH(DonutOptimizer) {
+  std::printf("%-8s %14s %14s %8s\n", "pattern", "insts/frame", "optimized", "time");
+  for (std::string const name : {"ring", "spiral", "aimed"}) {
+    std::string const filename = "resources/test/patterns/" + name + ".donut";
+    double plainSecs = 0;
+    double optimizedSecs = 0;
+    uint64_t const plain = runPattern(filename, false, plainSecs);
+    uint64_t const optimized = runPattern(filename, true, optimizedSecs);
+    std::printf("%-8s %14.2f %14.2f   x%.2f\n",
+        name.c_str(),
+        static_cast<double>(plain) / kFrames,
+        static_cast<double>(optimized) / kFrames,
+        plainSecs / optimizedSecs);
+  }
+}
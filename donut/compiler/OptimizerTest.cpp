@@ -0,0 +1,120 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <tuple>
+#include "./Driver.hpp"
+#include "./Optimizer.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Module.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../vm/Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+struct PatternRun final {
+  std::vector<std::tuple<uint32_t, double, double>> emitted;
+  uint64_t executed;
+};
+
+PatternRun runPattern(std::string const& filename, bool const optimize) {
+  auto src = std::make_shared<Source>(Driver(1, nullptr, optimize).build({filename}));
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  PatternRun run{};
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    run.emitted.emplace_back(clock.current(), args[0].toNumber(), args[1].toNumber());
+    return 0;
+  });
+  machine.registerNative("aim", [&](Box const*, uint8_t) -> Box {
+    return static_cast<double>(clock.current() % 360);
+  });
+  machine.registerNative("log", [](Box const*, uint8_t) -> Box {
+    return 0;
+  });
+  machine.load(src);
+  machine.spawn("main");
+  for (int i = 0; i < 300; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  run.executed = machine.numExecuted();
+  return run;
+}
+
+}
+
+TEST(DonutOptimizerTest, FoldTest) {
+  Arena arena;
+  Stream const stream = Stream::from("fold.donut", R"(
+fn f(x) {
+  var k = 2 * 3;
+  if (k > 10) {
+    x = x + 1;
+  } else {
+    return twice(x) + k;
+  }
+  return 0;
+}
+fn twice(y) {
+  return y * 2;
+}
+)");
+  Module const* module = Optimizer(arena).optimize(*Parser(arena).parse(stream));
+  FunctionDecl const* f = module->functions()[0];
+  // The var and the dead branch are gone, and the else block is left as is.
+  ASSERT_EQ(1, f->body()->stmts().size());
+  ASSERT_EQ(NodeKind::Block, f->body()->stmts()[0]->kind());
+  auto const* block = static_cast<Block const*>(f->body()->stmts()[0]);
+  ASSERT_EQ(1, block->stmts().size());
+  auto const* ret = static_cast<Return const*>(block->stmts()[0]);
+  // twice(x) + k => x * 2 + 6
+  ASSERT_EQ(NodeKind::Binary, ret->value()->kind());
+  auto const* add = static_cast<Binary const*>(ret->value());
+  EXPECT_EQ(BinaryOp::Add, add->op());
+  ASSERT_EQ(NodeKind::Binary, add->lhs()->kind());
+  EXPECT_EQ(BinaryOp::Mul, static_cast<Binary const*>(add->lhs())->op());
+  ASSERT_EQ(NodeKind::Number, add->rhs()->kind());
+  EXPECT_EQ(6, static_cast<NumberLiteral const*>(add->rhs())->value());
+}
+
+TEST(DonutOptimizerTest, PatternTest) {
+  for (std::string const name : {"ring", "spiral", "aimed"}) {
+    std::string const filename = "resources/test/patterns/" + name + ".donut";
+    PatternRun const plain = runPattern(filename, false);
+    PatternRun const optimized = runPattern(filename, true);
+    EXPECT_FALSE(plain.emitted.empty()) << name;
+    EXPECT_EQ(plain.emitted, optimized.emitted) << name;
+    EXPECT_LT(optimized.executed, plain.executed) << name;
+  }
+}
+
+TEST(DonutOptimizerTest, StageTest) {
+  std::vector<std::string> const files = {
+      "resources/test/stage/main.donut",
+      "resources/test/stage/util.donut",
+  };
+  // Calls across files are not inlined, but the result must not change either.
+  for (bool const optimize : {false, true}) {
+    auto src = std::make_shared<Source>(Driver(1, nullptr, optimize).build(files));
+    Clock<3600> clock;
+    Machine<3600> machine(clock);
+    machine.registerNative("emit", [](Box const*, uint8_t) -> Box { return 0; });
+    machine.load(src);
+    uint32_t const fiber = machine.spawn("main");
+    for (int i = 0; i < 40; ++i) {
+      clock.tick();
+      machine.step();
+    }
+    EXPECT_EQ(126, machine.stateOf(fiber).value().result.toNumber()) << optimize;
+  }
+}
+
+}
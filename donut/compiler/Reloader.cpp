@@ -0,0 +1,113 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <set>
+#include <filesystem>
+#include <stdexcept>
+#include "Reloader.hpp"
+#include "Linker.hpp"
+
+namespace donut {
+
+namespace {
+
+std::string normalize(std::string const& path) {
+  return std::filesystem::path(path).lexically_normal().string();
+}
+
+std::shared_ptr<Source const> linkAll(std::vector<std::shared_ptr<Source const>> const& units) {
+  std::vector<Source const*> linked;
+  linked.reserve(units.size());
+  for (auto const& unit : units) {
+    linked.emplace_back(unit.get());
+  }
+  return std::make_shared<Source const>(link(linked));
+}
+
+}
+
+Reloader::Reloader(std::vector<std::string> filenames, std::unique_ptr<Driver> driver, util::Logger* const log)
+:filenames_(std::move(filenames))
+,driver_(std::move(driver))
+,log_(log)
+{
+  std::set<std::string> dirs;
+  for (size_t i = 0; i < this->filenames_.size(); ++i) {
+    std::string const path = normalize(this->filenames_[i]);
+    this->indices_.emplace(path, i);
+    std::string const dir = std::filesystem::path(path).parent_path().string();
+    dirs.emplace(dir.empty() ? "." : dir);
+  }
+  this->units_ = this->driver_->compile(this->filenames_);
+  this->source_ = linkAll(this->units_);
+  for (std::string const& dir : dirs) {
+    this->watchers_.emplace_back(std::make_unique<util::Watcher>(dir, [this](std::vector<std::string> const& paths) {
+      this->rebuild(paths);
+    }));
+  }
+}
+
+Reloader::~Reloader() noexcept {
+  this->watchers_.clear();
+}
+
+std::shared_ptr<Source const> Reloader::poll() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return std::move(this->pending_);
+}
+
+std::shared_ptr<Source const> Reloader::wait(std::chrono::milliseconds const timeout) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->rebuilt_.wait_for(lock, timeout, [this]() { return this->pending_ != nullptr; });
+  return std::move(this->pending_);
+}
+
+size_t Reloader::numReloads() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->numReloads_;
+}
+
+void Reloader::rebuild(std::vector<std::string> const& paths) {
+  std::lock_guard<std::mutex> buildLock(this->buildMutex_);
+  std::vector<std::shared_ptr<Source const>> units = this->units_;
+  bool changed = false;
+  for (std::string const& path : paths) {
+    auto const it = this->indices_.find(normalize(path));
+    if (it == this->indices_.end()) {
+      continue;
+    }
+    std::string const& filename = this->filenames_[it->second];
+    try {
+      units[it->second] = this->driver_->compile({filename}).front();
+      changed = true;
+    } catch (std::exception const& e) {
+      if (this->log_) {
+        this->log_->error("[donut] Failed to reload \"{}\": {}", filename, e.what());
+      }
+    }
+  }
+  if (!changed) {
+    return;
+  }
+  std::shared_ptr<Source const> linked;
+  try {
+    linked = linkAll(units);
+  } catch (std::exception const& e) {
+    if (this->log_) {
+      this->log_->error("[donut] Failed to link the reloaded scripts: {}", e.what());
+    }
+    return;
+  }
+  this->units_ = std::move(units);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->pending_ = std::move(linked);
+    this->numReloads_++;
+  }
+  this->rebuilt_.notify_all();
+}
+
+}
@@ -0,0 +1,64 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Driver.hpp"
+#include "../vm/Source.hpp"
+#include "../../util/Logger.hpp"
+#include "../../util/Watcher.hpp"
+
+namespace donut {
+
+// Rebuilds the scripts of a stage while it runs.
+// The directories of the files are watched; a written file is recompiled alone on the watcher's thread,
+// and linked with the units of the others. The game picks the result up with poll() at a frame boundary,
+// and hands it to Machine::reload(). Files that fail to compile are reported to the logger, and skipped.
+class Reloader final {
+public:
+  Reloader() = delete;
+  Reloader(Reloader const&) = delete;
+  Reloader(Reloader&&) = delete;
+  Reloader& operator=(Reloader const&) = delete;
+  Reloader& operator=(Reloader&&) = delete;
+  Reloader(std::vector<std::string> filenames, std::unique_ptr<Driver> driver, util::Logger* log = nullptr);
+  ~Reloader() noexcept;
+
+public:
+  // The Source built first.
+  [[nodiscard]] std::shared_ptr<Source const> const& source() const { return this->source_; }
+  // The latest Source rebuilt since the last call, or nullptr.
+  [[nodiscard]] std::shared_ptr<Source const> poll();
+  // Same as poll(), but waits up to `timeout` for a rebuild to finish.
+  [[nodiscard]] std::shared_ptr<Source const> wait(std::chrono::milliseconds timeout);
+  [[nodiscard]] size_t numReloads() const;
+
+  // What the watchers call. Paths of files that are not part of the stage are ignored.
+  void rebuild(std::vector<std::string> const& paths);
+
+private:
+  std::vector<std::string> const filenames_;
+  std::unordered_map<std::string, size_t> indices_; // by normalized path
+  std::unique_ptr<Driver> const driver_;
+  util::Logger* const log_;
+  std::shared_ptr<Source const> source_;
+  std::mutex buildMutex_; // serializes the rebuilds of the watchers
+  std::vector<std::shared_ptr<Source const>> units_;
+  mutable std::mutex mutex_;
+  std::condition_variable rebuilt_;
+  std::shared_ptr<Source const> pending_;
+  size_t numReloads_ = 0;
+  std::vector<std::unique_ptr<util::Watcher>> watchers_; // destroyed first
+};
+
+}
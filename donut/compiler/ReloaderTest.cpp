@@ -0,0 +1,103 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include "./Reloader.hpp"
+#include "../vm/Machine.hpp"
+#include "../../util/TempDir.hpp"
+
+namespace donut {
+
+namespace {
+
+void write(std::filesystem::path const& filename, std::string const& content) {
+  std::ofstream out(filename);
+  out << content;
+}
+
+// Returns as soon as the watcher has rebuilt; the deadline only bounds a failing test.
+std::shared_ptr<Source const> waitForReload(Reloader& reloader) {
+  return reloader.wait(std::chrono::seconds(10));
+}
+
+struct Stage final {
+  Clock<3600> clock;
+  Machine<3600> machine{clock};
+  std::vector<double> out;
+  Stage() {
+    this->machine.registerNative("emit", [this](Box const* args, uint8_t) -> Box {
+      this->out.emplace_back(args[0].toNumber());
+      return 0;
+    });
+  }
+  // Sorted, since the fiber to run first rotates every frame.
+  std::vector<double> run(int frames) {
+    this->out.clear();
+    for (int i = 0; i < frames; ++i) {
+      this->clock.tick();
+      this->machine.step();
+    }
+    std::sort(this->out.begin(), this->out.end());
+    return this->out;
+  }
+};
+
+}
+
+TEST(DonutReloaderTest, ReloadTest) {
+  util::TempDir const tmp("donut-reloader-test");
+  std::filesystem::path const& dir = tmp.path();
+  write(dir / "main.donut", "fn main() { while (1) { emit(1); wait(2); } }\n");
+  write(dir / "other.donut", "fn other() { while (1) { emit(10); wait(2); } }\n");
+
+  Reloader reloader({(dir / "main.donut").string(), (dir / "other.donut").string()}, std::make_unique<Driver>(1));
+  Stage stage;
+  stage.machine.load(reloader.source());
+  uint32_t const main = stage.machine.spawn("main");
+  stage.machine.spawn("other");
+  EXPECT_EQ(std::vector<double>({1, 1, 10, 10}), stage.run(4));
+
+  // Only a number changed: the fibers stay where they are.
+  write(dir / "main.donut", "fn main() { while (1) { emit(2); wait(2); } }\n");
+  std::shared_ptr<Source const> src = waitForReload(reloader);
+  ASSERT_NE(nullptr, src);
+  EXPECT_EQ(nullptr, reloader.poll());
+  ReloadStats stats = stage.machine.reload(src);
+  EXPECT_EQ(2, stats.kept);
+  EXPECT_EQ(0, stats.restarted);
+  uint32_t const resumeAt = stage.machine.stateOf(main).value().resumeAt;
+  EXPECT_EQ(std::vector<double>({2, 2, 10, 10}), stage.run(4));
+  EXPECT_EQ(resumeAt + 4, stage.machine.stateOf(main).value().resumeAt);
+
+  // The history is migrated as well.
+  stage.clock.leap(2);
+  EXPECT_EQ(std::vector<double>({2, 10}), stage.run(2));
+
+  // Broken files are skipped.
+  write(dir / "main.donut", "fn main() { while (1) { emit(3) wait(2); } }\n");
+  write(dir / "other.donut", "fn other() { emit(20); wait(1); while (1) { emit(30); wait(2); } }\n");
+  src = waitForReload(reloader);
+  ASSERT_NE(nullptr, src);
+  stats = stage.machine.reload(src);
+  EXPECT_EQ(1, stats.kept);
+  EXPECT_EQ(1, stats.restarted);
+  EXPECT_EQ(std::vector<double>({2, 2, 20, 30}), stage.run(3));
+
+  write(dir / "main.donut", "fn main2() { }\n");
+  src = waitForReload(reloader);
+  ASSERT_NE(nullptr, src);
+  stats = stage.machine.reload(src);
+  EXPECT_EQ(1, stats.dropped);
+  EXPECT_FALSE(stage.machine.isRunning(main));
+  EXPECT_EQ(3, reloader.numReloads());
+}
+
+}
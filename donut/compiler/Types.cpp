@@ -0,0 +1,239 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include <vector>
+#include <utility>
+#include "Types.hpp"
+#include "../ast/Module.hpp"
+#include "../vm/Spawn.hpp"
+
+namespace donut {
+
+Box boxOf(double const v) {
+  bool const integral = v == std::trunc(v) && !(v == 0.0 && std::signbit(v));
+  if (integral && -2147483648.0 <= v && v <= 2147483647.0) {
+    return Box::integer(static_cast<int32_t>(v));
+  }
+  return Box(v);
+}
+
+Type join(Type const a, Type const b) {
+  if (a == b || b == Type::None) {
+    return a;
+  }
+  if (a == Type::None) {
+    return b;
+  }
+  if (isNumeric(a) && isNumeric(b)) {
+    return Type::Numeric;
+  }
+  return Type::Any;
+}
+
+namespace {
+
+// Arithmetic never yields anything but numbers: the VM converts the other values to numbers.
+Type arithmetic(BinaryOp const op, Type const lhs, Type const rhs) {
+  if (lhs == Type::None || rhs == Type::None) {
+    return Type::None;
+  }
+  if (op == BinaryOp::Div || lhs == Type::Num || rhs == Type::Num) {
+    return Type::Num;
+  }
+  return Type::Numeric;
+}
+
+bool isLiteralInt(Expr const* expr) {
+  return expr->kind() == NodeKind::Number && boxOf(static_cast<NumberLiteral const*>(expr)->value()).isInt();
+}
+
+class Inference final {
+public:
+  Inference(FunctionDecl const& decl, std::unordered_map<Node const*, Type>& types)
+  :decl_(decl)
+  ,types_(types)
+  {
+  }
+
+public:
+  void run() {
+    do {
+      this->changed_ = false;
+      this->scope_.clear();
+      for (Name const param : this->decl_.params()) {
+        this->scope_.emplace_back(param, nullptr);
+      }
+      this->stmt(this->decl_.body());
+    } while (this->changed_);
+  }
+
+private:
+  void stmt(Stmt const* s) {
+    switch (s->kind()) {
+      case NodeKind::Block: {
+        size_t const size = this->scope_.size();
+        for (Stmt const* child : static_cast<Block const*>(s)->stmts()) {
+          this->stmt(child);
+        }
+        this->scope_.resize(size);
+        break;
+      }
+      case NodeKind::Var: {
+        auto const* var = static_cast<Var const*>(s);
+        this->assign(var, this->expr(var->init()));
+        this->scope_.emplace_back(var->name(), var);
+        break;
+      }
+      case NodeKind::Assign: {
+        auto const* assign = static_cast<Assign const*>(s);
+        Type const t = this->expr(assign->value());
+        if (Node const* decl = this->resolve(assign->name())) {
+          this->assign(decl, t);
+        }
+        break;
+      }
+      case NodeKind::If: {
+        auto const* branch = static_cast<If const*>(s);
+        this->expr(branch->cond());
+        this->stmt(branch->then());
+        if (branch->otherwise() != nullptr) {
+          this->stmt(branch->otherwise());
+        }
+        break;
+      }
+      case NodeKind::While: {
+        auto const* loop = static_cast<While const*>(s);
+        this->expr(loop->cond());
+        this->stmt(loop->body());
+        break;
+      }
+      case NodeKind::Return:
+        if (Expr const* value = static_cast<Return const*>(s)->value()) {
+          this->expr(value);
+        }
+        break;
+      case NodeKind::ExprStmt:
+        this->expr(static_cast<ExprStmt const*>(s)->expr());
+        break;
+      default:
+        break;
+    }
+  }
+
+  Type expr(Expr const* e) {
+    Type t = Type::Any;
+    switch (e->kind()) {
+      case NodeKind::Number:
+        t = isLiteralInt(e) ? Type::Int : Type::Num;
+        break;
+      case NodeKind::Identifier: {
+        Node const* decl = this->resolve(static_cast<Identifier const*>(e)->name());
+        t = decl ? this->types_[decl] : Type::Any;
+        break;
+      }
+      case NodeKind::Unary: {
+        auto const* unary = static_cast<Unary const*>(e);
+        Type const operand = this->expr(unary->operand());
+        if (unary->op() == UnaryOp::Not) {
+          t = Type::Bool;
+        } else {
+          t = operand == Type::None ? Type::None : operand == Type::Num ? Type::Num : Type::Numeric;
+        }
+        break;
+      }
+      case NodeKind::Binary:
+        t = this->binary(static_cast<Binary const*>(e));
+        break;
+      case NodeKind::Call: {
+        static Name const wait = Name::of("wait");
+        auto const* call = static_cast<Call const*>(e);
+        std::vector<Type> args;
+        for (Expr const* arg : call->args()) {
+          args.emplace_back(this->expr(arg));
+        }
+        if (call->callee() == wait && args.size() == 1) {
+          t = args[0]; // the argument is left in the register
+        } else if (spawnKindOf(call->callee().str()).has_value()) {
+          t = Type::Int;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    this->types_[e] = t;
+    return t;
+  }
+
+  Type binary(Binary const* e) {
+    Type lhs = this->expr(e->lhs());
+    Type rhs = this->expr(e->rhs());
+    switch (e->op()) {
+      case BinaryOp::And:
+      case BinaryOp::Or:
+        return join(lhs, rhs);
+      default:
+        break;
+    }
+    // An int literal next to a double is converted to a double anyway; load it as one.
+    if (rhs == Type::Num && isLiteralInt(e->lhs())) {
+      lhs = this->types_[e->lhs()] = Type::Num;
+    }
+    if (lhs == Type::Num && isLiteralInt(e->rhs())) {
+      rhs = this->types_[e->rhs()] = Type::Num;
+    }
+    switch (e->op()) {
+      case BinaryOp::Lt:
+      case BinaryOp::Le:
+      case BinaryOp::Gt:
+      case BinaryOp::Ge:
+      case BinaryOp::Eq:
+      case BinaryOp::Ne:
+        return Type::Bool;
+      default:
+        return arithmetic(e->op(), lhs, rhs);
+    }
+  }
+
+  void assign(Node const* decl, Type const t) {
+    Type& current = this->types_[decl];
+    Type const joined = join(current, t);
+    if (joined != current) {
+      current = joined;
+      this->changed_ = true;
+    }
+  }
+
+  // nullptr for parameters and unknown names.
+  Node const* resolve(Name const name) const {
+    for (auto it = this->scope_.rbegin(); it != this->scope_.rend(); ++it) {
+      if (it->first == name) {
+        return it->second;
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  FunctionDecl const& decl_;
+  std::unordered_map<Node const*, Type>& types_;
+  std::vector<std::pair<Name, Node const*>> scope_;
+  bool changed_ = false;
+};
+
+}
+
+FunctionTypes::FunctionTypes(FunctionDecl const& decl) {
+  Inference(decl, this->types_).run();
+}
+
+Type FunctionTypes::of(Node const* const node) const {
+  auto const it = this->types_.find(node);
+  return it != this->types_.end() && it->second != Type::None ? it->second : Type::Any;
+}
+
+}
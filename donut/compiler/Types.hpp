@@ -0,0 +1,55 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+#include "../vm/Box.hpp"
+
+namespace donut {
+
+class Node;
+class FunctionDecl;
+
+// What a value is proven to be at compile time.
+enum class Type : uint8_t {
+  None,    // not known yet
+  Int,
+  Num,     // a double
+  Bool,
+  Numeric, // Int or Num, e.g. the sum of two Ints, which may overflow into a Num
+  Any,
+};
+
+// How a number literal is boxed: integral values become ints while they fit.
+[[nodiscard]] Box boxOf(double v);
+
+[[nodiscard]] Type join(Type a, Type b);
+[[nodiscard]] inline bool isNumeric(Type const t) { return t == Type::Int || t == Type::Num || t == Type::Numeric; }
+
+// Local type inference of a function, for Compiler to emit specialized instructions.
+// Parameters, calls and natives are Any; a variable has the join of everything assigned to it,
+// solved to a fixed point over the whole function (flow-insensitive).
+// Integral literals next to a Num are typed Num, since they are converted to doubles anyway.
+class FunctionTypes final {
+public:
+  FunctionTypes() = delete;
+  FunctionTypes(FunctionTypes const&) = delete;
+  FunctionTypes(FunctionTypes&&) = delete;
+  FunctionTypes& operator=(FunctionTypes const&) = delete;
+  FunctionTypes& operator=(FunctionTypes&&) = delete;
+  explicit FunctionTypes(FunctionDecl const& decl);
+
+public:
+  // Type of an expression, or of the variable a Var declares. Any for unknown nodes.
+  [[nodiscard]] Type of(Node const* node) const;
+
+private:
+  std::unordered_map<Node const*, Type> types_;
+};
+
+}
@@ -0,0 +1,65 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include "../../util/Bench.hpp"
+#include "./Compiler.hpp"
+#include "./Linker.hpp"
+#include "./Optimizer.hpp"
+#include "../ast/Arena.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../vm/Machine.hpp"
+
+namespace {
+
+constexpr int kFrames = 300;
+constexpr int kFibers = 64;
+
+std::shared_ptr<donut::Source const> compile(std::string const& filename, bool const specialize) {
+  donut::Arena arena;
+  donut::Module const* module = donut::Parser(arena).parse(donut::Stream::open(filename));
+  module = donut::Optimizer(arena).optimize(*module);
+  donut::Source const unit = donut::Compiler(specialize).compile(*module);
+  return std::make_shared<donut::Source const>(donut::link({&unit}));
+}
+
+// Returns the average seconds per frame of kFibers fibers running the pattern.
+double runPattern(std::string const& filename, bool const specialize) {
+  std::shared_ptr<donut::Source const> const src = compile(filename, specialize);
+  return util::measure([&]() {
+    donut::Clock<3600> clock;
+    donut::Machine<3600> machine(clock);
+    for (char const* name : {"emit", "aim", "log"}) {
+      machine.registerNative(name, [](donut::Box const*, uint8_t) -> donut::Box { return 0; });
+    }
+    machine.load(src);
+    for (int i = 0; i < kFibers; ++i) {
+      machine.spawn("main");
+    }
+    for (int i = 0; i < kFrames; ++i) {
+      clock.tick();
+      machine.step();
+    }
+  }) / kFrames;
+}
+
+}
+
+BENCH(DonutTypes) {
+  std::printf("%-8s %14s %14s %8s\n", "pattern", "generic", "specialized", "speedup");
+  for (std::string const name : {"ring", "spiral", "aimed", "petals"}) {
+    std::string const filename = "resources/test/patterns/" + name + ".donut";
+    double const generic = runPattern(filename, false);
+    double const specialized = runPattern(filename, true);
+    std::printf("%-8s %11.2f us %11.2f us   x%.2f\n",
+        name.c_str(),
+        generic * 1e6,
+        specialized * 1e6,
+        generic / specialized);
+  }
+}
@@ -0,0 +1,156 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include "./Types.hpp"
+#include "./Compiler.hpp"
+#include "./Linker.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Module.hpp"
+#include "../parser/Parser.hpp"
+#include "../parser/Stream.hpp"
+#include "../vm/Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+std::shared_ptr<Source const> compile(std::string const& content, bool const specialize) {
+  Arena arena;
+  Module const* module = Parser(arena).parse(Stream::from("types.donut", content));
+  Source const unit = Compiler(specialize).compile(*module);
+  return std::make_shared<Source const>(link({&unit}));
+}
+
+// Bit patterns of the values emitted by main().
+std::vector<uint64_t> run(std::shared_ptr<Source const> const& src) {
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<uint64_t> out;
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    out.emplace_back(args[0].bits());
+    return 0;
+  });
+  machine.registerNative("any", [](Box const* args, uint8_t) -> Box {
+    return args[0];
+  });
+  machine.load(src);
+  machine.spawn("main");
+  for (int i = 0; i < 4; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  return out;
+}
+
+size_t count(Source const& src, Opcode const op) {
+  return std::count_if(src.code().begin(), src.code().end(), [op](Instruction const inst) { return inst.op() == op; });
+}
+
+}
+
+TEST(DonutTypesTest, InferenceTest) {
+  Arena arena;
+  Module const* module = Parser(arena).parse(Stream::from("types.donut", R"(
+fn main(p) {
+  var i = 0;
+  var f = 0.5;
+  var b = i < 3;
+  var n = 1;
+  var a = p;
+  while (i < 10) {
+    f = f * 2;
+    n = n + 1;
+    i = i + 1;
+  }
+  var k = 2 * f;
+}
+)"));
+  FunctionDecl const* f = module->functions()[0];
+  FunctionTypes const types(*f);
+  auto const& stmts = f->body()->stmts();
+  EXPECT_EQ(Type::Numeric, types.of(stmts[0])); // i + 1 may overflow
+  EXPECT_EQ(Type::Num, types.of(stmts[1]));
+  EXPECT_EQ(Type::Bool, types.of(stmts[2]));
+  EXPECT_EQ(Type::Numeric, types.of(stmts[3]));
+  EXPECT_EQ(Type::Any, types.of(stmts[4]));
+  auto const* k = static_cast<Var const*>(stmts[6]);
+  EXPECT_EQ(Type::Num, types.of(k));
+  // The int literal is loaded as a double.
+  EXPECT_EQ(Type::Num, types.of(static_cast<Binary const*>(k->init())->lhs()));
+}
+
+TEST(DonutTypesTest, SpecializeTest) {
+  std::shared_ptr<Source const> src = compile(R"(
+fn main() {
+  var f = 0.5;
+  var i = 0;
+  while (i < 10) {
+    emit(f * 2 + i);
+    i = i + 1;
+  }
+}
+)", true);
+  EXPECT_EQ(1, count(*src, Opcode::MulF));
+  EXPECT_EQ(1, count(*src, Opcode::AddF));
+  EXPECT_EQ(1, count(*src, Opcode::LtN));
+  EXPECT_EQ(1, count(*src, Opcode::JmpIfNotB));
+  EXPECT_EQ(0, count(*src, Opcode::Mul));
+  EXPECT_EQ(0, count(*src, Opcode::Lt));
+  // i + 1 is not proven an int after the first iteration.
+  EXPECT_EQ(1, count(*src, Opcode::Add));
+}
+
+// Specialized code must give the same bits as the generic one, down to the sign of zeros.
+TEST(DonutTypesTest, SameResultTest) {
+  std::string const content = R"(
+fn main() {
+  var f = 0.5;
+  var z = -0.5 * 0;
+  var i = 2147483647;
+  var j = 0;
+  var n = -1;
+  var a = any(3);
+  emit(f + 1);
+  emit(f * 0 * -1);
+  emit(-f);
+  emit(0 * n);
+  emit(j * n);
+  emit(i + 1);
+  emit(i * 2);
+  emit(i - n);
+  emit(-j);
+  emit(7 % 3);
+  emit(-7 % 3);
+  emit(f % 0.25);
+  emit(1 / 0);
+  emit(j / j);
+  emit(z == 0);
+  emit(f < 1);
+  emit(i <= i + 1);
+  emit(!(f < 1));
+  emit(f != 0.5);
+  emit(a + f);
+  emit(a * 2);
+  emit(a < f || f);
+  emit(a && 0.5);
+  emit(z + 0);
+  emit(z);
+  emit(0 - 0);
+}
+)";
+  std::shared_ptr<Source const> const generic = compile(content, false);
+  std::shared_ptr<Source const> const specialized = compile(content, true);
+  EXPECT_EQ(run(generic), run(specialized));
+  EXPECT_LT(0, count(*specialized, Opcode::AddI));
+  EXPECT_LT(0, count(*specialized, Opcode::MulI));
+  EXPECT_LT(0, count(*specialized, Opcode::NegF));
+  EXPECT_LT(0, count(*specialized, Opcode::ModF));
+  EXPECT_LT(0, count(*specialized, Opcode::NotB));
+}
+
+}
@@ -0,0 +1,173 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Lexer.hpp"
+#include "Stream.hpp"
+
+namespace donut {
+
+namespace {
+
+bool isIdentStart(char const c) {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+}
+
+bool isDigit(char const c) {
+  return '0' <= c && c <= '9';
+}
+
+TokenKind keywordOf(std::string_view const text) {
+  if (text == "fn") { return TokenKind::Fn; }
+  if (text == "var") { return TokenKind::Var; }
+  if (text == "if") { return TokenKind::If; }
+  if (text == "else") { return TokenKind::Else; }
+  if (text == "while") { return TokenKind::While; }
+  if (text == "return") { return TokenKind::Return; }
+  return TokenKind::Identifier;
+}
+
+}
+
+Lexer::Lexer(std::string const& filename, std::string_view const src)
+:filename_(filename)
+,src_(src)
+{
+}
+
+Lexer::Lexer(std::string const& filename, Stream const& stream)
+:filename_(filename)
+,stream_(&stream)
+{
+}
+
+bool Lexer::fill(size_t const offset) {
+  if (this->stream_ == nullptr) {
+    return false;
+  }
+  // Drop what has been lexed, so the window stays around a chunk long.
+  this->window_.erase(0, this->tokenBegin_);
+  this->pos_ -= this->tokenBegin_;
+  this->tokenBegin_ = 0;
+  bool more = true;
+  while (more && this->pos_ + offset >= this->window_.size()) {
+    more = this->stream_->read(this->window_);
+  }
+  this->src_ = this->window_;
+  return more;
+}
+
+void Lexer::advance() {
+  if (this->src_[this->pos_] == '\n') {
+    this->line_++;
+    this->column_ = 1;
+  } else {
+    this->column_++;
+  }
+  this->pos_++;
+}
+
+void Lexer::skipSpacesAndComments() {
+  while (!this->atEnd()) {
+    this->tokenBegin_ = this->pos_;
+    char const c = this->peek();
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      this->advance();
+    } else if (c == '/' && this->peek(1) == '/') {
+      while (!this->atEnd() && this->peek() != '\n') {
+        this->advance();
+      }
+    } else {
+      break;
+    }
+  }
+}
+
+Token Lexer::next() {
+  this->skipSpacesAndComments();
+  this->tokenBegin_ = this->pos_;
+  size_t const line = this->line_;
+  size_t const column = this->column_;
+  auto const make = [&](TokenKind const kind) -> Token {
+    std::string_view text = this->src_.substr(this->tokenBegin_, this->pos_ - this->tokenBegin_);
+    if (this->stream_ != nullptr) {
+      // The window will be overwritten by the next chunks.
+      std::string& copy = this->texts_[this->numTokens_++ % this->texts_.size()];
+      copy.assign(text);
+      text = copy;
+    }
+    return Token{kind, text, line, column};
+  };
+  if (this->atEnd()) {
+    return make(TokenKind::End);
+  }
+  char const c = this->peek();
+  if (isIdentStart(c)) {
+    while (isIdentStart(this->peek()) || isDigit(this->peek())) {
+      this->advance();
+    }
+    return make(keywordOf(this->src_.substr(this->tokenBegin_, this->pos_ - this->tokenBegin_)));
+  }
+  if (isDigit(c) || (c == '.' && isDigit(this->peek(1)))) {
+    while (isDigit(this->peek())) {
+      this->advance();
+    }
+    if (this->peek() == '.' && isDigit(this->peek(1))) {
+      this->advance();
+      while (isDigit(this->peek())) {
+        this->advance();
+      }
+    }
+    return make(TokenKind::Number);
+  }
+  auto const one = [&](TokenKind const kind) -> Token {
+    this->advance();
+    return make(kind);
+  };
+  auto const two = [&](char const second, TokenKind const ifTwo, TokenKind const ifOne) -> Token {
+    this->advance();
+    if (this->peek() == second) {
+      this->advance();
+      return make(ifTwo);
+    }
+    return make(ifOne);
+  };
+  switch (c) {
+    case '(': return one(TokenKind::LParen);
+    case ')': return one(TokenKind::RParen);
+    case '{': return one(TokenKind::LBrace);
+    case '}': return one(TokenKind::RBrace);
+    case ',': return one(TokenKind::Comma);
+    case ';': return one(TokenKind::Semicolon);
+    case '+': return one(TokenKind::Plus);
+    case '-': return one(TokenKind::Minus);
+    case '*': return one(TokenKind::Star);
+    case '/': return one(TokenKind::Slash);
+    case '%': return one(TokenKind::Percent);
+    case '<': return two('=', TokenKind::Le, TokenKind::Lt);
+    case '>': return two('=', TokenKind::Ge, TokenKind::Gt);
+    case '=': return two('=', TokenKind::EqEq, TokenKind::Assign);
+    case '!': return two('=', TokenKind::NotEq, TokenKind::Bang);
+    case '&':
+      if (this->peek(1) == '&') {
+        this->advance();
+        return one(TokenKind::AndAnd);
+      }
+      break;
+    case '|':
+      if (this->peek(1) == '|') {
+        this->advance();
+        return one(TokenKind::OrOr);
+      }
+      break;
+    default:
+      break;
+  }
+  throw std::runtime_error(fmt::format("{}:{}:{}: Unexpected character: '{}'", this->filename_, line, column, c));
+}
+
+}
@@ -0,0 +1,102 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace donut {
+
+enum class TokenKind : uint8_t {
+  End = 0,
+  Number,
+  Identifier,
+  // keywords
+  Fn,
+  Var,
+  If,
+  Else,
+  While,
+  Return,
+  // punctuations
+  LParen,
+  RParen,
+  LBrace,
+  RBrace,
+  Comma,
+  Semicolon,
+  Assign,
+  Plus,
+  Minus,
+  Star,
+  Slash,
+  Percent,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  EqEq,
+  NotEq,
+  Bang,
+  AndAnd,
+  OrOr,
+};
+
+struct Token final {
+  TokenKind kind;
+  std::string_view text;
+  size_t line;
+  size_t column;
+};
+
+class Stream;
+
+class Lexer final {
+public:
+  Lexer() = delete;
+  Lexer(Lexer const&) = delete;
+  Lexer& operator=(Lexer const&) = delete;
+  Lexer(std::string const& filename, std::string_view src);
+  // Lexes the chunks of the stream as they are read.
+  // The text of a token is then valid only until the second next() call after it.
+  Lexer(std::string const& filename, Stream const& stream);
+
+public:
+  Token next();
+
+private:
+  void skipSpacesAndComments();
+  [[nodiscard]] char peek(size_t const offset = 0) {
+    if (this->pos_ + offset >= this->src_.size() && !this->fill(offset)) {
+      return '\0';
+    }
+    return this->src_[this->pos_ + offset];
+  }
+  [[nodiscard]] bool atEnd() {
+    return this->pos_ >= this->src_.size() && !this->fill(0);
+  }
+  // Reads chunks until the window has `offset` bytes after pos_. False at the end of the stream.
+  bool fill(size_t offset);
+  void advance();
+
+private:
+  std::string const& filename_;
+  Stream const* stream_ = nullptr;
+  std::string window_;              // of the stream, from the current token
+  std::array<std::string, 2> texts_; // of the last two tokens of the stream
+  size_t numTokens_ = 0;
+  std::string_view src_;
+  size_t tokenBegin_ = 0;
+  size_t pos_ = 0;
+  size_t line_ = 1;
+  size_t column_ = 1;
+};
+
+}
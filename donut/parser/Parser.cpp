@@ -5,15 +5,296 @@
  * Copyright 2019-, Kaede Fujisaki
  */
 
+#include <stdexcept>
+#include <filesystem>
+#include <fmt/format.h>
 #include "Parser.hpp"
+#include "Lexer.hpp"
+#include "Stream.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Module.hpp"
+
 namespace donut {
 
-Parser::Parser()
+namespace {
+
+// State of a single parse.
+class ParserImpl final {
+public:
+  // `input` is the whole source or its Stream.
+  template <typename Input>
+  ParserImpl(Arena& arena, std::string const& filename, Input const& input)
+  :arena_(arena)
+  ,filename_(filename)
+  ,lexer_(filename, input)
+  ,token_(lexer_.next())
+  {
+  }
+
+public:
+  Module* parseModule() {
+    Token const beg = this->token_;
+    std::vector<FunctionDecl*> functions;
+    while (this->token_.kind != TokenKind::End) {
+      functions.emplace_back(this->parseFunction());
+    }
+    return this->arena_.make<Module>(this->rangeFrom(beg), std::move(functions));
+  }
+
+private:
+  FunctionDecl* parseFunction() {
+    Token const beg = this->expect(TokenKind::Fn, "'fn'");
+    Name const name = Name::of(this->expect(TokenKind::Identifier, "function name").text);
+    this->expect(TokenKind::LParen, "'('");
+    std::vector<Name> params;
+    if (this->token_.kind != TokenKind::RParen) {
+      do {
+        params.emplace_back(Name::of(this->expect(TokenKind::Identifier, "parameter name").text));
+      } while (this->consume(TokenKind::Comma));
+    }
+    this->expect(TokenKind::RParen, "')'");
+    Block* body = this->parseBlock();
+    return this->arena_.make<FunctionDecl>(this->rangeFrom(beg), name, std::move(params), body);
+  }
+
+  Block* parseBlock() {
+    Token const beg = this->expect(TokenKind::LBrace, "'{'");
+    std::vector<Stmt*> stmts;
+    while (this->token_.kind != TokenKind::RBrace) {
+      if (this->token_.kind == TokenKind::End) {
+        this->fail("'}'");
+      }
+      stmts.emplace_back(this->parseStmt());
+    }
+    this->expect(TokenKind::RBrace, "'}'");
+    return this->arena_.make<Block>(this->rangeFrom(beg), std::move(stmts));
+  }
+
+  Stmt* parseStmt() {
+    Token const beg = this->token_;
+    switch (beg.kind) {
+      case TokenKind::LBrace:
+        return this->parseBlock();
+      case TokenKind::Var: {
+        this->advance();
+        Name const name = Name::of(this->expect(TokenKind::Identifier, "variable name").text);
+        this->expect(TokenKind::Assign, "'='");
+        Expr* init = this->parseExpr();
+        this->expect(TokenKind::Semicolon, "';'");
+        return this->arena_.make<Var>(this->rangeFrom(beg), name, init);
+      }
+      case TokenKind::If:
+        return this->parseIf();
+      case TokenKind::While: {
+        this->advance();
+        this->expect(TokenKind::LParen, "'('");
+        Expr* cond = this->parseExpr();
+        this->expect(TokenKind::RParen, "')'");
+        Block* body = this->parseBlock();
+        return this->arena_.make<While>(this->rangeFrom(beg), cond, body);
+      }
+      case TokenKind::Return: {
+        this->advance();
+        Expr* value = nullptr;
+        if (this->token_.kind != TokenKind::Semicolon) {
+          value = this->parseExpr();
+        }
+        this->expect(TokenKind::Semicolon, "';'");
+        return this->arena_.make<Return>(this->rangeFrom(beg), value);
+      }
+      default:
+        break;
+    }
+    Expr* expr = this->parseExpr();
+    if (this->consume(TokenKind::Assign)) {
+      if (expr->kind() != NodeKind::Identifier) {
+        throw std::runtime_error(fmt::format("{}:{}:{}: Cannot assign to this expression.", this->filename_, beg.line, beg.column));
+      }
+      Expr* value = this->parseExpr();
+      this->expect(TokenKind::Semicolon, "';'");
+      return this->arena_.make<Assign>(this->rangeFrom(beg), static_cast<Identifier*>(expr)->name(), value);
+    }
+    this->expect(TokenKind::Semicolon, "';'");
+    return this->arena_.make<ExprStmt>(this->rangeFrom(beg), expr);
+  }
+
+  If* parseIf() {
+    Token const beg = this->expect(TokenKind::If, "'if'");
+    this->expect(TokenKind::LParen, "'('");
+    Expr* cond = this->parseExpr();
+    this->expect(TokenKind::RParen, "')'");
+    Block* then = this->parseBlock();
+    Stmt* otherwise = nullptr;
+    if (this->consume(TokenKind::Else)) {
+      if (this->token_.kind == TokenKind::If) {
+        otherwise = this->parseIf();
+      } else {
+        otherwise = this->parseBlock();
+      }
+    }
+    return this->arena_.make<If>(this->rangeFrom(beg), cond, then, otherwise);
+  }
+
+private:
+  // Binary operators, from the loosest.
+  Expr* parseExpr() {
+    return this->parseBinary(0);
+  }
+
+  static int precedenceOf(TokenKind const kind) {
+    switch (kind) {
+      case TokenKind::OrOr: return 0;
+      case TokenKind::AndAnd: return 1;
+      case TokenKind::EqEq: case TokenKind::NotEq: return 2;
+      case TokenKind::Lt: case TokenKind::Le: case TokenKind::Gt: case TokenKind::Ge: return 3;
+      case TokenKind::Plus: case TokenKind::Minus: return 4;
+      case TokenKind::Star: case TokenKind::Slash: case TokenKind::Percent: return 5;
+      default: return -1;
+    }
+  }
+
+  static BinaryOp binaryOpOf(TokenKind const kind) {
+    switch (kind) {
+      case TokenKind::OrOr: return BinaryOp::Or;
+      case TokenKind::AndAnd: return BinaryOp::And;
+      case TokenKind::EqEq: return BinaryOp::Eq;
+      case TokenKind::NotEq: return BinaryOp::Ne;
+      case TokenKind::Lt: return BinaryOp::Lt;
+      case TokenKind::Le: return BinaryOp::Le;
+      case TokenKind::Gt: return BinaryOp::Gt;
+      case TokenKind::Ge: return BinaryOp::Ge;
+      case TokenKind::Plus: return BinaryOp::Add;
+      case TokenKind::Minus: return BinaryOp::Sub;
+      case TokenKind::Star: return BinaryOp::Mul;
+      case TokenKind::Slash: return BinaryOp::Div;
+      case TokenKind::Percent: return BinaryOp::Mod;
+      default: throw std::logic_error("Not a binary operator.");
+    }
+  }
+
+  Expr* parseBinary(int const minPrecedence) {
+    Token const beg = this->token_;
+    Expr* lhs = this->parseUnary();
+    for (;;) {
+      int const precedence = precedenceOf(this->token_.kind);
+      if (precedence < minPrecedence) {
+        return lhs;
+      }
+      BinaryOp const op = binaryOpOf(this->token_.kind);
+      this->advance();
+      Expr* rhs = this->parseBinary(precedence + 1);
+      lhs = this->arena_.make<Binary>(this->rangeFrom(beg), op, lhs, rhs);
+    }
+  }
+
+  Expr* parseUnary() {
+    Token const beg = this->token_;
+    if (this->consume(TokenKind::Minus)) {
+      return this->arena_.make<Unary>(this->rangeFrom(beg), UnaryOp::Neg, this->parseUnary());
+    }
+    if (this->consume(TokenKind::Bang)) {
+      return this->arena_.make<Unary>(this->rangeFrom(beg), UnaryOp::Not, this->parseUnary());
+    }
+    return this->parsePrimary();
+  }
+
+  Expr* parsePrimary() {
+    Token const beg = this->token_;
+    switch (beg.kind) {
+      case TokenKind::Number:
+        this->advance();
+        return this->arena_.make<NumberLiteral>(this->rangeFrom(beg), std::stod(std::string(beg.text)));
+      case TokenKind::Identifier: {
+        this->advance();
+        Name const name = Name::of(beg.text);
+        if (!this->consume(TokenKind::LParen)) {
+          return this->arena_.make<Identifier>(this->rangeFrom(beg), name);
+        }
+        std::vector<Expr*> args;
+        if (this->token_.kind != TokenKind::RParen) {
+          do {
+            args.emplace_back(this->parseExpr());
+          } while (this->consume(TokenKind::Comma));
+        }
+        this->expect(TokenKind::RParen, "')'");
+        return this->arena_.make<Call>(this->rangeFrom(beg), name, std::move(args));
+      }
+      case TokenKind::LParen: {
+        this->advance();
+        Expr* expr = this->parseExpr();
+        this->expect(TokenKind::RParen, "')'");
+        return expr;
+      }
+      default:
+        this->fail("expression");
+    }
+  }
+
+private:
+  void advance() {
+    this->last_ = this->token_;
+    this->token_ = this->lexer_.next();
+  }
+
+  bool consume(TokenKind const kind) {
+    if (this->token_.kind != kind) {
+      return false;
+    }
+    this->advance();
+    return true;
+  }
+
+  Token expect(TokenKind const kind, std::string_view const what) {
+    if (this->token_.kind != kind) {
+      this->fail(what);
+    }
+    Token const token = this->token_;
+    this->advance();
+    return token;
+  }
+
+  [[noreturn]] void fail(std::string_view const expected) const {
+    std::string_view const got = this->token_.kind == TokenKind::End ? "end of file" : this->token_.text;
+    throw std::runtime_error(fmt::format("{}:{}:{}: {} expected, but got \"{}\".", this->filename_, this->token_.line, this->token_.column, expected, got));
+  }
+
+  // From the beginning of `beg` to the end of the last consumed token.
+  Range rangeFrom(Token const& beg) const {
+    return Range(
+        std::string(this->filename_),
+        Position(beg.line, beg.column),
+        Position(this->last_.line, this->last_.column + this->last_.text.size()));
+  }
+
+private:
+  Arena& arena_;
+  std::string const& filename_;
+  Lexer lexer_;
+  Token token_;
+  Token last_{};
+};
+
+}
+
+Parser::Parser(Arena& arena)
+:arena_(arena)
 {
 }
 
-void Parser::parseFile() {
+Module* Parser::parse(Stream const& stream) {
+  if (stream.streamed()) {
+    return ParserImpl(this->arena_, stream.filename(), stream).parseModule();
+  }
+  return ParserImpl(this->arena_, stream.filename(), std::string_view(stream.content())).parseModule();
+}
 
+Module* Parser::parseFile(std::string const& filename) {
+  std::error_code err;
+  uintmax_t const size = std::filesystem::file_size(filename, err);
+  if (!err && size > Stream::kChunkSize) {
+    return this->parse(Stream::stream(filename));
+  }
+  return this->parse(Stream::open(filename));
 }
 
-}
\ No newline at end of file
+}
@@ -7,14 +7,31 @@
 
 #pragma once
 
+#include <string>
+
 namespace donut {
 
+class Arena;
+class Stream;
+class Module;
+
+// Parses donut scripts into ASTs allocated from the given arena.
+// A parser keeps no state between calls, so parsers with different arenas can run concurrently.
 class Parser final {
 public:
-  Parser();
+  Parser() = delete;
+  Parser(Parser const&) = delete;
+  Parser& operator=(Parser const&) = delete;
+  explicit Parser(Arena& arena);
 
 public:
-  void parseFile();
+  // A streamed Stream is consumed by the parse.
+  Module* parse(Stream const& stream);
+  // Files larger than a chunk are streamed.
+  Module* parseFile(std::string const& filename);
+
+private:
+  Arena& arena_;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,101 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+#include <filesystem>
+#include <fstream>
+#include "./Parser.hpp"
+#include "./Stream.hpp"
+#include "../ast/Arena.hpp"
+#include "../ast/Flat.hpp"
+#include "../ast/Module.hpp"
+#include "../../util/TempDir.hpp"
+
+namespace donut {
+
+TEST(DonutParserTest, ParseTest) {
+  Arena arena;
+  Module* module = Parser(arena).parse(Stream::from("test.donut", R"(
+fn angle(n, i) {
+  return 360 / n * i;
+}
+fn main() {
+  var x = -angle(4, 1) + 2 * 3;
+  if (x < 0 || !x) { x = 1; } else if (x == 3) { x = 2; }
+}
+)"));
+  ASSERT_EQ(2, module->functions().size());
+  FunctionDecl const* angle = module->functions()[0];
+  EXPECT_EQ("angle", angle->name().str());
+  EXPECT_EQ((std::vector<Name>{Name::of("n"), Name::of("i")}), angle->params());
+  EXPECT_EQ(2, angle->range().begin().line());
+
+  // (360 / n) * i
+  auto const* ret = static_cast<Return const*>(angle->body()->stmts()[0]);
+  ASSERT_EQ(NodeKind::Binary, ret->value()->kind());
+  auto const* mul = static_cast<Binary const*>(ret->value());
+  EXPECT_EQ(BinaryOp::Mul, mul->op());
+  EXPECT_EQ(BinaryOp::Div, static_cast<Binary const*>(mul->lhs())->op());
+
+  // (-angle(4, 1)) + (2 * 3)
+  auto const* var = static_cast<Var const*>(module->functions()[1]->body()->stmts()[0]);
+  EXPECT_EQ("x", var->name().str());
+  auto const* add = static_cast<Binary const*>(var->init());
+  EXPECT_EQ(BinaryOp::Add, add->op());
+  EXPECT_EQ(NodeKind::Unary, add->lhs()->kind());
+  EXPECT_EQ(BinaryOp::Mul, static_cast<Binary const*>(add->rhs())->op());
+
+  auto const* branch = static_cast<If const*>(module->functions()[1]->body()->stmts()[1]);
+  EXPECT_EQ(BinaryOp::Or, static_cast<Binary const*>(branch->cond())->op());
+  ASSERT_NE(nullptr, branch->otherwise());
+  EXPECT_EQ(NodeKind::If, branch->otherwise()->kind());
+}
+
+TEST(DonutParserTest, ErrorTest) {
+  Arena arena;
+  Parser parser(arena);
+  try {
+    parser.parse(Stream::from("broken.donut", "fn main() {\n  var = 1;\n}\n"));
+    FAIL();
+  } catch (std::runtime_error const& e) {
+    EXPECT_STREQ("broken.donut:2:7: variable name expected, but got \"=\".", e.what());
+  }
+}
+
+// Tokens that straddle chunks, of any size, are put together.
+TEST(DonutParserTest, StreamTest) {
+  for (std::string const filename : {
+      "resources/test/patterns/spiral.donut",
+      "resources/test/stage/main.donut",
+  }) {
+    Arena arena;
+    std::vector<uint8_t> const expected = FlatModule::encode(*Parser(arena).parse(Stream::open(filename)));
+    for (size_t const chunkSize : {1, 2, 3, 7, 64, 4096}) {
+      SCOPED_TRACE(fmt::format("{} by {}", filename, chunkSize));
+      Module const* module = Parser(arena).parse(Stream::stream(filename, chunkSize));
+      EXPECT_EQ(expected, FlatModule::encode(*module));
+    }
+  }
+}
+
+TEST(DonutParserTest, StreamErrorTest) {
+  util::TempDir const dir("donut-parser-test");
+  std::filesystem::path const path = dir / "parser.donut";
+  std::ofstream(path) << "fn main() {\n  // comment\n  emit(12345, 6.789);\n  var = 1;\n}\n";
+  for (size_t const chunkSize : {1, 5, 4096}) {
+    Arena arena;
+    try {
+      Parser(arena).parse(Stream::stream(path.string(), chunkSize));
+      FAIL();
+    } catch (std::runtime_error const& e) {
+      EXPECT_EQ(fmt::format("{}:4:7: variable name expected, but got \"=\".", path.string()), e.what());
+    }
+  }
+}
+
+}
@@ -5,10 +5,132 @@
  * Copyright 2020-, Kaede Fujisaki
  */
 #include "Stream.hpp"
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <fmt/format.h>
 
 namespace donut {
 
+// Double buffering: the thread fills one chunk while the other is being taken.
+class Stream::Reader final {
+public:
+  Reader() = delete;
+  Reader(Reader const&) = delete;
+  Reader(Reader&&) = delete;
+  Reader& operator=(Reader const&) = delete;
+  Reader& operator=(Reader&&) = delete;
+  Reader(std::string const& filename, size_t const chunkSize)
+  :filename_(filename)
+  ,in_(filename, std::ios::binary)
+  ,chunkSize_(chunkSize)
+  {
+    if (!this->in_) {
+      throw std::runtime_error(fmt::format("Failed to open: {}", filename));
+    }
+    this->thread_ = std::thread([this]() { this->run(); });
+  }
+  ~Reader() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->stop_ = true;
+    }
+    this->cond_.notify_all();
+    this->thread_.join();
+  }
+
+public:
+  bool read(std::string& out) {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    while (!this->done_) {
+      Chunk& chunk = this->chunks_[this->next_];
+      this->cond_.wait(lock, [&chunk]() { return chunk.full; });
+      if (!chunk.error.empty()) {
+        throw std::runtime_error(chunk.error);
+      }
+      out.append(chunk.data);
+      this->done_ = chunk.last;
+      chunk.full = false;
+      this->next_ ^= 1u;
+      this->cond_.notify_all();
+      if (!chunk.data.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Chunk final {
+    std::string data;
+    std::string error;
+    bool full = false;
+    bool last = false;
+  };
+
+  void run() {
+    for (size_t i = 0;; i ^= 1u) {
+      Chunk& chunk = this->chunks_[i];
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->cond_.wait(lock, [this, &chunk]() { return this->stop_ || !chunk.full; });
+        if (this->stop_) {
+          return;
+        }
+      }
+      // The chunk is not touched by the reader until it is full.
+      chunk.data.resize(this->chunkSize_);
+      this->in_.read(chunk.data.data(), static_cast<std::streamsize>(this->chunkSize_));
+      chunk.data.resize(static_cast<size_t>(this->in_.gcount()));
+      bool const failed = this->in_.bad();
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (failed) {
+          chunk.error = fmt::format("Failed to read: {}", this->filename_);
+        }
+        chunk.last = failed || this->in_.eof();
+        chunk.full = true;
+      }
+      this->cond_.notify_all();
+      if (chunk.last) {
+        return;
+      }
+    }
+  }
+
+private:
+  std::string const filename_;
+  std::ifstream in_;
+  size_t const chunkSize_;
+  std::array<Chunk, 2> chunks_;
+  size_t next_ = 0; // the chunk read() takes next
+  bool done_ = false;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::thread thread_;
+};
+
+Stream::Stream(std::string&& filename, std::string&& buff)
+:filename_(std::forward<std::string>(filename))
+,buff_(std::forward<std::string>(buff))
+,pos_(0)
+{
+}
+
+Stream::Stream(std::string&& filename, std::unique_ptr<Reader> reader)
+:filename_(std::forward<std::string>(filename))
+,pos_(0)
+,reader_(std::move(reader))
+{
+}
+
+Stream::~Stream() noexcept = default;
+
 Stream Stream::open(std::string filename) {
   // https://stackoverflow.com/questions/2602013/read-whole-ascii-file-into-c-stdstring
   std::ifstream f(filename);
@@ -20,4 +142,32 @@ Stream Stream::open(std::string filename) {
   return Stream(std::move(filename), std::move(buff));
 }
 
+Stream Stream::from(std::string filename, std::string content) {
+  return Stream(std::move(filename), std::move(content));
+}
+
+Stream Stream::stream(std::string filename, size_t const chunkSize) {
+  auto reader = std::make_unique<Reader>(filename, std::max<size_t>(chunkSize, 1));
+  return Stream(std::move(filename), std::move(reader));
+}
+
+std::string const& Stream::content() const {
+  if (this->reader_) {
+    throw std::logic_error(fmt::format("{} is streamed; it has no content to get at once.", this->filename_));
+  }
+  return this->buff_;
+}
+
+bool Stream::read(std::string& out) const {
+  if (this->reader_) {
+    return this->reader_->read(out);
+  }
+  if (this->pos_ > 0 || this->buff_.empty()) {
+    return false;
+  }
+  out.append(this->buff_);
+  this->pos_ = this->buff_.size();
+  return true;
+}
+
 }
@@ -7,30 +7,46 @@
 #pragma once
 
 #include <string>
+#include <memory>
 #include <cstddef>
 
 namespace donut {
 
 class Stream final {
+public:
+  static constexpr size_t kChunkSize = 1024 * 1024;
+
 public:
   Stream() = delete;
   Stream(Stream const&) = delete;
   Stream& operator=(Stream const&) = delete;
+  ~Stream() noexcept;
   static Stream open(std::string filename);
+  static Stream from(std::string filename, std::string content);
+  // Reads the file in chunks on a background thread, two chunks ahead of the reader.
+  // Only read() can be used on it, and only once through.
+  static Stream stream(std::string filename, size_t chunkSize = kChunkSize);
 private:
-  Stream(std::string&& filename, std::string&& buff)
-  :filename_(std::forward<std::string>(filename))
-  ,buff_(std::forward<std::string>(buff))
-  ,pos_(0){
-  }
+  class Reader;
+  Stream(std::string&& filename, std::string&& buff);
+  Stream(std::string&& filename, std::unique_ptr<Reader> reader);
 private:
   std::string filename_;
   std::string buff_;
-  std::size_t pos_;
+  mutable std::size_t pos_; // how far read() has gone
+  std::unique_ptr<Reader> reader_;
 public:
-  [[nodiscard]] std::string const& content() const {
-    return this->buff_;
+  [[nodiscard]] std::string const& filename() const {
+    return this->filename_;
+  }
+  // Not available for streams.
+  [[nodiscard]] std::string const& content() const;
+  [[nodiscard]] bool streamed() const {
+    return this->reader_ != nullptr;
   }
+  // Appends the next chunk to `out`. Returns false at the end.
+  // For a loaded file, the whole content is the only chunk.
+  bool read(std::string& out) const;
 };
 
 }
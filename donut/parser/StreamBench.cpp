@@ -0,0 +1,45 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <fmt/format.h>
+#include "../../util/Bench.hpp"
+#include "./Parser.hpp"
+#include "./Stream.hpp"
+#include "../ast/Arena.hpp"
+
+// A generated waypoint table of about 16MB, loaded at once vs streamed.
+BENCH(DonutStream) {
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "donut-stream-bench.donut";
+  {
+    std::ofstream out(path);
+    for (int f = 0; out.tellp() < 16 * 1024 * 1024; ++f) {
+      out << fmt::format("fn table{}() {{\n", f);
+      for (int i = 0; i < 256; ++i) {
+        out << fmt::format("  waypoint({}, {}.25, {}.5, 0.75);\n", i, i * 3 % 640, i * 7 % 480);
+      }
+      out << "}\n";
+    }
+  }
+  size_t const fileSize = std::filesystem::file_size(path);
+  donut::Arena arena;
+  double const whole = util::measure([&]() {
+    arena.clear();
+    donut::Parser(arena).parse(donut::Stream::open(path.string()));
+  });
+  double const streamed = util::measure([&]() {
+    arena.clear();
+    donut::Parser(arena).parse(donut::Stream::stream(path.string()));
+  });
+  std::printf("%-8s %10s %12s\n", "mode", "time", "buffered");
+  std::printf("%-8s %7.1f ms %9.1f MB\n", "whole", whole * 1e3, fileSize / 1048576.0);
+  // Two chunks being read, and the window of the lexer.
+  std::printf("%-8s %7.1f ms %9.1f MB\n", "stream", streamed * 1e3, 3.0 * donut::Stream::kChunkSize / 1048576.0);
+  std::filesystem::remove(path);
+}
@@ -6,7 +6,10 @@
  */
 
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
 #include "./Stream.hpp"
+#include "../../util/TempDir.hpp"
 
 namespace donut {
 
@@ -15,4 +18,35 @@ TEST(DonutStreamTest, StreamTest) {
   EXPECT_EQ(stream.content(), "OK");
 }
 
-}
\ No newline at end of file
+TEST(DonutStreamTest, ChunkTest) {
+  util::TempDir const dir("donut-stream-test");
+  std::filesystem::path const path = dir / "stream.txt";
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    content += std::to_string(i) + ",";
+  }
+  std::ofstream(path, std::ios::binary) << content;
+  for (size_t const chunkSize : {size_t(1), size_t(10), size_t(997), content.size(), content.size() + 1}) {
+    Stream const stream = Stream::stream(path.string(), chunkSize);
+    EXPECT_TRUE(stream.streamed());
+    EXPECT_THROW((void)stream.content(), std::logic_error);
+    std::string read;
+    size_t numChunks = 0;
+    while (stream.read(read)) {
+      numChunks++;
+    }
+    EXPECT_EQ(content, read);
+    EXPECT_EQ((content.size() + chunkSize - 1) / chunkSize, numChunks);
+    EXPECT_FALSE(stream.read(read));
+  }
+  {
+    // Stops the reader halfway.
+    Stream const stream = Stream::stream(path.string(), 3);
+    std::string read;
+    EXPECT_TRUE(stream.read(read));
+  }
+  std::filesystem::remove(path);
+  EXPECT_THROW(Stream::stream(path.string()), std::runtime_error);
+}
+
+}
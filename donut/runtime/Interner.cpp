@@ -0,0 +1,156 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <new>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "Interner.hpp"
+
+namespace donut {
+
+namespace {
+
+constexpr size_t kInitialCapacity = 64;
+constexpr size_t kBlockSize = 16 * 1024;
+
+uint64_t hashOf(std::string_view const str) {
+  return std::hash<std::string_view>()(str);
+}
+
+}
+
+Interner::Interner() {
+  for (Shard& shard : this->shards_) {
+    shard.tables.emplace_back(makeTable(kInitialCapacity));
+    shard.table.store(shard.tables.back().get(), std::memory_order_release);
+  }
+  this->intern("");
+}
+
+Interner& Interner::global() {
+  static Interner interner;
+  return interner;
+}
+
+uint32_t Interner::intern(std::string_view const str) {
+  uint64_t const hash = hashOf(str);
+  Shard& shard = this->shards_[shardOf(hash)];
+  if (Entry const* found = probe(*shard.table.load(std::memory_order_acquire), hash, str)) {
+    return found->id;
+  }
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  Table const* table = shard.table.load(std::memory_order_relaxed);
+  if (Entry const* found = probe(*table, hash, str)) {
+    return found->id;
+  }
+  // Keeps the load factor under 1/2, so that probes stay short.
+  if ((shard.size + 1) * 2 > table->mask + 1) {
+    Table* const grown = makeTable((table->mask + 1) * 2);
+    for (size_t i = 0; i <= table->mask; ++i) {
+      if (Entry const* e = table->slots[i].load(std::memory_order_relaxed)) {
+        put(*grown, e);
+      }
+    }
+    shard.tables.emplace_back(grown);
+    shard.table.store(grown, std::memory_order_release);
+    table = grown;
+  }
+  Entry* const entry = allocate(shard, str);
+  entry->hash = hash;
+  entry->id = this->next_.fetch_add(1, std::memory_order_relaxed);
+  // Readers who find the entry may look its id up right away.
+  this->publish(entry);
+  put(*table, entry);
+  shard.size++;
+  this->size_.fetch_add(1, std::memory_order_release);
+  return entry->id;
+}
+
+std::optional<uint32_t> Interner::find(std::string_view const str) const {
+  uint64_t const hash = hashOf(str);
+  Shard const& shard = this->shards_[shardOf(hash)];
+  // A table being outgrown still has all the entries added before; missing the new ones is a race anyway.
+  if (Entry const* found = probe(*shard.table.load(std::memory_order_acquire), hash, str)) {
+    return found->id;
+  }
+  return std::optional<uint32_t>();
+}
+
+std::string_view Interner::str(uint32_t const id) const {
+  Slot const* const chunk = (id >> kChunkBits) < kMaxChunks ? this->chunks_[id >> kChunkBits].load(std::memory_order_acquire) : nullptr;
+  if (!chunk) {
+    throw std::out_of_range("Unknown name id.");
+  }
+  Entry const* const entry = chunk[id & ((1u << kChunkBits) - 1)].load(std::memory_order_acquire);
+  if (!entry) {
+    throw std::out_of_range("Unknown name id.");
+  }
+  return entry->str();
+}
+
+Interner::Entry const* Interner::probe(Table const& table, uint64_t const hash, std::string_view const str) {
+  for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+    Entry const* const e = table.slots[i].load(std::memory_order_acquire);
+    if (!e) {
+      return nullptr;
+    }
+    if (e->hash == hash && e->str() == str) {
+      return e;
+    }
+  }
+}
+
+Interner::Table* Interner::makeTable(size_t const capacity) {
+  return new Table{capacity - 1, std::make_unique<Slot[]>(capacity)};
+}
+
+void Interner::put(Table const& table, Entry const* const entry) {
+  size_t i = entry->hash & table.mask;
+  while (table.slots[i].load(std::memory_order_relaxed)) {
+    i = (i + 1) & table.mask;
+  }
+  table.slots[i].store(entry, std::memory_order_release);
+}
+
+Interner::Entry* Interner::allocate(Shard& shard, std::string_view const str) {
+  size_t const size = (sizeof(Entry) + str.size() + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+  if (shard.left < size) {
+    size_t const blockSize = std::max(kBlockSize, size);
+    shard.blocks.emplace_back(std::make_unique<char[]>(blockSize));
+    shard.cur = shard.blocks.back().get();
+    shard.left = blockSize;
+  }
+  auto* const entry = new (shard.cur) Entry{};
+  char* const data = shard.cur + sizeof(Entry);
+  std::memcpy(data, str.data(), str.size());
+  entry->data = data;
+  entry->length = static_cast<uint32_t>(str.size());
+  shard.cur += size;
+  shard.left -= size;
+  return entry;
+}
+
+void Interner::publish(Entry const* const entry) {
+  size_t const chunk = entry->id >> kChunkBits;
+  if (chunk >= kMaxChunks) {
+    throw std::runtime_error("Too many names.");
+  }
+  Slot* slots = this->chunks_[chunk].load(std::memory_order_acquire);
+  if (!slots) {
+    std::lock_guard<std::mutex> lock(this->chunkMutex_);
+    slots = this->chunks_[chunk].load(std::memory_order_relaxed);
+    if (!slots) {
+      this->chunkBlocks_.emplace_back(std::make_unique<Slot[]>(size_t(1) << kChunkBits));
+      slots = this->chunkBlocks_.back().get();
+      this->chunks_[chunk].store(slots, std::memory_order_release);
+    }
+  }
+  slots[entry->id & ((1u << kChunkBits) - 1)].store(entry, std::memory_order_release);
+}
+
+}
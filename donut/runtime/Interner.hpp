@@ -0,0 +1,131 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <string_view>
+#include <cstdint>
+#include <fmt/format.h>
+
+namespace donut {
+
+// Maps strings to dense 32-bit ids, and back. Strings are never freed.
+// Lookups of known strings and ids take no locks: the hash tables are published with atomics,
+// and a table outgrown by its shard is kept alive for the readers still probing it.
+// Insertions lock one of the shards, chosen by the hash.
+class Interner final {
+public:
+  Interner(Interner const&) = delete;
+  Interner(Interner&&) = delete;
+  Interner& operator=(Interner const&) = delete;
+  Interner& operator=(Interner&&) = delete;
+  Interner();
+  ~Interner() noexcept = default;
+
+  // Used by Name.
+  static Interner& global();
+
+public:
+  // The id 0 is the empty string.
+  uint32_t intern(std::string_view str);
+  [[nodiscard]] std::optional<uint32_t> find(std::string_view str) const;
+  [[nodiscard]] std::string_view str(uint32_t id) const;
+  [[nodiscard]] size_t size() const { return this->size_.load(std::memory_order_acquire); }
+
+private:
+  struct Entry final {
+    uint64_t hash;
+    uint32_t id;
+    uint32_t length;
+    char const* data;
+    [[nodiscard]] std::string_view str() const { return {this->data, this->length}; }
+  };
+  using Slot = std::atomic<Entry const*>;
+  struct Table final {
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+  struct alignas(64) Shard final {
+    std::atomic<Table const*> table;
+    std::mutex mutex;
+    size_t size = 0;
+    std::vector<std::unique_ptr<Table>> tables; // the current one, and the outgrown ones
+    std::vector<std::unique_ptr<char[]>> blocks; // entries and their strings
+    char* cur = nullptr;
+    size_t left = 0;
+  };
+  static constexpr size_t kNumShards = 16;
+  static constexpr size_t kChunkBits = 12;
+  static constexpr size_t kMaxChunks = 4096; // 16M strings
+
+private:
+  static Entry const* probe(Table const& table, uint64_t hash, std::string_view str);
+  static Table* makeTable(size_t capacity);
+  static void put(Table const& table, Entry const* entry);
+  static Entry* allocate(Shard& shard, std::string_view str);
+  static size_t shardOf(uint64_t const hash) { return (hash >> 32u) % kNumShards; }
+  void publish(Entry const* entry);
+
+private:
+  std::array<Shard, kNumShards> shards_;
+  std::array<std::atomic<Slot*>, kMaxChunks> chunks_{}; // id -> entry
+  std::mutex chunkMutex_;
+  std::vector<std::unique_ptr<Slot[]>> chunkBlocks_;
+  std::atomic<uint32_t> next_ = 0;
+  std::atomic<size_t> size_ = 0;
+};
+
+// An interned string of the global Interner: identifiers compare and hash as integers.
+class Name final {
+public:
+  constexpr Name() noexcept = default;
+  [[nodiscard]] static Name of(std::string_view const str) { return Name(Interner::global().intern(str)); }
+  // Does not intern `str`, if it is not yet.
+  [[nodiscard]] static std::optional<Name> find(std::string_view const str) {
+    std::optional<uint32_t> const id = Interner::global().find(str);
+    return id.has_value() ? std::optional<Name>(Name(id.value())) : std::optional<Name>();
+  }
+
+public:
+  [[nodiscard]] constexpr uint32_t id() const noexcept { return this->id_; }
+  [[nodiscard]] std::string_view str() const { return Interner::global().str(this->id_); }
+  [[nodiscard]] constexpr bool empty() const noexcept { return this->id_ == 0; }
+  constexpr bool operator==(Name const&) const noexcept = default;
+  bool operator==(std::string_view const str) const { return this->str() == str; }
+
+private:
+  constexpr explicit Name(uint32_t const id) noexcept
+  :id_(id)
+  {
+  }
+
+private:
+  uint32_t id_ = 0;
+};
+
+}
+
+template <> struct std::hash<donut::Name> {
+  size_t operator()(donut::Name const name) const noexcept {
+    // Ids are dense; spread them over the buckets.
+    return static_cast<size_t>(name.id()) * 0x9e3779b97f4a7c15ull;
+  }
+};
+
+template <> struct fmt::formatter<donut::Name> : fmt::formatter<std::string_view> {
+  template <typename FormatContext>
+  auto format(donut::Name const& name, FormatContext& ctx) const {
+    return fmt::formatter<std::string_view>::format(name.str(), ctx);
+  }
+};
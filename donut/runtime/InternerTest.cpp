@@ -0,0 +1,94 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <unordered_set>
+#include <fmt/format.h>
+#include "./Interner.hpp"
+
+namespace donut {
+
+TEST(DonutInternerTest, InternTest) {
+  Interner interner;
+  EXPECT_EQ(0, interner.intern(""));
+  uint32_t const foo = interner.intern("foo");
+  uint32_t const bar = interner.intern("bar");
+  EXPECT_EQ(1, foo);
+  EXPECT_EQ(2, bar);
+  EXPECT_EQ(foo, interner.intern(std::string("foo")));
+  EXPECT_EQ("foo", interner.str(foo));
+  EXPECT_EQ("bar", interner.str(bar));
+  EXPECT_EQ(foo, interner.find("foo"));
+  EXPECT_FALSE(interner.find("baz").has_value());
+  EXPECT_EQ(3, interner.size());
+  EXPECT_THROW((void)interner.str(100), std::out_of_range);
+}
+
+TEST(DonutInternerTest, GrowTest) {
+  Interner interner;
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 100000; ++i) {
+    ids.emplace_back(interner.intern(fmt::format("name{}", i)));
+  }
+  for (int i = 0; i < 100000; ++i) {
+    EXPECT_EQ(i + 1, ids[i]);
+    ASSERT_EQ(fmt::format("name{}", i), interner.str(ids[i]));
+    ASSERT_EQ(ids[i], interner.find(fmt::format("name{}", i)));
+  }
+}
+
+TEST(DonutInternerTest, ConcurrentTest) {
+  Interner interner;
+  constexpr int kThreads = 8;
+  constexpr int kNames = 20000;
+  std::vector<std::vector<uint32_t>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      // Every thread interns the same names, in different orders, and reads them back at once.
+      for (int i = 0; i < kNames; ++i) {
+        int const n = (i * 7919 + t * 104729) % kNames;
+        uint32_t const id = interner.intern(fmt::format("n{}", n));
+        ids[t].emplace_back(id);
+        if (interner.str(id) != fmt::format("n{}", n)) {
+          ADD_FAILURE() << n;
+        }
+      }
+    });
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+  EXPECT_EQ(kNames + 1, interner.size());
+  std::unordered_set<uint32_t> distinct;
+  for (int i = 0; i < kNames; ++i) {
+    uint32_t const id = interner.intern(fmt::format("n{}", i));
+    EXPECT_LE(id, static_cast<uint32_t>(kNames));
+    distinct.emplace(id);
+  }
+  EXPECT_EQ(kNames, distinct.size());
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kNames; ++i) {
+      int const n = (i * 7919 + t * 104729) % kNames;
+      ASSERT_EQ(interner.intern(fmt::format("n{}", n)), ids[t][i]);
+    }
+  }
+}
+
+TEST(DonutInternerTest, NameTest) {
+  Name const a = Name::of("DonutInternerTest.a");
+  EXPECT_EQ(a, Name::of("DonutInternerTest.a"));
+  EXPECT_NE(a, Name::of("DonutInternerTest.b"));
+  EXPECT_EQ("DonutInternerTest.a", a);
+  EXPECT_EQ(a, Name::find("DonutInternerTest.a"));
+  EXPECT_FALSE(Name::find("DonutInternerTest.never").has_value());
+  EXPECT_TRUE(Name().empty());
+  EXPECT_EQ("<DonutInternerTest.a>", fmt::format("<{}>", a));
+}
+
+}
@@ -73,8 +73,15 @@ private:
   template <typename, size_t>
   friend class Value;
 
-  [[nodiscard]] uint32_t timeToWatch(SubjectiveTime const& t) const {
-    return t.leap() < this->branchHorizon_ ? t.at() : std::min(this->branches_[t.leap() - this->branchHorizon_], t.at());
+  // The latest time that is still valid for a value last modified in `lastModifiedLeap`:
+  // every leap made after that modification cuts off the entries newer than its destination.
+  [[nodiscard]] uint32_t timeToWatch(SubjectiveTime const& t, uint32_t const lastModifiedLeap) const {
+    if (lastModifiedLeap >= t.leap()) {
+      return t.at();
+    }
+    std::size_t const leap = lastModifiedLeap + 1;
+    std::size_t const idx = leap < this->branchHorizon_ ? 0 : leap - this->branchHorizon_;
+    return std::min(this->branches_[idx], t.at());
   }
 private:
   SubjectiveTime subjectiveTime_{};
@@ -127,67 +134,68 @@ public:
     return this->peek(this->clock_.subjectiveTime());
   }
 
+  // Rewrites every entry kept in the history, the abandoned futures included.
+  template <typename F> void update(F&& f) {
+    for (size_t i = this->beg_; i < this->end_; ++i) {
+      f(std::get<1>(this->values_[i % length]));
+    }
+  }
+
 private:
+  // beg_ and end_ are logical indices; the entry of index i lives in values_[i % length].
   Value<Type, length>& set(Type&& v) {
-    SubjectiveTime const t = clock_.subjectiveTime();
-    auto& last = values_[end_-1];
-    if (beg_ != end_ && std::get<0>(last) == t.at() && lastModifiedLeap_ == t.leap()) {
-      std::get<1>(last) = std::forward<Type>(v);
-    } else {
-      auto const idx = std::get<1>(this->findEntry(t));
-      end_ = idx + 1;
-      values_[idx] = std::make_tuple(t.at(), std::forward<Type>(v));
-      if((end_+1)%length == beg_) {
-        beg_++;
-      }
+    SubjectiveTime const& t = clock_.subjectiveTime();
+    if (this->lastModifiedLeap_ != t.leap()) {
+      // drop the entries that belong to the abandoned future.
+      this->end_ = this->findEntry(t);
+      this->lastModifiedLeap_ = t.leap();
+    }
+    if (beg_ != end_ && std::get<0>(values_[(end_ - 1) % length]) == t.at()) {
+      std::get<1>(values_[(end_ - 1) % length]) = std::forward<Type>(v);
+      return *this;
     }
-    this->lastModifiedLeap_ = t.leap();
+    if ((end_ - beg_) == length) {
+      beg_++;
+    }
+    values_[end_ % length] = std::make_tuple(t.at(), std::forward<Type>(v));
+    end_++;
     return *this;
   }
 
   Optional<Type> peek(SubjectiveTime const& t) {
-    auto& last = values_[end_-1];
-    if (beg_ != end_ && std::get<0>(last) == t.at() && lastModifiedLeap_ == t.leap()) {
-      return Optional<Type>(std::get<1>(last));
-    } else {
-      auto const idx = std::get<0>(this->findEntry(t));
-      if (idx == end_) {
-        return Optional<Type>();
-      }
-      return Optional<Type>(std::get<1>(values_[idx]));
+    size_t const idx = this->findEntry(t);
+    if (idx == beg_) {
+      return Optional<Type>();
     }
+    return Optional<Type>(std::get<1>(values_[(idx - 1) % length]));
   }
 
   Optional<Type const> peek(SubjectiveTime const& t) const {
-    auto const& last = values_[end_-1];
-    if (beg_ != end_ && std::get<0>(last) == t.at() && lastModifiedLeap_ == t.leap()) {
-      return Optional<Type const>(std::get<1>(last));
-    } else {
-      auto const idx = std::get<0>(this->findEntry(t));
-      if (idx == end_) {
-        return Optional<Type const>();
-      }
-      return Optional<Type const>(std::get<1>(values_[idx]));
+    size_t const idx = this->findEntry(t);
+    if (idx == beg_) {
+      return Optional<Type const>();
     }
+    return Optional<Type const>(std::get<1>(values_[(idx - 1) % length]));
   }
 
-  [[nodiscard]] std::tuple<size_t, size_t> findEntry(SubjectiveTime const& subjectiveTime) const {
+  // returns the index of the first entry newer than the given time.
+  [[nodiscard]] size_t findEntry(SubjectiveTime const& subjectiveTime) const {
+    uint32_t const t = clock_.timeToWatch(subjectiveTime, this->lastModifiedLeap_);
+    if (beg_ != end_ && std::get<0>(values_[(end_ - 1) % length]) <= t) {
+      return end_;
+    }
     size_t beg = beg_;
     size_t end = end_;
-    if(beg > end) {
-      end = end + length;
-    }
-    uint32_t const t = clock_.timeToWatch(subjectiveTime);
-    while((end-beg) > 1) {
+    while(beg < end) {
       size_t mid = beg + (end-beg)/2;
       uint32_t const midTime = std::get<0>(values_[mid % length]);
-      if (t <= midTime) {
+      if (t < midTime) {
         end = mid;
       } else {
-        beg = mid;
+        beg = mid + 1;
       }
     }
-    return std::make_tuple(beg, end);
+    return beg;
   }
 
 private:
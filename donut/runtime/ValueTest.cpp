@@ -28,4 +28,35 @@ TEST(DonutValueTest, SimpleTest) {
   EXPECT_EQ(3, value.get().value());
 }
 
+TEST(DonutValueTest, LeapAfterManyTicksTest) {
+  Clock<3600> clock;
+  auto value = clock.newValue<int>();
+  for(int i = 0; i < 6; ++i) {
+    value = int(i);
+    clock.tick();
+  }
+  EXPECT_EQ(5, value.get().value());
+  clock.leap(2);
+  EXPECT_EQ(2, value.get().value());
+  value = 100;
+  clock.tick();
+  EXPECT_EQ(100, value.get().value());
+  clock.leap(1);
+  EXPECT_EQ(1, value.get().value());
+}
+
+TEST(DonutValueTest, RingBufferTest) {
+  Clock<16> clock;
+  auto value = clock.newValue<int>();
+  for(int i = 0; i < 100; ++i) {
+    value = int(i);
+    clock.tick();
+  }
+  EXPECT_EQ(99, value.get().value());
+  clock.leap(90);
+  EXPECT_EQ(90, value.get().value());
+  clock.leap(10);
+  EXPECT_FALSE(value.get().has_value());
+}
+
 }
@@ -0,0 +1,196 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+namespace donut {
+
+// A script value in 64 bits (NaN-boxing).
+// Doubles are stored as they are, with every NaN turned into the positive quiet NaN.
+// The other types live in the negative quiet NaN space:
+//
+//   | 1 | 11111111111 | 1 | tag(3) | unused(16) | payload(32) |
+//
+// so a register file or a constant pool is a flat array of 64-bit words, and numbers need no tag checks to be stored.
+class Box final {
+public:
+  enum class Type : uint8_t {
+    Number = 0,
+    Nil = 1,
+    Bool = 2,
+    Int = 3,
+    String = 4, // interned string id
+    Object = 5, // handle of a host object
+  };
+
+private:
+  static constexpr uint64_t kTagged = 0xfff8000000000000ull;
+  static constexpr uint64_t kCanonicalNaN = 0x7ff8000000000000ull;
+  static constexpr int kTagShift = 48;
+
+public:
+  constexpr Box() noexcept = default;
+  // Implicit, so that natives can simply return numbers.
+  Box(double const v) noexcept { // NOLINT(google-explicit-constructor)
+    if (v != v) {
+      this->bits_ = kCanonicalNaN;
+    } else {
+      std::memcpy(&this->bits_, &v, sizeof(v));
+    }
+  }
+
+  [[nodiscard]] static constexpr Box nil() noexcept { return Box(tagged(Type::Nil, 0)); }
+  [[nodiscard]] static constexpr Box boolean(bool const v) noexcept { return Box(tagged(Type::Bool, v ? 1u : 0u)); }
+  [[nodiscard]] static constexpr Box integer(int32_t const v) noexcept { return Box(tagged(Type::Int, static_cast<uint32_t>(v))); }
+  [[nodiscard]] static constexpr Box string(uint32_t const id) noexcept { return Box(tagged(Type::String, id)); }
+  [[nodiscard]] static constexpr Box object(uint32_t const handle) noexcept { return Box(tagged(Type::Object, handle)); }
+  [[nodiscard]] static constexpr Box fromBits(uint64_t const bits) noexcept { return Box(bits); }
+
+public:
+  [[nodiscard]] constexpr uint64_t bits() const noexcept { return this->bits_; }
+  [[nodiscard]] constexpr bool isNumber() const noexcept { return (this->bits_ & kTagged) != kTagged; }
+  [[nodiscard]] constexpr Type type() const noexcept {
+    return this->isNumber() ? Type::Number : static_cast<Type>((this->bits_ >> kTagShift) & 0x7u);
+  }
+  [[nodiscard]] constexpr bool isNil() const noexcept { return this->bits_ == tagged(Type::Nil, 0); }
+  [[nodiscard]] constexpr bool isInt() const noexcept { return this->type() == Type::Int; }
+  [[nodiscard]] constexpr bool isBool() const noexcept { return this->type() == Type::Bool; }
+  [[nodiscard]] constexpr bool isNumeric() const noexcept { return this->isNumber() || this->isInt(); }
+
+  [[nodiscard]] double asNumber() const noexcept {
+    double v;
+    std::memcpy(&v, &this->bits_, sizeof(v));
+    return v;
+  }
+  [[nodiscard]] constexpr int32_t asInt() const noexcept { return static_cast<int32_t>(this->payload()); }
+  [[nodiscard]] constexpr bool asBool() const noexcept { return this->payload() != 0; }
+  [[nodiscard]] constexpr uint32_t payload() const noexcept { return static_cast<uint32_t>(this->bits_); }
+
+  // Numbers and ints as they are; true is 1, and everything else is 0.
+  [[nodiscard]] double toNumber() const noexcept {
+    if (this->isNumber()) {
+      return this->asNumber();
+    }
+    switch (this->type()) {
+      case Type::Int: return this->asInt();
+      case Type::Bool: return this->asBool() ? 1.0 : 0.0;
+      default: return 0.0;
+    }
+  }
+  // Faster than toNumber(), for values the compiler has proven to be numbers or ints.
+  [[nodiscard]] double numeric() const noexcept {
+    return this->isNumber() ? this->asNumber() : static_cast<double>(this->asInt());
+  }
+  // nil, false and zeros are false.
+  [[nodiscard]] bool truthy() const noexcept {
+    if (this->isNumber()) {
+      return this->asNumber() != 0.0;
+    }
+    switch (this->type()) {
+      case Type::Nil: return false;
+      case Type::Bool:
+      case Type::Int: return this->payload() != 0;
+      default: return true;
+    }
+  }
+
+public:
+  // Arithmetic of the VM: int op int stays int unless it overflows; `/` always gives a number.
+  [[nodiscard]] static Box add(Box const a, Box const b) noexcept {
+    if (a.isNumber() && b.isNumber()) {
+      return Box(a.asNumber() + b.asNumber());
+    }
+    if (a.isInt() && b.isInt()) {
+      return fromInt64(int64_t(a.asInt()) + b.asInt());
+    }
+    return Box(a.toNumber() + b.toNumber());
+  }
+  [[nodiscard]] static Box sub(Box const a, Box const b) noexcept {
+    if (a.isNumber() && b.isNumber()) {
+      return Box(a.asNumber() - b.asNumber());
+    }
+    if (a.isInt() && b.isInt()) {
+      return fromInt64(int64_t(a.asInt()) - b.asInt());
+    }
+    return Box(a.toNumber() - b.toNumber());
+  }
+  [[nodiscard]] static Box mul(Box const a, Box const b) noexcept {
+    if (a.isNumber() && b.isNumber()) {
+      return Box(a.asNumber() * b.asNumber());
+    }
+    if (a.isInt() && b.isInt() && a.asInt() != 0 && b.asInt() != 0) { // 0 * -1 must be -0.0
+      return fromInt64(int64_t(a.asInt()) * b.asInt());
+    }
+    return Box(a.toNumber() * b.toNumber());
+  }
+  [[nodiscard]] static Box div(Box const a, Box const b) noexcept {
+    return Box(a.toNumber() / b.toNumber());
+  }
+  [[nodiscard]] static Box mod(Box const a, Box const b) noexcept {
+    if (a.isInt() && b.isInt() && b.asInt() != 0 && a.asInt() >= 0 && b.asInt() != -1) {
+      return Box::integer(a.asInt() % b.asInt()); // fmod of a negative zero result is -0.0
+    }
+    return Box(std::fmod(a.toNumber(), b.toNumber()));
+  }
+  [[nodiscard]] static Box neg(Box const a) noexcept {
+    if (a.isInt() && a.asInt() != 0) {
+      return fromInt64(-int64_t(a.asInt()));
+    }
+    return Box(-a.toNumber());
+  }
+  [[nodiscard]] static bool lt(Box const a, Box const b) noexcept {
+    if (a.isNumber() && b.isNumber()) {
+      return a.asNumber() < b.asNumber();
+    }
+    if (a.isInt() && b.isInt()) {
+      return a.asInt() < b.asInt();
+    }
+    return a.toNumber() < b.toNumber();
+  }
+  [[nodiscard]] static bool le(Box const a, Box const b) noexcept {
+    if (a.isNumber() && b.isNumber()) {
+      return a.asNumber() <= b.asNumber();
+    }
+    if (a.isInt() && b.isInt()) {
+      return a.asInt() <= b.asInt();
+    }
+    return a.toNumber() <= b.toNumber();
+  }
+  // An int, or a number when it does not fit.
+  [[nodiscard]] static Box fromInt64(int64_t const v) noexcept {
+    if (v < std::numeric_limits<int32_t>::min() || std::numeric_limits<int32_t>::max() < v) {
+      return Box(static_cast<double>(v));
+    }
+    return Box::integer(static_cast<int32_t>(v));
+  }
+  // Numbers compare by value (1 == 1.0), the others by identity.
+  [[nodiscard]] static bool eq(Box const a, Box const b) noexcept {
+    if (a.isNumeric() && b.isNumeric()) {
+      return a.toNumber() == b.toNumber();
+    }
+    return a.bits_ == b.bits_;
+  }
+
+private:
+  constexpr explicit Box(uint64_t const bits) noexcept
+  :bits_(bits)
+  {
+  }
+  [[nodiscard]] static constexpr uint64_t tagged(Type const type, uint32_t const payload) noexcept {
+    return kTagged | (uint64_t(static_cast<uint8_t>(type)) << kTagShift) | payload;
+  }
+
+private:
+  uint64_t bits_ = 0;
+};
+static_assert(sizeof(Box) == sizeof(uint64_t));
+
+}
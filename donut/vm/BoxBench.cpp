@@ -0,0 +1,90 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <variant>
+#include <vector>
+#include "../../util/Bench.hpp"
+#include "./Box.hpp"
+
+namespace {
+
+// What a tagged union of the same types would look like.
+using Variant = std::variant<std::monostate, bool, int32_t, double, uint32_t>;
+
+double toNumber(Variant const& v) {
+  switch (v.index()) {
+    case 1: return std::get<bool>(v) ? 1.0 : 0.0;
+    case 2: return std::get<int32_t>(v);
+    case 3: return std::get<double>(v);
+    default: return 0.0;
+  }
+}
+
+Variant add(Variant const& a, Variant const& b) {
+  if (a.index() == 3 && b.index() == 3) {
+    return std::get<double>(a) + std::get<double>(b);
+  }
+  if (a.index() == 2 && b.index() == 2) {
+    int64_t const v = int64_t(std::get<int32_t>(a)) + std::get<int32_t>(b);
+    if (v < INT32_MIN || INT32_MAX < v) {
+      return static_cast<double>(v);
+    }
+    return static_cast<int32_t>(v);
+  }
+  return toNumber(a) + toNumber(b);
+}
+
+Variant mul(Variant const& a, Variant const& b) {
+  if (a.index() == 3 && b.index() == 3) {
+    return std::get<double>(a) * std::get<double>(b);
+  }
+  return toNumber(a) * toNumber(b);
+}
+
+bool lt(Variant const& a, Variant const& b) {
+  return toNumber(a) < toNumber(b);
+}
+
+constexpr size_t kRegisters = 4096;
+
+}
+
+// A register-file sweep like the one of the VM: r[i] = r[i] * k + r[i - 1], and a compare.
+BENCH(DonutBoxArithmetic) {
+  std::vector<donut::Box> boxes(kRegisters);
+  std::vector<Variant> variants(kRegisters);
+  for (size_t i = 0; i < kRegisters; ++i) {
+    if (i % 4 == 0) {
+      boxes[i] = donut::Box::integer(static_cast<int32_t>(i));
+      variants[i] = static_cast<int32_t>(i);
+    } else {
+      boxes[i] = donut::Box(static_cast<double>(i) * 0.5);
+      variants[i] = static_cast<double>(i) * 0.5;
+    }
+  }
+  [[maybe_unused]] volatile size_t sink = 0;
+  size_t count = 0;
+  double const boxSecs = util::measure([&]() {
+    donut::Box const k(0.5);
+    for (size_t i = 1; i < kRegisters; ++i) {
+      boxes[i] = donut::Box::add(donut::Box::mul(boxes[i], k), boxes[i - 1]);
+      count += donut::Box::lt(boxes[i], k) ? 1 : 0;
+    }
+  });
+  double const variantSecs = util::measure([&]() {
+    Variant const k(0.5);
+    for (size_t i = 1; i < kRegisters; ++i) {
+      variants[i] = add(mul(variants[i], k), variants[i - 1]);
+      count += lt(variants[i], k) ? 1 : 0;
+    }
+  });
+  std::printf("Box     %6.2f ns/op (%zu bytes)\n", boxSecs * 1e9 / kRegisters, sizeof(donut::Box));
+  std::printf("variant %6.2f ns/op (%zu bytes)\n", variantSecs * 1e9 / kRegisters, sizeof(Variant));
+  sink = count;
+}
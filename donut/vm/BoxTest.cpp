@@ -0,0 +1,107 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include "./Box.hpp"
+
+namespace donut {
+
+TEST(DonutBoxTest, EncodingTest) {
+  for (double const v : {0.0, -0.0, 1.5, -3.25, 1e300, -1e-300, std::numeric_limits<double>::infinity(),
+                         -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::denorm_min()}) {
+    Box const box(v);
+    ASSERT_TRUE(box.isNumber()) << v;
+    EXPECT_EQ(Box::Type::Number, box.type());
+    EXPECT_EQ(std::signbit(v), std::signbit(box.asNumber()));
+    EXPECT_EQ(v, box.asNumber());
+    EXPECT_EQ(box.bits(), Box::fromBits(box.bits()).bits());
+  }
+  EXPECT_EQ(Box::Type::Nil, Box::nil().type());
+  EXPECT_EQ(Box::Type::Bool, Box::boolean(true).type());
+  EXPECT_TRUE(Box::boolean(true).asBool());
+  EXPECT_FALSE(Box::boolean(false).asBool());
+  for (int32_t const v : {0, 1, -1, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()}) {
+    Box const box = Box::integer(v);
+    ASSERT_FALSE(box.isNumber()) << v;
+    EXPECT_EQ(Box::Type::Int, box.type());
+    EXPECT_EQ(v, box.asInt());
+    EXPECT_EQ(v, box.toNumber());
+  }
+  EXPECT_EQ(Box::Type::String, Box::string(0xffffffffu).type());
+  EXPECT_EQ(0xffffffffu, Box::string(0xffffffffu).payload());
+  EXPECT_EQ(Box::Type::Object, Box::object(42).type());
+  EXPECT_EQ(42u, Box::object(42).payload());
+}
+
+TEST(DonutBoxTest, NaNTest) {
+  // NaNs with any sign or payload must not be mistaken for tagged values.
+  uint64_t const negativeNaN = 0xfff8000000000000ull | (uint64_t(3) << 48) | 7u;
+  double v;
+  std::memcpy(&v, &negativeNaN, sizeof(v));
+  Box const box(v);
+  EXPECT_TRUE(box.isNumber());
+  EXPECT_TRUE(std::isnan(box.asNumber()));
+  EXPECT_EQ(Box(std::numeric_limits<double>::quiet_NaN()).bits(), box.bits());
+  EXPECT_TRUE(Box::div(Box(0.0), Box(0.0)).isNumber());
+  EXPECT_FALSE(Box::eq(box, box));
+  EXPECT_TRUE(box.truthy());
+}
+
+TEST(DonutBoxTest, TruthyTest) {
+  EXPECT_FALSE(Box::nil().truthy());
+  EXPECT_FALSE(Box::boolean(false).truthy());
+  EXPECT_FALSE(Box::integer(0).truthy());
+  EXPECT_FALSE(Box(0.0).truthy());
+  EXPECT_FALSE(Box(-0.0).truthy());
+  EXPECT_TRUE(Box::boolean(true).truthy());
+  EXPECT_TRUE(Box::integer(-1).truthy());
+  EXPECT_TRUE(Box(0.5).truthy());
+  EXPECT_TRUE(Box::string(0).truthy());
+  EXPECT_TRUE(Box::object(0).truthy());
+}
+
+TEST(DonutBoxTest, ArithmeticTest) {
+  EXPECT_EQ(Box::integer(5).bits(), Box::add(Box::integer(2), Box::integer(3)).bits());
+  EXPECT_EQ(Box::integer(-1).bits(), Box::sub(Box::integer(2), Box::integer(3)).bits());
+  EXPECT_EQ(Box::integer(6).bits(), Box::mul(Box::integer(2), Box::integer(3)).bits());
+  EXPECT_EQ(Box::integer(1).bits(), Box::mod(Box::integer(7), Box::integer(3)).bits());
+  EXPECT_EQ(Box::integer(-7).bits(), Box::neg(Box::integer(7)).bits());
+  EXPECT_EQ(2.5, Box::add(Box::integer(2), Box(0.5)).asNumber());
+  EXPECT_EQ(2.5, Box::div(Box::integer(5), Box::integer(2)).asNumber());
+  // Overflows fall back to numbers.
+  int32_t const max = std::numeric_limits<int32_t>::max();
+  int32_t const min = std::numeric_limits<int32_t>::min();
+  Box const sum = Box::add(Box::integer(max), Box::integer(1));
+  ASSERT_TRUE(sum.isNumber());
+  EXPECT_EQ(double(max) + 1, sum.asNumber());
+  EXPECT_EQ(-double(min), Box::neg(Box::integer(min)).asNumber());
+  EXPECT_EQ(double(max) * max, Box::mul(Box::integer(max), Box::integer(max)).asNumber());
+  // The results must be the same as computed in doubles, including the sign of zero.
+  Box const negZero = Box::mul(Box::integer(0), Box::integer(-1));
+  EXPECT_TRUE(std::signbit(negZero.toNumber()));
+  EXPECT_TRUE(std::signbit(Box::neg(Box::integer(0)).toNumber()));
+  EXPECT_TRUE(std::signbit(Box::mod(Box::integer(-4), Box::integer(2)).toNumber()));
+  EXPECT_EQ(std::fmod(-7.0, 3.0), Box::mod(Box::integer(-7), Box::integer(3)).toNumber());
+  EXPECT_TRUE(std::isnan(Box::mod(Box::integer(1), Box::integer(0)).toNumber()));
+}
+
+TEST(DonutBoxTest, CompareTest) {
+  EXPECT_TRUE(Box::eq(Box::integer(1), Box(1.0)));
+  EXPECT_TRUE(Box::eq(Box(0.0), Box(-0.0)));
+  EXPECT_FALSE(Box::eq(Box::integer(1), Box::boolean(true)));
+  EXPECT_TRUE(Box::eq(Box::nil(), Box::nil()));
+  EXPECT_TRUE(Box::eq(Box::string(3), Box::string(3)));
+  EXPECT_FALSE(Box::eq(Box::string(3), Box::object(3)));
+  EXPECT_TRUE(Box::lt(Box::integer(-2), Box::integer(1)));
+  EXPECT_TRUE(Box::lt(Box::integer(1), Box(1.5)));
+  EXPECT_TRUE(Box::le(Box::integer(2), Box(2.0)));
+  EXPECT_FALSE(Box::lt(Box(std::numeric_limits<double>::quiet_NaN()), Box::integer(0)));
+}
+
+}
@@ -0,0 +1,162 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "../../util/File.hpp"
+#include "../../util/MappedFile.hpp"
+#include "Cache.hpp"
+
+namespace donut {
+
+namespace {
+
+struct Header final {
+  char magic[4];
+  uint32_t formatVersion;
+  uint32_t compilerVersion;
+  uint32_t variant;
+  uint64_t hash;
+  uint32_t numConstants;
+  uint32_t numCode;
+  uint32_t numFunctions;
+  uint32_t numNatives;
+  uint32_t numStrings;
+  uint32_t reserved;
+};
+static_assert(sizeof(Header) % alignof(Box) == 0);
+
+constexpr char kMagic[4] = {'D', 'N', 'B', 'C'};
+
+template <typename T> std::span<T const> sliceOf(uint8_t const* const data, size_t& offset, size_t const count) {
+  auto const ptr = reinterpret_cast<T const*>(data + offset);
+  offset += sizeof(T) * count;
+  return std::span<T const>(ptr, count);
+}
+
+template <typename T> void writeAll(std::ofstream& out, std::span<T const> const dat) {
+  out.write(reinterpret_cast<char const*>(dat.data()), static_cast<std::streamsize>(dat.size_bytes()));
+}
+
+}
+
+Cache::Cache(std::filesystem::path dir, uint32_t const compilerVersion)
+:dir_(std::move(dir))
+,compilerVersion_(compilerVersion)
+{
+}
+
+std::shared_ptr<Source const> Cache::load(std::string const& filename, uint32_t const variant, Compiler const& compile) {
+  std::string const content = util::readAllFromFileAsString(filename);
+  uint64_t const h = Cache::hash(content);
+  if (auto cached = this->find(filename, variant, h); cached.has_value()) {
+    return cached.value();
+  }
+  auto src = std::make_shared<Source>(compile(filename, content));
+  this->store(filename, variant, h, *src);
+  return src;
+}
+
+// Named by the hash of the normalized path, which tells apart paths that only differ in separators.
+// The file name is kept in front, for people looking into the directory.
+std::filesystem::path Cache::entryPathOf(std::string const& filename, uint32_t const variant) const {
+  std::filesystem::path const path = std::filesystem::path(filename).lexically_normal();
+  std::string stem = path.stem().string();
+  for (char& c : stem) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+      c = '_';
+    }
+  }
+  return this->dir_ / fmt::format("{}-{:016x}-{}.dnbc", stem, Cache::hash(path.generic_string()), variant);
+}
+
+std::optional<std::shared_ptr<Source const>> Cache::find(std::string const& filename, uint32_t const variant, uint64_t const hash) const {
+  auto file = std::make_shared<util::MappedFile>(this->entryPathOf(filename, variant));
+  if (file->size() < sizeof(Header)) {
+    return std::optional<std::shared_ptr<Source const>>();
+  }
+  Header header{};
+  std::memcpy(&header, file->data(), sizeof(Header));
+  bool const valid =
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+      header.formatVersion == kFormatVersion &&
+      header.compilerVersion == this->compilerVersion_ &&
+      header.variant == variant &&
+      header.hash == hash;
+  size_t const expectedSize = sizeof(Header) +
+      sizeof(Box) * header.numConstants +
+      sizeof(Instruction) * header.numCode +
+      sizeof(uint32_t) * header.numCode +
+      sizeof(Function) * header.numFunctions +
+      sizeof(Symbol) * header.numNatives +
+      header.numStrings;
+  if (!valid || file->size() != expectedSize) {
+    // Stale. It will be overwritten by store().
+    return std::optional<std::shared_ptr<Source const>>();
+  }
+  uint8_t const* const data = file->data();
+  size_t offset = sizeof(Header);
+  auto const constants = sliceOf<Box>(data, offset, header.numConstants);
+  auto const code = sliceOf<Instruction>(data, offset, header.numCode);
+  auto const lines = sliceOf<uint32_t>(data, offset, header.numCode);
+  auto const functions = sliceOf<Function>(data, offset, header.numFunctions);
+  auto const natives = sliceOf<Symbol>(data, offset, header.numNatives);
+  std::string_view const strings(reinterpret_cast<char const*>(data + offset), header.numStrings);
+  return std::make_shared<Source const>(Source::view(std::move(file), constants, code, lines, functions, natives, strings));
+}
+
+void Cache::store(std::string const& filename, uint32_t const variant, uint64_t const hash, Source const& src) const {
+  std::filesystem::create_directories(this->dir_);
+  std::filesystem::path const path = this->entryPathOf(filename, variant);
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error(fmt::format("Failed to open cache file: {}", tmp.string()));
+    }
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.compilerVersion = this->compilerVersion_;
+    header.variant = variant;
+    header.hash = hash;
+    header.numConstants = static_cast<uint32_t>(src.constants().size());
+    header.numCode = static_cast<uint32_t>(src.code().size());
+    header.numFunctions = static_cast<uint32_t>(src.functions().size());
+    header.numNatives = static_cast<uint32_t>(src.natives().size());
+    header.numStrings = static_cast<uint32_t>(src.strings().size());
+    out.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+    writeAll(out, src.constants());
+    writeAll(out, src.code());
+    writeAll(out, src.lines());
+    writeAll(out, src.functions());
+    writeAll(out, src.natives());
+    out.write(src.strings().data(), static_cast<std::streamsize>(src.strings().size()));
+    if (!out) {
+      throw std::runtime_error(fmt::format("Failed to write cache file: {}", tmp.string()));
+    }
+  }
+  // Replace atomically, so that a reader never maps a half-written entry.
+  std::filesystem::rename(tmp, path);
+}
+
+// FNV-1a
+uint64_t Cache::hash(std::string_view const content) {
+  uint64_t h = 14695981039346656037ull;
+  for (char const c : content) {
+    h ^= static_cast<uint8_t>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+}
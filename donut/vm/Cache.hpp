@@ -0,0 +1,54 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+#include "Source.hpp"
+
+namespace donut {
+
+// On-disk bytecode cache.
+// Each script has one entry per variant, which is valid only for the same content and the same compiler.
+// A variant stands for the compile options that change the output, such as optimization, so they never share entries.
+// Entries are memory-mapped and used in place as a Source.
+// The game keeps them in `cache/`, next to `resources/`.
+class Cache final {
+public:
+  // Bump this when the layout of the cache files changes.
+  static constexpr uint32_t kFormatVersion = 4;
+  using Compiler = std::function<Source(std::string const& filename, std::string const& content)>;
+
+public:
+  Cache() = delete;
+  Cache(Cache const&) = delete;
+  Cache(Cache&&) = default;
+  Cache& operator=(Cache const&) = delete;
+  Cache& operator=(Cache&&) = default;
+  explicit Cache(std::filesystem::path dir, uint32_t compilerVersion);
+
+public:
+  // Returns the cached bytecode of the file, or compiles it and stores the result.
+  std::shared_ptr<Source const> load(std::string const& filename, uint32_t variant, Compiler const& compile);
+  [[nodiscard]] std::filesystem::path entryPathOf(std::string const& filename, uint32_t variant) const;
+  [[nodiscard]] std::optional<std::shared_ptr<Source const>> find(std::string const& filename, uint32_t variant, uint64_t hash) const;
+  void store(std::string const& filename, uint32_t variant, uint64_t hash, Source const& src) const;
+
+public:
+  [[nodiscard]] static uint64_t hash(std::string_view content);
+
+private:
+  std::filesystem::path dir_;
+  uint32_t compilerVersion_;
+};
+
+}
@@ -0,0 +1,96 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include "../../util/TempDir.hpp"
+#include "./Cache.hpp"
+#include "./Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+// "compiles" a script consisting of a single number into `fn main() { return <number>; }`
+Source compileNumber(std::string const&, std::string const& content) {
+  Source src;
+  src.addFunction("main", 0, 1, {
+      Instruction::abx(Opcode::LoadK, 0, src.constant(std::stod(content))),
+      Instruction::abc(Opcode::Ret, 0, 0, 0),
+  });
+  return src;
+}
+
+double runMain(std::shared_ptr<Source const> src) {
+  Clock<16> clock;
+  Machine<16> machine(clock);
+  machine.load(std::move(src));
+  uint32_t const fiber = machine.spawn("main");
+  machine.step();
+  return machine.stateOf(fiber).value().result.toNumber();
+}
+
+void writeFile(std::filesystem::path const& path, std::string const& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << content;
+}
+
+}
+
+TEST(DonutCacheTest, CacheTest) {
+  util::TempDir const dir("donut-cache-test");
+  std::string const script = (dir / "script.donut").string();
+  int compiled = 0;
+  auto compile = [&](std::string const& filename, std::string const& content) -> Source {
+    compiled++;
+    return compileNumber(filename, content);
+  };
+
+  writeFile(script, "42");
+  Cache cache(dir / "cache", 1);
+  EXPECT_EQ(42, runMain(cache.load(script, 0, compile)));
+  EXPECT_EQ(1, compiled);
+  EXPECT_TRUE(std::filesystem::exists(cache.entryPathOf(script, 0)));
+
+  // Mapped from the cache.
+  auto cached = cache.load(script, 0, compile);
+  EXPECT_EQ(1, compiled);
+  EXPECT_EQ(42, runMain(cached));
+  EXPECT_EQ("main", cached->str(cached->functions()[0].name));
+
+  // Content changed.
+  writeFile(script, "7");
+  EXPECT_EQ(7, runMain(cache.load(script, 0, compile)));
+  EXPECT_EQ(2, compiled);
+  EXPECT_EQ(42, runMain(cached));
+
+  // Compiler changed.
+  Cache newer(dir / "cache", 2);
+  EXPECT_EQ(7, runMain(newer.load(script, 0, compile)));
+  EXPECT_EQ(3, compiled);
+  EXPECT_EQ(7, runMain(newer.load(script, 0, compile)));
+  EXPECT_EQ(3, compiled);
+
+  // Another variant has an entry of its own, and does not evict the first one.
+  EXPECT_EQ(7, runMain(newer.load(script, 1, compile)));
+  EXPECT_EQ(4, compiled);
+  EXPECT_EQ(7, runMain(newer.load(script, 0, compile)));
+  EXPECT_EQ(7, runMain(newer.load(script, 1, compile)));
+  EXPECT_EQ(4, compiled);
+}
+
+TEST(DonutCacheTest, EntryTest) {
+  Cache cache("cache", 1);
+  // Paths that only differ in separators get entries of their own.
+  for (std::string const other : {"a_b_donut", "a_b.donut", "a/b_donut", "a:b.donut", "b.donut"}) {
+    EXPECT_NE(cache.entryPathOf("a/b.donut", 0), cache.entryPathOf(other, 0)) << other;
+  }
+  EXPECT_EQ(cache.entryPathOf("a/b.donut", 0), cache.entryPathOf("a/./b.donut", 0));
+  EXPECT_EQ(std::filesystem::path("cache"), cache.entryPathOf("a/b.donut", 0).parent_path());
+}
+
+}
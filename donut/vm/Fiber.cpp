@@ -0,0 +1,193 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include "Fiber.hpp"
+
+namespace donut {
+
+namespace {
+
+struct Body final {
+  Source const& src;
+  Function const& f;
+  std::span<Instruction const> code;
+};
+
+Body bodyOf(Source const& src, uint32_t const function) {
+  Function const& f = src.functions()[function];
+  // A function ends where the next one begins.
+  uint32_t end = static_cast<uint32_t>(src.code().size());
+  for (Function const& other : src.functions()) {
+    if (other.entry > f.entry) {
+      end = std::min(end, other.entry);
+    }
+  }
+  return Body{src, f, src.code().subspan(f.entry, end - f.entry)};
+}
+
+std::string_view calleeOf(Body const& body, Instruction const inst) {
+  return body.src.str(body.src.functions()[inst.bx()].name);
+}
+
+// Instructions are equal regardless of where the linker has put the constants, natives and functions.
+bool sameInstruction(Body const& a, Instruction const x, Body const& b, Instruction const y) {
+  if (x.op() != y.op()) {
+    return false;
+  }
+  switch (x.op()) {
+    case Opcode::LoadK:
+      return x.a() == y.a() && a.src.constants()[x.bx()].bits() == b.src.constants()[y.bx()].bits();
+    case Opcode::Call:
+      return x.a() == y.a() && calleeOf(a, x) == calleeOf(b, y);
+    case Opcode::Native:
+      return x.a() == y.a() && x.c() == y.c() && a.src.str(a.src.natives()[x.b()]) == b.src.str(b.src.natives()[y.b()]);
+    default:
+      return x.code() == y.code();
+  }
+}
+
+bool sameBody(Body const& a, Body const& b) {
+  if (a.f.registers != b.f.registers || a.code.size() != b.code.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.code.size(); ++i) {
+    if (!sameInstruction(a, a.code[i], b, b.code[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A place a frame can be suspended at.
+struct Point final {
+  uint32_t offset;
+  uint8_t kinds; // bits of Kind
+  uint8_t a;     // register of the call
+  std::string_view callee;
+};
+
+enum Kind : uint8_t {
+  Entry = 1u << 0u,
+  AfterWait = 1u << 1u,
+  AfterCall = 1u << 2u,
+  LoopHead = 1u << 3u,
+};
+
+std::vector<Point> pointsOf(Body const& body) {
+  std::vector<Point> points{Point{0, Kind::Entry, 0, {}}};
+  for (uint32_t i = 0; i < body.code.size(); ++i) {
+    Instruction const inst = body.code[i];
+    switch (inst.op()) {
+      case Opcode::Wait:
+        points.emplace_back(Point{i + 1, Kind::AfterWait, 0, {}});
+        break;
+      case Opcode::Call:
+        points.emplace_back(Point{i + 1, Kind::AfterCall, inst.a(), calleeOf(body, inst)});
+        break;
+      case Opcode::Jmp:
+      case Opcode::JmpIf:
+      case Opcode::JmpIfNot:
+      case Opcode::JmpIfB:
+      case Opcode::JmpIfNotB:
+        if (inst.sbx() < 0) {
+          points.emplace_back(Point{static_cast<uint32_t>(int32_t(i) + 1 + inst.sbx()), Kind::LoopHead, 0, {}});
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  std::sort(points.begin(), points.end(), [](Point const& x, Point const& y) { return x.offset < y.offset; });
+  std::vector<Point> merged;
+  for (Point const& p : points) {
+    if (!merged.empty() && merged.back().offset == p.offset) {
+      merged.back().kinds |= p.kinds;
+      if (p.kinds & Kind::AfterCall) {
+        merged.back().a = p.a;
+        merged.back().callee = p.callee;
+      }
+    } else {
+      merged.emplace_back(p);
+    }
+  }
+  return merged;
+}
+
+// The pc in `to` that corresponds to `pc` in `from`, if any.
+std::optional<uint32_t> remap(Body const& from, uint32_t const pc, Body const& to) {
+  uint32_t const offset = pc - from.f.entry;
+  if (sameBody(from, to)) {
+    return to.f.entry + offset;
+  }
+  if (from.f.registers != to.f.registers) {
+    return std::nullopt;
+  }
+  std::vector<Point> const a = pointsOf(from);
+  std::vector<Point> const b = pointsOf(to);
+  if (a.size() != b.size()) {
+    return std::nullopt;
+  }
+  std::optional<uint32_t> found;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].kinds != b[i].kinds || a[i].a != b[i].a || a[i].callee != b[i].callee) {
+      return std::nullopt;
+    }
+    if (a[i].offset == offset) {
+      found = to.f.entry + b[i].offset;
+    }
+  }
+  return found;
+}
+
+std::optional<uint32_t> counterpartOf(Source const& from, uint32_t const function, Source const& to) {
+  Function const& f = from.functions()[function];
+  std::optional<uint32_t> const idx = to.findFunction(from.str(f.name));
+  if (!idx.has_value() || to.functions()[idx.value()].arity != f.arity) {
+    return std::nullopt;
+  }
+  return idx;
+}
+
+}
+
+Migration migrate(FiberState& st, Source const& from, Source const& to) {
+  if (st.finished()) {
+    return Migration::Finished;
+  }
+  std::vector<CallFrame> frames;
+  frames.reserve(st.frames.size());
+  for (CallFrame const& frame : st.frames) {
+    std::optional<uint32_t> const function = counterpartOf(from, frame.function, to);
+    if (!function.has_value()) {
+      break;
+    }
+    std::optional<uint32_t> const pc = remap(bodyOf(from, frame.function), frame.pc, bodyOf(to, function.value()));
+    if (!pc.has_value()) {
+      break;
+    }
+    frames.emplace_back(CallFrame{function.value(), pc.value(), frame.base});
+  }
+  if (frames.size() == st.frames.size()) {
+    st.frames = std::move(frames);
+    return Migration::Kept;
+  }
+  std::optional<uint32_t> const root = counterpartOf(from, st.frames.front().function, to);
+  if (!root.has_value()) {
+    st.frames.clear();
+    st.registers.clear();
+    return Migration::Dropped;
+  }
+  Function const& f = to.functions()[root.value()];
+  st.frames = {CallFrame{root.value(), f.entry, 0}};
+  st.registers.resize(f.registers);
+  std::fill(std::next(st.registers.begin(), f.arity), st.registers.end(), Box::nil());
+  return Migration::Restarted;
+}
+
+}
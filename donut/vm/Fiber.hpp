@@ -0,0 +1,46 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Box.hpp"
+#include "Source.hpp"
+
+namespace donut {
+
+struct CallFrame final {
+  uint32_t function;
+  uint32_t pc;
+  uint32_t base; // index of R[0] in FiberState::registers
+};
+
+// Everything a fiber needs to resume. It is kept in the history storage,
+// so leaping the clock restores every fiber without re-executing it.
+struct FiberState final {
+  std::vector<CallFrame> frames;
+  std::vector<Box> registers;
+  uint32_t resumeAt;
+  Box result;
+  [[nodiscard]] bool finished() const { return frames.empty(); }
+};
+
+enum class Migration : uint8_t {
+  Finished,  // nothing to do
+  Kept,      // resumes where it was
+  Restarted, // resumes from the beginning of its entry function
+  Dropped,   // its entry function was removed, or its signature changed
+};
+
+// Moves a fiber running `from` onto `to`, where functions are matched by name.
+// A frame keeps its place when its function has the same signature, and either the same body,
+// or a body with the same registers and the same sequence of places to suspend at
+// (the entry, after each wait and call, and the heads of loops), e.g. when only numbers were edited.
+// Otherwise the fiber restarts from its entry function with the arguments it holds now.
+Migration migrate(FiberState& st, Source const& from, Source const& to);
+
+}
@@ -0,0 +1,94 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace donut {
+
+enum class Opcode : uint8_t {
+  Nop = 0,
+  LoadK,    // R[A] = K[Bx]
+  Move,     // R[A] = R[B]
+  Add,      // R[A] = R[B] + R[C]
+  Sub,      // R[A] = R[B] - R[C]
+  Mul,      // R[A] = R[B] * R[C]
+  Div,      // R[A] = R[B] / R[C]
+  Mod,      // R[A] = R[B] % R[C]
+  Neg,      // R[A] = -R[B]
+  Lt,       // R[A] = R[B] < R[C]
+  Le,       // R[A] = R[B] <= R[C]
+  Eq,       // R[A] = R[B] == R[C]
+  Not,      // R[A] = !R[B]
+  Jmp,      // pc += sBx
+  JmpIf,    // if R[A] then pc += sBx
+  JmpIfNot, // if !R[A] then pc += sBx
+  Call,     // R[A] = F[Bx](R[A]...R[A+arity-1])
+  Native,   // R[A] = N[B](R[A]...R[A+C-1])
+  Wait,     // suspend for R[A] frames
+  Ret,      // return R[A]
+  Spawn,    // R[A] = number of bullets spawned as SpawnKind(B) with R[A]...R[A+C-1]
+  // Specialized by the compiler where the types are proven; see FunctionTypes.
+  AddF,      // R[A] = R[B] + R[C], either of them a number and the other numeric
+  SubF,      // R[A] = R[B] - R[C], ditto
+  MulF,      // R[A] = R[B] * R[C], ditto
+  DivF,      // R[A] = R[B] / R[C], both numeric
+  ModF,      // R[A] = R[B] % R[C], either of them a number and the other numeric
+  NegF,      // R[A] = -R[B], a number
+  AddI,      // R[A] = R[B] + R[C], both ints
+  SubI,      // R[A] = R[B] - R[C], both ints
+  MulI,      // R[A] = R[B] * R[C], both ints
+  LtN,       // R[A] = R[B] < R[C], both numeric
+  LeN,       // R[A] = R[B] <= R[C], both numeric
+  EqN,       // R[A] = R[B] == R[C], both numeric
+  NotB,      // R[A] = !R[B], a bool
+  JmpIfB,    // if R[A] then pc += sBx, a bool
+  JmpIfNotB, // if !R[A] then pc += sBx, a bool
+};
+
+// 32bit register machine instruction.
+// | op(8) | A(8) | B(8) | C(8) |  or  | op(8) | A(8) | Bx(16) |
+class Instruction final {
+public:
+  constexpr Instruction() noexcept = default;
+  static constexpr int32_t kBiasSBx = 0x7fff;
+  // The range of sBx; the compiler rejects jumps that do not fit.
+  static constexpr int32_t kMinSBx = -kBiasSBx;
+  static constexpr int32_t kMaxSBx = 0xffff - kBiasSBx;
+
+  [[nodiscard]] static constexpr Instruction abc(Opcode const op, uint8_t const a, uint8_t const b, uint8_t const c) noexcept {
+    return Instruction(static_cast<uint32_t>(op) | (uint32_t(a) << 8u) | (uint32_t(b) << 16u) | (uint32_t(c) << 24u));
+  }
+  [[nodiscard]] static constexpr Instruction abx(Opcode const op, uint8_t const a, uint16_t const bx) noexcept {
+    return Instruction(static_cast<uint32_t>(op) | (uint32_t(a) << 8u) | (uint32_t(bx) << 16u));
+  }
+  [[nodiscard]] static constexpr Instruction asbx(Opcode const op, uint8_t const a, int32_t const sbx) noexcept {
+    return abx(op, a, static_cast<uint16_t>(sbx + kBiasSBx));
+  }
+
+public:
+  [[nodiscard]] constexpr Opcode op() const noexcept { return static_cast<Opcode>(code_ & 0xffu); }
+  [[nodiscard]] constexpr uint8_t a() const noexcept { return static_cast<uint8_t>((code_ >> 8u) & 0xffu); }
+  [[nodiscard]] constexpr uint8_t b() const noexcept { return static_cast<uint8_t>((code_ >> 16u) & 0xffu); }
+  [[nodiscard]] constexpr uint8_t c() const noexcept { return static_cast<uint8_t>((code_ >> 24u) & 0xffu); }
+  [[nodiscard]] constexpr uint16_t bx() const noexcept { return static_cast<uint16_t>(code_ >> 16u); }
+  [[nodiscard]] constexpr int32_t sbx() const noexcept { return static_cast<int32_t>(this->bx()) - kBiasSBx; }
+  [[nodiscard]] constexpr uint32_t code() const noexcept { return this->code_; }
+
+  constexpr bool operator==(Instruction const& rhs) const noexcept { return this->code_ == rhs.code_; }
+
+private:
+  explicit constexpr Instruction(uint32_t const code) noexcept
+  :code_(code) {
+  }
+private:
+  uint32_t code_{};
+};
+
+static_assert(sizeof(Instruction) == sizeof(uint32_t));
+
+}
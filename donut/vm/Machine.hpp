@@ -0,0 +1,607 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "../runtime/Value.hpp"
+#include "../../util/Logger.hpp"
+#include "../../util/Metrics.hpp"
+#include "../../util/ThreadPool.hpp"
+#include "Source.hpp"
+#include "Fiber.hpp"
+#include "Spawn.hpp"
+#include "Box.hpp"
+#include "Profiler.hpp"
+
+namespace donut {
+
+// Fibers after Machine::reload().
+struct ReloadStats final {
+  size_t kept = 0;
+  size_t restarted = 0;
+  size_t dropped = 0;
+};
+
+// Limits of the work done in step().
+// Only instruction counts decide preemption, so the result stays deterministic and replayable;
+// wall-clock time is reported, but never used for scheduling.
+struct Budget final {
+  uint64_t perFiber = 1u << 20; // instructions a fiber may run in a frame
+  uint64_t perFrame = 1u << 22; // instructions all fibers may run in a frame
+  std::chrono::microseconds slowFiber{2000}; // fibers running longer than this in a frame are reported
+};
+
+// Runs fibers: one per actor. Call step() once per frame, after Clock::tick().
+// After Clock::leap(t), fibers are in the state they had at the end of frame t.
+template <size_t length> class Machine final {
+public:
+  using NativeFunction = std::function<Box(Box const* args, uint8_t argc)>;
+  // Receives every group made by ring(), fan() and spread(); append it to the bullets in bulk.
+  using SpawnFunction = std::function<void(SpawnBatch const& batch)>;
+
+public:
+  Machine() = delete;
+  Machine(Machine const&) = delete;
+  Machine(Machine&&) = delete;
+  Machine& operator=(Machine const&) = delete;
+  Machine& operator=(Machine&&) = delete;
+  explicit Machine(Clock<length>& clock)
+  :clock_(clock)
+  ,workers_(1)
+  {
+  }
+
+public:
+  void setBudget(Budget const& budget) {
+    this->budget_ = budget;
+  }
+
+  // Overruns are reported to them, if given.
+  void setLogger(util::Logger* log) {
+    this->log_ = log;
+  }
+  void setMetrics(util::Metrics* metrics) {
+    this->metrics_ = metrics;
+  }
+
+  // Profiles the following steps; pass nullptr to stop. It can be switched at any time.
+  void setProfiler(Profiler* profiler) {
+    this->profiler_ = profiler;
+    if (this->profiler_ && this->source_) {
+      this->profiler_->attach(this->source_);
+    }
+  }
+
+  void setSpawner(SpawnFunction f) {
+    this->spawner_ = std::move(f);
+  }
+
+  void registerNative(std::string const& name, NativeFunction f) {
+    this->natives_[Name::of(name)] = std::move(f);
+  }
+
+  void load(std::shared_ptr<Source const> source) {
+    this->bind(std::move(source));
+  }
+
+  // Replaces the code under the running fibers; call it between steps.
+  // Every state in their history is migrated too, so leaps keep working (see migrate()).
+  ReloadStats reload(std::shared_ptr<Source const> source) {
+    std::shared_ptr<Source const> const old = this->source_;
+    this->bind(std::move(source));
+    ReloadStats stats;
+    if (!old) {
+      return stats;
+    }
+    Source const& from = *old;
+    Source const& to = *this->source_;
+    for (auto& fiber : this->fibers_) {
+      Optional<FiberState const> current = std::as_const(*fiber).get();
+      if (current.has_value()) {
+        FiberState st = current.value();
+        switch (migrate(st, from, to)) {
+          case Migration::Kept: stats.kept++; break;
+          case Migration::Restarted: stats.restarted++; break;
+          case Migration::Dropped: stats.dropped++; break;
+          case Migration::Finished: break;
+        }
+      }
+      fiber->update([&](FiberState& st) { migrate(st, from, to); });
+    }
+    return stats;
+  }
+
+private:
+  void bind(std::shared_ptr<Source const> source) {
+    std::vector<NativeFunction> bound;
+    for (Symbol const& sym : source->natives()) {
+      std::string_view const name = source->str(sym);
+      auto it = this->natives_.find(Name::of(name));
+      if (it == this->natives_.end()) {
+        throw std::runtime_error(fmt::format("Native function \"{}\" is not registered.", name));
+      }
+      bound.emplace_back(it->second);
+    }
+    this->source_ = std::move(source);
+    this->bound_ = std::move(bound);
+    if (this->profiler_) {
+      this->profiler_->attach(this->source_);
+    }
+  }
+
+public:
+  uint32_t spawn(std::string const& name, std::vector<Box> const& args = {}) {
+    auto const idx = this->source_->findFunction(name);
+    if (!idx.has_value()) {
+      throw std::runtime_error(fmt::format("Function \"{}\" not found.", name));
+    }
+    Function const& f = this->source_->functions()[idx.value()];
+    if (args.size() != f.arity) {
+      throw std::runtime_error(fmt::format("Function \"{}\" takes {} arguments, but {} given.", name, f.arity, args.size()));
+    }
+    FiberState st{};
+    st.frames.emplace_back(CallFrame{idx.value(), f.entry, 0});
+    st.registers.resize(f.registers);
+    std::copy(args.begin(), args.end(), st.registers.begin());
+    st.resumeAt = this->clock_.current();
+    auto fiber = std::make_unique<Value<FiberState, length>>(this->clock_);
+    *fiber = std::move(st);
+    this->fibers_.emplace_back(std::move(fiber));
+    return static_cast<uint32_t>(this->fibers_.size() - 1);
+  }
+
+  // A fiber running out of its budget is preempted at a backward jump or a call, and continues
+  // in the next frame. When the frame budget runs out, the rest of the fibers wait for the next
+  // frame; the fiber to begin with rotates every frame, so that none of them starves.
+  void step() {
+    uint32_t const now = this->clock_.current();
+    size_t const numFibers = this->fibers_.size();
+    this->overrunning_.resize(numFibers, false);
+    uint64_t remaining = this->budget_.perFrame;
+    size_t deferred = 0;
+    for (size_t i = 0; i < numFibers; ++i) {
+      size_t const idx = (now + i) % numFibers;
+      auto& fiber = this->fibers_[idx];
+      Optional<FiberState const> current = std::as_const(*fiber).get();
+      if (!current.has_value() || current.value().finished() || now < current.value().resumeAt) {
+        continue;
+      }
+      if (remaining == 0) {
+        deferred++;
+        continue;
+      }
+      FiberState st = current.value();
+      auto const beg = std::chrono::steady_clock::now();
+      uint64_t const budget = std::min(this->budget_.perFiber, remaining);
+      Worker& worker = this->workers_.front();
+      Slice const slice = this->profiler_ ? this->run<true>(st, now, budget, worker) : this->run<false>(st, now, budget, worker);
+      auto const elapsed = std::chrono::steady_clock::now() - beg;
+      remaining -= std::min(remaining, slice.executed);
+      *fiber = std::move(st);
+      this->report(idx, now, budget, slice, elapsed);
+    }
+    if (deferred > 0) {
+      this->numDeferred_ += deferred;
+      if (this->metrics_) {
+        this->metrics_->add("donut.vm.deferred", deferred);
+      }
+      if (this->log_) {
+        this->log_->warn("[donut] Frame {}: instruction budget ({}) exhausted, {} fibers deferred.", now, this->budget_.perFrame, deferred);
+      }
+    }
+  }
+
+  // Runs the fibers on the pool. Each worker spawns into its own buffer, and the groups are handed
+  // to the spawner afterwards, in the order step() would, so the bullets do not depend on the
+  // number of workers. Natives must be safe to call concurrently.
+  // The frame budget cannot be used up in order here; every fiber gets an equal share of it instead.
+  // While profiling, this is the same as step().
+  void step(util::ThreadPool& pool) {
+    if (this->profiler_) {
+      this->step();
+      return;
+    }
+    uint32_t const now = this->clock_.current();
+    size_t const numFibers = this->fibers_.size();
+    this->overrunning_.resize(numFibers, false);
+    std::vector<uint32_t>& runnable = this->runnable_;
+    runnable.clear();
+    for (size_t i = 0; i < numFibers; ++i) {
+      size_t const idx = (now + i) % numFibers;
+      Optional<FiberState const> current = std::as_const(*this->fibers_[idx]).get();
+      if (current.has_value() && !current.value().finished() && now >= current.value().resumeAt) {
+        runnable.emplace_back(static_cast<uint32_t>(idx));
+      }
+    }
+    if (runnable.empty()) {
+      return;
+    }
+    uint64_t const budget = std::min(this->budget_.perFiber, std::max<uint64_t>(1, this->budget_.perFrame / runnable.size()));
+    this->workers_.resize(std::max(this->workers_.size(), pool.numWorkers()));
+    for (Worker& worker : this->workers_) {
+      worker.buffering = static_cast<bool>(this->spawner_);
+      worker.groups.clear();
+      worker.spawned.clear();
+    }
+    this->results_.resize(runnable.size());
+    size_t const numTasks = (runnable.size() + kFibersPerTask - 1) / kFibersPerTask;
+    pool.run(numTasks, [&](size_t const w, size_t const task) {
+      Worker& worker = this->workers_[w];
+      size_t const end = std::min(runnable.size(), (task + 1) * kFibersPerTask);
+      for (size_t i = task * kFibersPerTask; i < end; ++i) {
+        auto& fiber = *this->fibers_[runnable[i]];
+        FiberState st = std::as_const(fiber).get().value();
+        auto const beg = std::chrono::steady_clock::now();
+        worker.order = static_cast<uint32_t>(i);
+        Slice const slice = this->run<false>(st, now, budget, worker);
+        this->results_[i] = Result{slice, std::chrono::steady_clock::now() - beg};
+        fiber = std::move(st);
+      }
+    });
+    for (Worker& worker : this->workers_) {
+      worker.buffering = false;
+    }
+    if (this->spawner_) {
+      this->merge();
+    }
+    for (size_t i = 0; i < runnable.size(); ++i) {
+      this->report(runnable[i], now, budget, this->results_[i].slice, this->results_[i].elapsed);
+    }
+  }
+
+public:
+  [[nodiscard]] size_t numFibers() const { return this->fibers_.size(); }
+  // Total number of instructions executed by step(), for measuring compiler optimizations.
+  [[nodiscard]] uint64_t numExecuted() const { return this->numExecuted_; }
+  // Totals of the fibers preempted by their budget, and of the fibers deferred by the frame budget.
+  [[nodiscard]] uint64_t numPreempted() const { return this->numPreempted_; }
+  [[nodiscard]] uint64_t numDeferred() const { return this->numDeferred_; }
+
+  // Fibers spawned after the current time do not exist yet.
+  [[nodiscard]] bool isRunning(uint32_t const fiber) const {
+    Optional<FiberState const> st = std::as_const(*this->fibers_.at(fiber)).get();
+    return st.has_value() && !st.value().finished();
+  }
+
+  [[nodiscard]] Optional<FiberState const> stateOf(uint32_t const fiber) const {
+    return std::as_const(*this->fibers_.at(fiber)).get();
+  }
+
+private:
+  struct Slice final {
+    uint64_t executed;
+    bool preempted;
+  };
+
+  // A group spawned in a parallel step: the fiber made it, and where it ends in Worker::spawned.
+  struct Group final {
+    uint32_t order; // of the fiber in step()
+    uint32_t end;
+  };
+
+  struct Worker final {
+    SpawnBatch batch; // the group being spawned
+    bool buffering = false;
+    uint32_t order = 0;
+    SpawnBatch spawned;
+    std::vector<Group> groups;
+  };
+
+  // A group to hand to the spawner: [beg, end) of the worker's buffer.
+  struct Merging final {
+    uint32_t order;
+    Worker const* worker;
+    uint32_t beg;
+    uint32_t end;
+  };
+
+  struct Result final {
+    Slice slice;
+    std::chrono::steady_clock::duration elapsed;
+  };
+
+  static constexpr size_t kFibersPerTask = 16;
+
+  static void append(SpawnBatch& to, SpawnBatch const& from, size_t const beg, size_t const end) {
+    to.x.insert(to.x.end(), from.x.begin() + beg, from.x.begin() + end);
+    to.y.insert(to.y.end(), from.y.begin() + beg, from.y.begin() + end);
+    to.vx.insert(to.vx.end(), from.vx.begin() + beg, from.vx.begin() + end);
+    to.vy.insert(to.vy.end(), from.vy.begin() + beg, from.vy.begin() + end);
+  }
+
+  // Hands the groups buffered by the workers to the spawner, in the order of the fibers.
+  void merge() {
+    this->merging_.clear();
+    for (Worker const& worker : this->workers_) {
+      uint32_t beg = 0;
+      for (Group const& group : worker.groups) {
+        this->merging_.emplace_back(Merging{group.order, &worker, beg, group.end});
+        beg = group.end;
+      }
+    }
+    // Groups of the same fiber are made by the same worker, so a stable sort keeps their order.
+    std::stable_sort(this->merging_.begin(), this->merging_.end(), [](Merging const& a, Merging const& b) { return a.order < b.order; });
+    SpawnBatch& batch = this->workers_.front().batch;
+    for (Merging const& m : this->merging_) {
+      batch.clear();
+      append(batch, m.worker->spawned, m.beg, m.end);
+      this->spawner_(batch);
+    }
+  }
+
+  template <bool profiling>
+  Slice run(FiberState& st, uint32_t const now, uint64_t const budget, Worker& worker) {
+    Source const& src = *this->source_;
+    Instruction const* const code = src.code().data();
+    Box const* const constants = src.constants().data();
+    uint64_t executed = 0;
+    uint32_t pc = 0;
+    auto const sample = [&]() {
+      if constexpr (profiling) {
+        this->profiler_->sample(st.frames.data(), st.frames.size(), pc);
+      }
+    };
+    // Checked only where a fiber can loop: backward jumps and calls.
+    auto const exhausted = [&]() {
+      if (executed < budget) {
+        return false;
+      }
+      st.resumeAt = now + 1;
+      sample();
+      return true;
+    };
+    if constexpr (profiling) {
+      this->profiler_->begin();
+    }
+    for (;;) {
+      CallFrame& frame = st.frames.back();
+      pc = frame.pc++;
+      Instruction const inst = code[pc];
+      executed++;
+      if constexpr (profiling) {
+        if (this->profiler_->count(pc)) {
+          sample();
+        }
+      }
+      Box* const r = st.registers.data() + frame.base;
+      switch (inst.op()) {
+        case Opcode::Nop:
+          break;
+        case Opcode::LoadK:
+          r[inst.a()] = constants[inst.bx()];
+          break;
+        case Opcode::Move:
+          r[inst.a()] = r[inst.b()];
+          break;
+        case Opcode::Add:
+          r[inst.a()] = Box::add(r[inst.b()], r[inst.c()]);
+          break;
+        case Opcode::Sub:
+          r[inst.a()] = Box::sub(r[inst.b()], r[inst.c()]);
+          break;
+        case Opcode::Mul:
+          r[inst.a()] = Box::mul(r[inst.b()], r[inst.c()]);
+          break;
+        case Opcode::Div:
+          r[inst.a()] = Box::div(r[inst.b()], r[inst.c()]);
+          break;
+        case Opcode::Mod:
+          r[inst.a()] = Box::mod(r[inst.b()], r[inst.c()]);
+          break;
+        case Opcode::Neg:
+          r[inst.a()] = Box::neg(r[inst.b()]);
+          break;
+        case Opcode::Lt:
+          r[inst.a()] = Box::boolean(Box::lt(r[inst.b()], r[inst.c()]));
+          break;
+        case Opcode::Le:
+          r[inst.a()] = Box::boolean(Box::le(r[inst.b()], r[inst.c()]));
+          break;
+        case Opcode::Eq:
+          r[inst.a()] = Box::boolean(Box::eq(r[inst.b()], r[inst.c()]));
+          break;
+        case Opcode::Not:
+          r[inst.a()] = Box::boolean(!r[inst.b()].truthy());
+          break;
+        case Opcode::Jmp:
+          frame.pc += inst.sbx();
+          if (inst.sbx() < 0 && exhausted()) {
+            return Slice{executed, true};
+          }
+          break;
+        case Opcode::JmpIf:
+          if (r[inst.a()].truthy()) {
+            frame.pc += inst.sbx();
+            if (inst.sbx() < 0 && exhausted()) {
+              return Slice{executed, true};
+            }
+          }
+          break;
+        case Opcode::JmpIfNot:
+          if (!r[inst.a()].truthy()) {
+            frame.pc += inst.sbx();
+            if (inst.sbx() < 0 && exhausted()) {
+              return Slice{executed, true};
+            }
+          }
+          break;
+        case Opcode::Call: {
+          sample();
+          Function const& callee = src.functions()[inst.bx()];
+          uint32_t const base = frame.base + inst.a();
+          st.registers.resize(std::max<size_t>(st.registers.size(), base + callee.registers));
+          std::fill(std::next(st.registers.begin(), base + callee.arity), std::next(st.registers.begin(), base + callee.registers), Box::nil());
+          st.frames.emplace_back(CallFrame{inst.bx(), callee.entry, base});
+          if (exhausted()) {
+            return Slice{executed, true};
+          }
+          break;
+        }
+        case Opcode::Native:
+          r[inst.a()] = this->bound_[inst.b()](&r[inst.a()], inst.c());
+          break;
+        case Opcode::Spawn: {
+          double args[UINT8_MAX];
+          for (uint8_t i = 0; i < inst.c(); ++i) {
+            args[i] = r[inst.a() + i].toNumber();
+          }
+          donut::spawn(worker.batch, static_cast<SpawnKind>(inst.b()), args);
+          if (worker.buffering) {
+            append(worker.spawned, worker.batch, 0, worker.batch.size());
+            worker.groups.emplace_back(Group{worker.order, static_cast<uint32_t>(worker.spawned.size())});
+          } else if (this->spawner_) {
+            this->spawner_(worker.batch);
+          }
+          r[inst.a()] = Box::integer(static_cast<int32_t>(worker.batch.size()));
+          break;
+        }
+        case Opcode::Wait:
+          st.resumeAt = now + static_cast<uint32_t>(std::min(std::max(1.0, r[inst.a()].toNumber()), 1e9));
+          sample();
+          return Slice{executed, false};
+        case Opcode::Ret: {
+          sample();
+          Box const result = r[inst.a()];
+          uint32_t const base = frame.base;
+          st.frames.pop_back();
+          if (st.frames.empty()) {
+            st.result = result;
+            st.registers.clear();
+            return Slice{executed, false};
+          }
+          CallFrame const& caller = st.frames.back();
+          st.registers[base] = result;
+          st.registers.resize(caller.base + src.functions()[caller.function].registers);
+          break;
+        }
+        case Opcode::AddF:
+          r[inst.a()] = Box(r[inst.b()].numeric() + r[inst.c()].numeric());
+          break;
+        case Opcode::SubF:
+          r[inst.a()] = Box(r[inst.b()].numeric() - r[inst.c()].numeric());
+          break;
+        case Opcode::MulF:
+          r[inst.a()] = Box(r[inst.b()].numeric() * r[inst.c()].numeric());
+          break;
+        case Opcode::DivF:
+          r[inst.a()] = Box(r[inst.b()].numeric() / r[inst.c()].numeric());
+          break;
+        case Opcode::ModF:
+          r[inst.a()] = Box(std::fmod(r[inst.b()].numeric(), r[inst.c()].numeric()));
+          break;
+        case Opcode::NegF:
+          r[inst.a()] = Box(-r[inst.b()].asNumber());
+          break;
+        case Opcode::AddI:
+          r[inst.a()] = Box::fromInt64(int64_t(r[inst.b()].asInt()) + r[inst.c()].asInt());
+          break;
+        case Opcode::SubI:
+          r[inst.a()] = Box::fromInt64(int64_t(r[inst.b()].asInt()) - r[inst.c()].asInt());
+          break;
+        case Opcode::MulI: {
+          int32_t const b = r[inst.b()].asInt();
+          int32_t const c = r[inst.c()].asInt();
+          // 0 * -1 must be -0.0, as in Box::mul.
+          r[inst.a()] = b != 0 && c != 0 ? Box::fromInt64(int64_t(b) * c) : Box(double(b) * double(c));
+          break;
+        }
+        case Opcode::LtN:
+          r[inst.a()] = Box::boolean(r[inst.b()].numeric() < r[inst.c()].numeric());
+          break;
+        case Opcode::LeN:
+          r[inst.a()] = Box::boolean(r[inst.b()].numeric() <= r[inst.c()].numeric());
+          break;
+        case Opcode::EqN:
+          r[inst.a()] = Box::boolean(r[inst.b()].numeric() == r[inst.c()].numeric());
+          break;
+        case Opcode::NotB:
+          r[inst.a()] = Box::boolean(!r[inst.b()].asBool());
+          break;
+        case Opcode::JmpIfB:
+          if (r[inst.a()].asBool()) {
+            frame.pc += inst.sbx();
+            if (inst.sbx() < 0 && exhausted()) {
+              return Slice{executed, true};
+            }
+          }
+          break;
+        case Opcode::JmpIfNotB:
+          if (!r[inst.a()].asBool()) {
+            frame.pc += inst.sbx();
+            if (inst.sbx() < 0 && exhausted()) {
+              return Slice{executed, true};
+            }
+          }
+          break;
+        default:
+          throw std::runtime_error(fmt::format("Unknown opcode: {}", static_cast<int>(inst.op())));
+      }
+    }
+  }
+
+  // Called in the order of the fibers, after the fiber has been stored. `budget` is the one the slice was run with.
+  void report(size_t const fiber, uint32_t const now, uint64_t const budget, Slice const& slice, std::chrono::steady_clock::duration const elapsed) {
+    this->numExecuted_ += slice.executed;
+    if (elapsed > this->budget_.slowFiber) {
+      if (this->metrics_) {
+        this->metrics_->add("donut.vm.slow");
+      }
+      if (this->log_) {
+        auto const us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        this->log_->warn("[donut] Frame {}: fiber {} took {} us.", now, fiber, us);
+      }
+    }
+    if (slice.preempted) {
+      this->numPreempted_++;
+      if (this->metrics_) {
+        this->metrics_->add("donut.vm.preempted");
+      }
+    }
+    // Logged once when a fiber starts overrunning, not every frame it keeps doing so.
+    // A slice cut short by the frame budget is not the fiber's fault; that is logged as deferred fibers.
+    bool const overrun = slice.preempted && budget == this->budget_.perFiber;
+    if (overrun && !this->overrunning_[fiber] && this->log_) {
+      Source const& src = *this->source_;
+      FiberState const& st = std::as_const(*this->fibers_[fiber]).get().value();
+      std::string_view const name = src.str(src.functions()[st.frames.front().function].name);
+      this->log_->warn("[donut] Frame {}: fiber {} ({}) ran out of its instruction budget.", now, fiber, name);
+    }
+    this->overrunning_[fiber] = overrun;
+  }
+
+private:
+  Clock<length>& clock_;
+  std::shared_ptr<Source const> source_;
+  std::unordered_map<Name, NativeFunction> natives_;
+  std::vector<NativeFunction> bound_;
+  SpawnFunction spawner_;
+  Profiler* profiler_ = nullptr;
+  std::vector<Worker> workers_;
+  std::vector<uint32_t> runnable_;
+  std::vector<Result> results_;
+  std::vector<Merging> merging_;
+  std::vector<std::unique_ptr<Value<FiberState, length>>> fibers_;
+  Budget budget_;
+  util::Logger* log_ = nullptr;
+  util::Metrics* metrics_ = nullptr;
+  std::vector<bool> overrunning_;
+  uint64_t numExecuted_ = 0;
+  uint64_t numPreempted_ = 0;
+  uint64_t numDeferred_ = 0;
+};
+
+}
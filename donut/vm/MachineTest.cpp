@@ -0,0 +1,258 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <utility>
+#include "./Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+using I = Instruction;
+using O = Opcode;
+
+// fn twice(x) { return x * 2; }
+// fn main() { var i = 0; while(i < 5) { emit(twice(i)); wait(10); i = i + 1; } return i; }
+std::shared_ptr<Source> loopSource() {
+  auto src = std::make_shared<Source>();
+  uint32_t const twice = src->addFunction("twice", 1, 2, {
+      I::abx(O::LoadK, 1, src->constant(2)),
+      I::abc(O::Mul, 0, 0, 1),
+      I::abc(O::Ret, 0, 0, 0),
+  });
+  uint8_t const emit = src->native("emit");
+  src->addFunction("main", 0, 4, {
+      I::abx(O::LoadK, 0, src->constant(0)),     // 0: i = 0
+      I::abx(O::LoadK, 1, src->constant(5)),     // 1
+      I::abc(O::Lt, 2, 0, 1),                    // 2: i < 5
+      I::asbx(O::JmpIfNot, 2, 8),                // 3: -> 12
+      I::abc(O::Move, 3, 0, 0),                  // 4
+      I::abx(O::Call, 3, twice),                 // 5: twice(i)
+      I::abc(O::Native, 3, emit, 1),             // 6: emit(...)
+      I::abx(O::LoadK, 3, src->constant(10)),    // 7
+      I::abc(O::Wait, 3, 0, 0),                  // 8: wait(10)
+      I::abx(O::LoadK, 3, src->constant(1)),     // 9
+      I::abc(O::Add, 0, 0, 3),                   // 10: i = i + 1
+      I::asbx(O::Jmp, 0, -10),                   // 11: -> 2
+      I::abc(O::Ret, 0, 0, 0),                   // 12
+  });
+  return src;
+}
+
+// fn spin(n) { var i = 0; while(i < n) { i = i + 1; } return i; }
+std::shared_ptr<Source> spinSource() {
+  auto src = std::make_shared<Source>();
+  src->addFunction("spin", 1, 4, {
+      I::abx(O::LoadK, 1, src->constant(0)),     // 0: i = 0
+      I::abc(O::Lt, 2, 1, 0),                    // 1: i < n
+      I::asbx(O::JmpIfNot, 2, 3),                // 2: -> 6
+      I::abx(O::LoadK, 3, src->constant(1)),     // 3
+      I::abc(O::Add, 1, 1, 3),                   // 4: i = i + 1
+      I::asbx(O::Jmp, 0, -5),                    // 5: -> 1
+      I::abc(O::Ret, 1, 0, 0),                   // 6
+  });
+  return src;
+}
+
+}
+
+TEST(DonutMachineTest, RunTest) {
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<std::pair<uint32_t, double>> out;
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    out.emplace_back(clock.current(), args[0].toNumber());
+    return 0;
+  });
+  machine.load(loopSource());
+  uint32_t const fiber = machine.spawn("main");
+  for (int i = 0; i < 60; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  std::vector<std::pair<uint32_t, double>> const expected = {
+      {1, 0}, {11, 2}, {21, 4}, {31, 6}, {41, 8},
+  };
+  EXPECT_EQ(expected, out);
+  EXPECT_FALSE(machine.isRunning(fiber));
+  EXPECT_EQ(5, machine.stateOf(fiber).value().result.toNumber());
+}
+
+TEST(DonutMachineTest, LeapTest) {
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<std::pair<uint32_t, double>> out;
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    out.emplace_back(clock.current(), args[0].toNumber());
+    return 0;
+  });
+  machine.load(loopSource());
+  uint32_t const fiber = machine.spawn("main");
+  for (int i = 0; i < 25; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  ASSERT_EQ(3, out.size());
+
+  // Back to the middle of the second wait(10).
+  clock.leap(15);
+  out.clear();
+  EXPECT_TRUE(machine.isRunning(fiber));
+  EXPECT_EQ(21, machine.stateOf(fiber).value().resumeAt);
+  EXPECT_EQ(1, machine.stateOf(fiber).value().registers[0].toNumber());
+  while (clock.current() < 60) {
+    clock.tick();
+    machine.step();
+  }
+  std::vector<std::pair<uint32_t, double>> const expected = {
+      {21, 4}, {31, 6}, {41, 8},
+  };
+  EXPECT_EQ(expected, out);
+  EXPECT_EQ(5, machine.stateOf(fiber).value().result.toNumber());
+
+  // Before a fiber was spawned, it does not exist yet.
+  uint32_t const late = machine.spawn("main");
+  EXPECT_TRUE(machine.isRunning(late));
+  clock.leap(30);
+  EXPECT_FALSE(machine.isRunning(late));
+  EXPECT_FALSE(machine.stateOf(late).has_value());
+  EXPECT_TRUE(machine.isRunning(fiber));
+
+  // Back to the frame the first fiber was spawned in.
+  clock.leap(0);
+  EXPECT_TRUE(machine.isRunning(fiber));
+}
+
+TEST(DonutMachineTest, LeapInCalleeTest) {
+  // fn sleep(n) { wait(n); return n * 2; }
+  // fn main() { emit(sleep(3)); emit(sleep(4)); }
+  auto src = std::make_shared<Source>();
+  uint32_t const sleep = src->addFunction("sleep", 1, 2, {
+      I::abc(O::Wait, 0, 0, 0),
+      I::abx(O::LoadK, 1, src->constant(2)),
+      I::abc(O::Mul, 0, 0, 1),
+      I::abc(O::Ret, 0, 0, 0),
+  });
+  uint8_t const emit = src->native("emit");
+  src->addFunction("main", 0, 1, {
+      I::abx(O::LoadK, 0, src->constant(3)),
+      I::abx(O::Call, 0, sleep),
+      I::abc(O::Native, 0, emit, 1),
+      I::abx(O::LoadK, 0, src->constant(4)),
+      I::abx(O::Call, 0, sleep),
+      I::abc(O::Native, 0, emit, 1),
+      I::abc(O::Ret, 0, 0, 0),
+  });
+
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<std::pair<uint32_t, double>> out;
+  machine.registerNative("emit", [&](Box const* args, uint8_t) -> Box {
+    out.emplace_back(clock.current(), args[0].toNumber());
+    return 0;
+  });
+  machine.load(src);
+  machine.spawn("main");
+  for (int i = 0; i < 6; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  std::vector<std::pair<uint32_t, double>> expected = {{4, 6}};
+  EXPECT_EQ(expected, out);
+
+  // Inside the second call of sleep()
+  clock.leap(5);
+  out.clear();
+  for (int i = 0; i < 10; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  expected = {{8, 8}};
+  EXPECT_EQ(expected, out);
+}
+
+TEST(DonutMachineTest, BudgetTest) {
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  FILE* const out = std::tmpfile();
+  util::Logger log(out, out);
+  machine.setLogger(&log);
+  machine.setBudget(Budget{1000, UINT64_MAX, std::chrono::seconds(1)});
+  machine.load(spinSource());
+  uint32_t const fiber = machine.spawn("spin", {1000});
+  // 5 instructions an iteration: preempted 5 times at the backward jump, then finishes.
+  for (int i = 0; i < 5; ++i) {
+    clock.tick();
+    machine.step();
+    EXPECT_TRUE(machine.isRunning(fiber));
+    EXPECT_EQ(200 * (i + 1), machine.stateOf(fiber).value().registers[1].toNumber());
+  }
+  clock.tick();
+  machine.step();
+  EXPECT_FALSE(machine.isRunning(fiber));
+  EXPECT_EQ(1000, machine.stateOf(fiber).value().result.toNumber());
+  EXPECT_EQ(5, machine.numPreempted());
+  // Preempted states are in the history, too.
+  clock.leap(3);
+  EXPECT_EQ(600, machine.stateOf(fiber).value().registers[1].toNumber());
+  for (int i = 0; i < 3; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  EXPECT_EQ(1000, machine.stateOf(fiber).value().result.toNumber());
+  std::string logged(4096, '\0');
+  std::rewind(out);
+  logged.resize(std::fread(logged.data(), 1, logged.size(), out));
+  std::fclose(out);
+  EXPECT_NE(std::string::npos, logged.find("(spin) ran out of its instruction budget."));
+}
+
+TEST(DonutMachineTest, FairnessTest) {
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  FILE* const out = std::tmpfile();
+  util::Logger log(out, out);
+  util::Metrics metrics;
+  machine.setLogger(&log);
+  machine.setMetrics(&metrics);
+  machine.setBudget(Budget{UINT64_MAX, 1000, std::chrono::seconds(1)});
+  machine.load(spinSource());
+  std::vector<uint32_t> fibers;
+  for (int i = 0; i < 3; ++i) {
+    fibers.emplace_back(machine.spawn("spin", {300}));
+  }
+  // Only one fiber fits in a frame, but every fiber gets its turn.
+  for (int i = 0; i < 3; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  for (uint32_t const fiber : fibers) {
+    EXPECT_LT(0, machine.stateOf(fiber).value().registers[1].toNumber()) << fiber;
+  }
+  for (int i = 0; i < 6; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  for (uint32_t const fiber : fibers) {
+    EXPECT_FALSE(machine.isRunning(fiber)) << fiber;
+    EXPECT_EQ(300, machine.stateOf(fiber).value().result.toNumber()) << fiber;
+  }
+  EXPECT_LT(0, machine.numDeferred());
+  EXPECT_EQ(machine.numDeferred(), metrics.get("donut.vm.deferred"));
+  EXPECT_EQ(machine.numPreempted(), metrics.get("donut.vm.preempted"));
+  std::string logged(4096, '\0');
+  std::rewind(out);
+  logged.resize(std::fread(logged.data(), 1, logged.size(), out));
+  std::fclose(out);
+  // The fibers were cut by the frame budget, not by their own.
+  EXPECT_EQ(std::string::npos, logged.find("ran out of its instruction budget."));
+  EXPECT_NE(std::string::npos, logged.find("fibers deferred."));
+}
+
+}
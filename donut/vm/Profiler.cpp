@@ -0,0 +1,131 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <tuple>
+#include <algorithm>
+#include <fmt/format.h>
+#include "Profiler.hpp"
+#include "Machine.hpp"
+
+namespace donut {
+
+namespace {
+
+// Function index of each pc; a function ends where the next one begins.
+std::vector<uint32_t> ownersOf(Source const& src) {
+  std::span<Function const> const functions = src.functions();
+  std::vector<uint32_t> order(functions.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return functions[a].entry < functions[b].entry; });
+  std::vector<uint32_t> owners(src.code().size(), 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    uint32_t const beg = functions[order[i]].entry;
+    uint32_t const end = i + 1 < order.size() ? functions[order[i + 1]].entry : static_cast<uint32_t>(owners.size());
+    std::fill(owners.begin() + beg, owners.begin() + end, order[i]);
+  }
+  return owners;
+}
+
+}
+
+void Profiler::attach(std::shared_ptr<Source const> source) {
+  if (this->source_ == source) {
+    return;
+  }
+  this->source_ = std::move(source);
+  this->reset();
+}
+
+void Profiler::reset() {
+  size_t const size = this->source_ ? this->source_->code().size() : 0;
+  this->counts_.assign(size, 0);
+  this->nanos_.assign(size, 0);
+  this->stacks_.clear();
+  this->pending_ = 0;
+}
+
+void Profiler::sample(CallFrame const* const frames, size_t const numFrames, uint32_t const pc) {
+  auto const now = std::chrono::steady_clock::now();
+  auto const nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->last_).count());
+  this->last_ = now;
+  this->nanos_[pc] += nanos;
+  this->key_.resize(numFrames);
+  for (size_t i = 0; i < numFrames; ++i) {
+    this->key_[i] = frames[i].function;
+  }
+  auto it = this->stacks_.find(this->key_);
+  if (it == this->stacks_.end()) {
+    it = this->stacks_.emplace(this->key_, Stats{}).first;
+  }
+  it->second.instructions += this->pending_;
+  it->second.nanos += nanos;
+  this->pending_ = 0;
+}
+
+std::vector<Profiler::FunctionStats> Profiler::functions() const {
+  std::vector<FunctionStats> result;
+  if (!this->source_) {
+    return result;
+  }
+  Source const& src = *this->source_;
+  for (Function const& f : src.functions()) {
+    result.emplace_back(FunctionStats{std::string(src.str(f.name)), std::string(src.str(f.file)), f.line, Stats{}});
+  }
+  std::vector<uint32_t> const owners = ownersOf(src);
+  for (size_t pc = 0; pc < owners.size(); ++pc) {
+    result[owners[pc]].self.instructions += this->counts_[pc];
+    result[owners[pc]].self.nanos += this->nanos_[pc];
+  }
+  return result;
+}
+
+std::vector<Profiler::LineStats> Profiler::lines() const {
+  std::vector<LineStats> result;
+  if (!this->source_) {
+    return result;
+  }
+  Source const& src = *this->source_;
+  std::map<std::tuple<std::string_view, uint32_t>, Stats> byLine;
+  std::vector<uint32_t> const owners = ownersOf(src);
+  std::span<uint32_t const> const lines = src.lines();
+  for (size_t pc = 0; pc < owners.size(); ++pc) {
+    if (this->counts_[pc] == 0 && this->nanos_[pc] == 0) {
+      continue;
+    }
+    Stats& stats = byLine[{src.str(src.functions()[owners[pc]].file), lines[pc]}];
+    stats.instructions += this->counts_[pc];
+    stats.nanos += this->nanos_[pc];
+  }
+  for (auto const& [key, stats] : byLine) {
+    result.emplace_back(LineStats{std::string(std::get<0>(key)), std::get<1>(key), stats});
+  }
+  return result;
+}
+
+void Profiler::writeCollapsed(std::ostream& out, Metric const metric) const {
+  if (!this->source_) {
+    return;
+  }
+  Source const& src = *this->source_;
+  for (auto const& [stack, stats] : this->stacks_) {
+    uint64_t const value = metric == Metric::Instructions ? stats.instructions : stats.nanos;
+    if (value == 0 || stack.empty()) {
+      continue;
+    }
+    std::string line;
+    for (uint32_t const function : stack) {
+      if (!line.empty()) {
+        line += ';';
+      }
+      line += src.str(src.functions()[function].name);
+    }
+    out << fmt::format("{} {}\n", line, value);
+  }
+}
+
+}
@@ -0,0 +1,93 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <map>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include "Source.hpp"
+
+namespace donut {
+
+struct CallFrame;
+
+// Counts executed instructions for every pc, and samples wall time every kSampleInterval
+// instructions and whenever the call stack changes.
+// Results are aggregated per function, per source line, and per call stack.
+// Enable it by Machine::setProfiler(); the machine runs a separate loop without any hooks when it is not set.
+class Profiler final {
+public:
+  static constexpr uint32_t kSampleInterval = 256;
+
+  enum class Metric {
+    Instructions,
+    Nanoseconds,
+  };
+
+  struct Stats final {
+    uint64_t instructions = 0;
+    uint64_t nanos = 0;
+  };
+
+  struct FunctionStats final {
+    std::string name;
+    std::string file;
+    uint32_t line;
+    Stats self;
+  };
+
+  struct LineStats final {
+    std::string file;
+    uint32_t line;
+    Stats stats;
+  };
+
+public:
+  Profiler() = default;
+  Profiler(Profiler const&) = delete;
+  Profiler(Profiler&&) = delete;
+  Profiler& operator=(Profiler const&) = delete;
+  Profiler& operator=(Profiler&&) = delete;
+
+public:
+  // Results are cleared when the source changes.
+  void attach(std::shared_ptr<Source const> source);
+  void reset();
+
+public: // used by Machine
+  void begin() {
+    this->last_ = std::chrono::steady_clock::now();
+  }
+  // Returns true when it is time to sample().
+  bool count(uint32_t const pc) {
+    this->counts_[pc]++;
+    return ++this->pending_ >= kSampleInterval;
+  }
+  // Attributes the time and instructions since the last sample to the stack, and the time to pc.
+  void sample(CallFrame const* frames, size_t numFrames, uint32_t pc);
+
+public:
+  [[nodiscard]] std::vector<FunctionStats> functions() const;
+  [[nodiscard]] std::vector<LineStats> lines() const;
+  // "main;fire;aim 1234" per line, for flamegraph.pl and compatible tools.
+  void writeCollapsed(std::ostream& out, Metric metric) const;
+
+private:
+  std::shared_ptr<Source const> source_;
+  std::vector<uint64_t> counts_; // by pc
+  std::vector<uint64_t> nanos_;  // by pc
+  std::map<std::vector<uint32_t>, Stats> stacks_; // by function indices from the bottom
+  std::vector<uint32_t> key_;
+  std::chrono::steady_clock::time_point last_;
+  uint32_t pending_ = 0;
+};
+
+}
@@ -0,0 +1,36 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include "../../util/Bench.hpp"
+#include "./Machine.hpp"
+#include "./Profiler.hpp"
+#include "../compiler/Driver.hpp"
+
+BENCH(DonutProfilerOverhead) {
+  auto src = std::make_shared<donut::Source>(donut::Driver(1).build({"resources/test/spawn/ring.donut"}));
+  donut::Profiler profiler;
+  double base = 0;
+  for (bool const on : {false, true}) {
+    donut::Clock<3600> clock;
+    donut::Machine<3600> machine(clock);
+    machine.registerNative("bullet", [](donut::Box const*, uint8_t) -> donut::Box { return 0; });
+    machine.load(src);
+    machine.setProfiler(on ? &profiler : nullptr);
+    for (int i = 0; i < 16; ++i) {
+      machine.spawn("loop");
+    }
+    double const secs = util::measure([&]() {
+      clock.tick();
+      machine.step();
+    });
+    if (!on) {
+      base = secs;
+    }
+    std::printf("profiler %-3s %8.2f us/frame  (x%.2f)\n", on ? "on" : "off", secs * 1e6, secs / base);
+  }
+}
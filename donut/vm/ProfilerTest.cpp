@@ -0,0 +1,79 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "./Machine.hpp"
+#include "./Profiler.hpp"
+#include "../compiler/Driver.hpp"
+
+namespace donut {
+
+TEST(DonutProfilerTest, ProfileTest) {
+  auto src = std::make_shared<Source>(Driver(1, nullptr, false).build({
+      "resources/test/stage/main.donut",
+      "resources/test/stage/util.donut",
+  }));
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  Profiler profiler;
+  machine.registerNative("emit", [](Box const*, uint8_t) -> Box { return 0; });
+  machine.load(src);
+  machine.spawn("main");
+  for (int i = 0; i < 15; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  // Only the steps while it is set are profiled.
+  uint64_t const before = machine.numExecuted();
+  machine.setProfiler(&profiler);
+  for (int i = 0; i < 25; ++i) {
+    clock.tick();
+    machine.step();
+  }
+  machine.setProfiler(nullptr);
+  uint64_t const executed = machine.numExecuted() - before;
+
+  uint64_t total = 0;
+  for (Profiler::FunctionStats const& f : profiler.functions()) {
+    total += f.self.instructions;
+    if (f.name == "sum") {
+      EXPECT_EQ("resources/test/stage/util.donut", f.file);
+      EXPECT_EQ(6, f.line);
+      EXPECT_LT(100, f.self.instructions);
+    }
+  }
+  EXPECT_EQ(executed, total);
+
+  // `s = s + i;` runs for 4 of the 10 iterations.
+  uint64_t byLine = 0;
+  uint64_t loopBody = 0;
+  for (Profiler::LineStats const& l : profiler.lines()) {
+    byLine += l.stats.instructions;
+    if (l.file == "resources/test/stage/util.donut" && l.line == 11) {
+      loopBody = l.stats.instructions;
+    }
+  }
+  EXPECT_EQ(executed, byLine);
+  EXPECT_EQ(4 * 4, loopBody);
+
+  std::ostringstream out;
+  profiler.writeCollapsed(out, Profiler::Metric::Instructions);
+  std::istringstream in(out.str());
+  std::string stack;
+  uint64_t value = 0;
+  uint64_t collapsed = 0;
+  bool sawSum = false;
+  while (in >> stack >> value) {
+    collapsed += value;
+    sawSum |= stack == "main;sum";
+  }
+  EXPECT_TRUE(sawSum) << out.str();
+  EXPECT_EQ(executed, collapsed);
+}
+
+}
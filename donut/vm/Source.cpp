@@ -0,0 +1,121 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Source.hpp"
+
+namespace donut {
+
+Source Source::view(
+    std::shared_ptr<void const> owner,
+    std::span<Box const> constants,
+    std::span<Instruction const> code,
+    std::span<uint32_t const> lines,
+    std::span<Function const> functions,
+    std::span<Symbol const> natives,
+    std::string_view strings) {
+  Source src;
+  src.owner_ = std::move(owner);
+  src.constantsView_ = constants;
+  src.codeView_ = code;
+  src.linesView_ = lines;
+  src.functionsView_ = functions;
+  src.nativesView_ = natives;
+  src.stringsView_ = strings;
+  for (size_t i = 0; i < functions.size(); ++i) {
+    src.functionIndices_.emplace(Name::of(src.str(functions[i].name)), static_cast<uint32_t>(i));
+  }
+  return src;
+}
+
+uint16_t Source::constant(Box const v) {
+  this->checkWritable();
+  uint64_t const bits = v.bits();
+  auto const it = this->constantIndices_.find(bits);
+  if (it != this->constantIndices_.end()) {
+    return it->second;
+  }
+  if (this->constants_.size() > UINT16_MAX) {
+    throw std::runtime_error("Too many constants in a source.");
+  }
+  auto const idx = static_cast<uint16_t>(this->constants_.size());
+  this->constants_.emplace_back(v);
+  this->constantIndices_.emplace(bits, idx);
+  return idx;
+}
+
+uint8_t Source::native(std::string const& name) {
+  this->checkWritable();
+  for (size_t i = 0; i < this->natives_.size(); ++i) {
+    if (this->str(this->natives_[i]) == name) {
+      return static_cast<uint8_t>(i);
+    }
+  }
+  if (this->natives_.size() > UINT8_MAX) {
+    throw std::runtime_error("Too many natives in a source.");
+  }
+  this->natives_.emplace_back(this->intern(name));
+  return static_cast<uint8_t>(this->natives_.size() - 1);
+}
+
+uint32_t Source::addFunction(std::string const& name, uint8_t const arity, uint8_t const registers, std::vector<Instruction> const& code, DebugInfo const& debug) {
+  this->checkWritable();
+  Name const key = Name::of(name);
+  if (this->findFunction(key).has_value()) {
+    throw std::runtime_error(fmt::format("Function \"{}\" is already defined.", name));
+  }
+  if (registers < arity) {
+    throw std::runtime_error(fmt::format("Function \"{}\" has less registers than its arguments.", name));
+  }
+  if (!debug.lines.empty() && debug.lines.size() != code.size()) {
+    throw std::runtime_error(fmt::format("Function \"{}\" has {} lines for {} instructions.", name, debug.lines.size(), code.size()));
+  }
+  auto const entry = static_cast<uint32_t>(this->code_.size());
+  auto const idx = static_cast<uint32_t>(this->functions_.size());
+  this->code_.insert(this->code_.end(), code.begin(), code.end());
+  if (debug.lines.empty()) {
+    this->lines_.resize(this->code_.size(), debug.line);
+  } else {
+    this->lines_.insert(this->lines_.end(), debug.lines.begin(), debug.lines.end());
+  }
+  Symbol const sym = this->intern(name);
+  this->functions_.emplace_back(Function{sym, this->intern(debug.file), entry, debug.line, arity, registers, {}});
+  this->functionIndices_.emplace(key, idx);
+  return idx;
+}
+
+std::optional<uint32_t> Source::findFunction(std::string_view const name) const {
+  std::optional<Name> const key = Name::find(name);
+  return key.has_value() ? this->findFunction(key.value()) : std::optional<uint32_t>();
+}
+
+std::optional<uint32_t> Source::findFunction(Name const name) const {
+  auto const it = this->functionIndices_.find(name);
+  return it != this->functionIndices_.end() ? std::optional<uint32_t>(it->second) : std::optional<uint32_t>();
+}
+
+Symbol Source::intern(std::string_view const str) {
+  auto const it = this->symbols_.find(std::string(str));
+  if (it != this->symbols_.end()) {
+    return it->second;
+  }
+  auto const offset = static_cast<uint32_t>(this->strings_.size());
+  this->strings_.append(str);
+  Symbol const sym{offset, static_cast<uint32_t>(str.size())};
+  this->symbols_.emplace(std::string(str), sym);
+  return sym;
+}
+
+void Source::checkWritable() const {
+  if (this->owner_) {
+    throw std::runtime_error("This source is read-only.");
+  }
+}
+
+}
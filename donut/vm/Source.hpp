@@ -0,0 +1,121 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include "Instruction.hpp"
+#include "Box.hpp"
+#include "../runtime/Interner.hpp"
+
+namespace donut {
+
+// A string in Source::strings().
+struct Symbol final {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct Function final {
+  Symbol name;
+  Symbol file;       // where it is defined
+  uint32_t entry;    // index of the first instruction in Source::code()
+  uint32_t line;
+  uint8_t arity;     // arguments are passed in R[0]...R[arity-1]
+  uint8_t registers;
+  uint8_t reserved[2];
+};
+
+// Where the code of a function came from, for profilers and error messages.
+struct DebugInfo final {
+  std::string file;
+  uint32_t line = 0;
+  std::vector<uint32_t> lines; // line of each instruction; empty means all at `line`
+};
+
+// Compiled bytecode of a script module.
+// All tables are flat and pointer-free, so a Source can also be a view of a memory-mapped cache file.
+class Source final {
+public:
+  Source() = default;
+  Source(Source const&) = delete;
+  Source(Source&&) = default;
+  Source& operator=(Source const&) = delete;
+  Source& operator=(Source&&) = default;
+
+  // Makes a read-only Source that refers the tables owned by `owner`.
+  static Source view(
+      std::shared_ptr<void const> owner,
+      std::span<Box const> constants,
+      std::span<Instruction const> code,
+      std::span<uint32_t const> lines,
+      std::span<Function const> functions,
+      std::span<Symbol const> natives,
+      std::string_view strings);
+
+public:
+  uint16_t constant(Box v);
+  uint8_t native(std::string const& name);
+  uint32_t addFunction(std::string const& name, uint8_t arity, uint8_t registers, std::vector<Instruction> const& code, DebugInfo const& debug = {});
+  [[nodiscard]] std::optional<uint32_t> findFunction(std::string_view name) const;
+  [[nodiscard]] std::optional<uint32_t> findFunction(Name name) const;
+
+public:
+  [[nodiscard]] std::span<Box const> constants() const {
+    return this->owner_ ? this->constantsView_ : std::span<Box const>(this->constants_);
+  }
+  [[nodiscard]] std::span<Instruction const> code() const {
+    return this->owner_ ? this->codeView_ : std::span<Instruction const>(this->code_);
+  }
+  // Source line of each instruction.
+  [[nodiscard]] std::span<uint32_t const> lines() const {
+    return this->owner_ ? this->linesView_ : std::span<uint32_t const>(this->lines_);
+  }
+  [[nodiscard]] std::span<Function const> functions() const {
+    return this->owner_ ? this->functionsView_ : std::span<Function const>(this->functions_);
+  }
+  [[nodiscard]] std::span<Symbol const> natives() const {
+    return this->owner_ ? this->nativesView_ : std::span<Symbol const>(this->natives_);
+  }
+  [[nodiscard]] std::string_view strings() const {
+    return this->owner_ ? this->stringsView_ : std::string_view(this->strings_);
+  }
+  [[nodiscard]] std::string_view str(Symbol const& sym) const {
+    return this->strings().substr(sym.offset, sym.length);
+  }
+
+private:
+  Symbol intern(std::string_view str);
+  void checkWritable() const;
+
+private:
+  std::vector<Box> constants_;
+  std::vector<Instruction> code_;
+  std::vector<uint32_t> lines_;
+  std::vector<Function> functions_;
+  std::vector<Symbol> natives_;
+  std::string strings_;
+  std::unordered_map<uint64_t, uint16_t> constantIndices_; // by bit pattern, to tell 0.0 from -0.0
+  std::unordered_map<Name, uint32_t> functionIndices_; // views have one too
+  std::unordered_map<std::string, Symbol> symbols_; // file names are shared by many functions
+private:
+  std::shared_ptr<void const> owner_;
+  std::span<Box const> constantsView_;
+  std::span<Instruction const> codeView_;
+  std::span<uint32_t const> linesView_;
+  std::span<Function const> functionsView_;
+  std::span<Symbol const> nativesView_;
+  std::string_view stringsView_;
+};
+
+}
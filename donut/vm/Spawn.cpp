@@ -0,0 +1,175 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include <numbers>
+#include <algorithm>
+#include "Spawn.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define DONUT_SPAWN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace donut {
+
+namespace {
+
+// Directions are rotated 4 lanes at a time, and recomputed exactly every kAnchor bullets
+// so that rounding errors do not pile up.
+constexpr uint32_t kLanes = 4;
+constexpr uint32_t kAnchor = 64;
+constexpr uint32_t kMaxBullets = 4096;
+
+constexpr double kRadPerDeg = std::numbers::pi / 180.0;
+
+uint32_t countOf(double const n) {
+  if (!(n >= 1.0)) {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::min<double>(n, kMaxBullets));
+}
+
+void resize(SpawnBatch& out, uint32_t const n) {
+  out.x.resize(n);
+  out.y.resize(n);
+  out.vx.resize(n);
+  out.vy.resize(n);
+}
+
+// vx *= speed, vy *= speed
+void scale(SpawnBatch& out, float const speed) {
+  size_t const n = out.size();
+  float* const vx = out.vx.data();
+  float* const vy = out.vy.data();
+  size_t i = 0;
+#if DONUT_SPAWN_SSE2
+  __m128 const s = _mm_set1_ps(speed);
+  for (; i + kLanes <= n; i += kLanes) {
+    _mm_storeu_ps(vx + i, _mm_mul_ps(_mm_loadu_ps(vx + i), s));
+    _mm_storeu_ps(vy + i, _mm_mul_ps(_mm_loadu_ps(vy + i), s));
+  }
+#endif
+  for (; i < n; ++i) {
+    vx[i] *= speed;
+    vy[i] *= speed;
+  }
+}
+
+void place(SpawnBatch& out, float const x, float const y) {
+  std::fill(out.x.begin(), out.x.end(), x);
+  std::fill(out.y.begin(), out.y.end(), y);
+}
+
+}
+
+std::optional<SpawnKind> spawnKindOf(std::string_view const name) {
+  if (name == "ring") {
+    return SpawnKind::Ring;
+  }
+  if (name == "fan") {
+    return SpawnKind::Fan;
+  }
+  if (name == "spread") {
+    return SpawnKind::Spread;
+  }
+  return std::optional<SpawnKind>();
+}
+
+uint8_t arityOf(SpawnKind const kind) {
+  switch (kind) {
+    case SpawnKind::Ring: return 5;
+    case SpawnKind::Fan: return 6;
+    case SpawnKind::Spread: return 6;
+  }
+  return 0;
+}
+
+void directions(float* const dx, float* const dy, uint32_t const n, double const start, double const step) {
+  uint32_t i = 0;
+  while (i + kLanes <= n) {
+    alignas(16) float c[kLanes];
+    alignas(16) float s[kLanes];
+    for (uint32_t l = 0; l < kLanes; ++l) {
+      double const angle = start + step * (i + l);
+      c[l] = static_cast<float>(std::cos(angle));
+      s[l] = static_cast<float>(std::sin(angle));
+    }
+    auto const rc = static_cast<float>(std::cos(step * kLanes));
+    auto const rs = static_cast<float>(std::sin(step * kLanes));
+    uint32_t const end = std::min(n, i + kAnchor);
+#if DONUT_SPAWN_SSE2
+    __m128 vc = _mm_load_ps(c);
+    __m128 vs = _mm_load_ps(s);
+    __m128 const vrc = _mm_set1_ps(rc);
+    __m128 const vrs = _mm_set1_ps(rs);
+    for (; i + kLanes <= end; i += kLanes) {
+      _mm_storeu_ps(dx + i, vc);
+      _mm_storeu_ps(dy + i, vs);
+      __m128 const nc = _mm_sub_ps(_mm_mul_ps(vc, vrc), _mm_mul_ps(vs, vrs));
+      __m128 const ns = _mm_add_ps(_mm_mul_ps(vs, vrc), _mm_mul_ps(vc, vrs));
+      vc = nc;
+      vs = ns;
+    }
+#else
+    for (; i + kLanes <= end; i += kLanes) {
+      for (uint32_t l = 0; l < kLanes; ++l) {
+        dx[i + l] = c[l];
+        dy[i + l] = s[l];
+        float const nc = c[l] * rc - s[l] * rs;
+        float const ns = s[l] * rc + c[l] * rs;
+        c[l] = nc;
+        s[l] = ns;
+      }
+    }
+#endif
+  }
+  for (; i < n; ++i) {
+    double const angle = start + step * i;
+    dx[i] = static_cast<float>(std::cos(angle));
+    dy[i] = static_cast<float>(std::sin(angle));
+  }
+}
+
+void spawn(SpawnBatch& out, SpawnKind const kind, double const* const args) {
+  auto const x = static_cast<float>(args[0]);
+  auto const y = static_cast<float>(args[1]);
+  uint32_t const n = countOf(args[2]);
+  resize(out, n);
+  if (n == 0) {
+    return;
+  }
+  place(out, x, y);
+  switch (kind) {
+    case SpawnKind::Ring: {
+      directions(out.vx.data(), out.vy.data(), n, args[4] * kRadPerDeg, 2.0 * std::numbers::pi / n);
+      scale(out, static_cast<float>(args[3]));
+      break;
+    }
+    case SpawnKind::Fan: {
+      double const width = args[5] * kRadPerDeg;
+      double const step = n > 1 ? width / (n - 1) : 0.0;
+      double const start = args[4] * kRadPerDeg - (n > 1 ? width / 2 : 0.0);
+      directions(out.vx.data(), out.vy.data(), n, start, step);
+      scale(out, static_cast<float>(args[3]));
+      break;
+    }
+    case SpawnKind::Spread: {
+      auto const c = static_cast<float>(std::cos(args[3] * kRadPerDeg));
+      auto const s = static_cast<float>(std::sin(args[3] * kRadPerDeg));
+      double const speed0 = args[4];
+      double const delta = n > 1 ? (args[5] - args[4]) / (n - 1) : 0.0;
+      for (uint32_t i = 0; i < n; ++i) {
+        auto const speed = static_cast<float>(speed0 + delta * i);
+        out.vx[i] = c * speed;
+        out.vy[i] = s * speed;
+      }
+      break;
+    }
+  }
+}
+
+}
@@ -0,0 +1,49 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+
+namespace donut {
+
+// Bullet groups made by one Spawn instruction. Angles are in degrees.
+enum class SpawnKind : uint8_t {
+  Ring = 0, // ring(x, y, n, speed, angle): n ways around the circle, the first towards `angle`
+  Fan,      // fan(x, y, n, speed, angle, width): n ways over `width` degrees centered on `angle`
+  Spread,   // spread(x, y, n, angle, speed0, speed1): n bullets towards `angle`, speeds from speed0 to speed1
+};
+
+[[nodiscard]] std::optional<SpawnKind> spawnKindOf(std::string_view name);
+[[nodiscard]] uint8_t arityOf(SpawnKind kind);
+
+// Bullets of a group in structure-of-arrays layout, handed to the host at once.
+// Its buffers are reused, so spawning does not allocate once they are large enough.
+struct SpawnBatch final {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> vx;
+  std::vector<float> vy;
+  [[nodiscard]] size_t size() const { return this->x.size(); }
+  void clear() {
+    this->x.clear();
+    this->y.clear();
+    this->vx.clear();
+    this->vy.clear();
+  }
+};
+
+// Fills `out` with the group; `args` are the arguments of the script function.
+void spawn(SpawnBatch& out, SpawnKind kind, double const* args);
+
+// Unit vectors towards start + step * i (radians) for i in [0, n).
+// Vectorized with SSE2 where available; both paths give the same results.
+void directions(float* dx, float* dy, uint32_t n, double start, double step);
+
+}
@@ -0,0 +1,76 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include "../../util/Bench.hpp"
+#include "./Machine.hpp"
+#include "../compiler/Driver.hpp"
+
+BENCH(DonutSpawnRing) {
+  auto src = std::make_shared<donut::Source>(donut::Driver(1).build({"resources/test/spawn/ring.donut"}));
+  constexpr int kFibers = 16;
+  for (char const* entry : {"loop", "batch"}) {
+    std::vector<float> vx;
+    std::vector<float> vy;
+    donut::Clock<3600> clock;
+    donut::Machine<3600> machine(clock);
+    machine.registerNative("bullet", [&](donut::Box const* args, uint8_t) -> donut::Box {
+      double const angle = args[3].toNumber() * std::numbers::pi / 180;
+      vx.emplace_back(static_cast<float>(args[2].toNumber() * std::cos(angle)));
+      vy.emplace_back(static_cast<float>(args[2].toNumber() * std::sin(angle)));
+      return 0;
+    });
+    machine.setSpawner([&](donut::SpawnBatch const& batch) {
+      vx.insert(vx.end(), batch.vx.begin(), batch.vx.end());
+      vy.insert(vy.end(), batch.vy.begin(), batch.vy.end());
+    });
+    machine.load(src);
+    for (int i = 0; i < kFibers; ++i) {
+      machine.spawn(entry);
+    }
+    double const secs = util::measure([&]() {
+      vx.clear();
+      vy.clear();
+      clock.tick();
+      machine.step();
+    });
+    std::printf("%-6s %8.1f ns/bullet\n", entry, secs * 1e9 / (kFibers * 64));
+  }
+}
+
+// 1024 enemies stepped on 1 to 8 workers; the spawner only counts.
+BENCH(DonutSpawnParallel) {
+  auto src = std::make_shared<donut::Source>(donut::Driver(1).build({"resources/test/spawn/actors.donut"}));
+  constexpr int kEnemies = 1024;
+  std::printf("%-8s %12s %8s\n", "workers", "us/frame", "speedup");
+  double base = 0;
+  for (size_t const numWorkers : {0, 1, 2, 4, 8}) {
+    donut::Clock<3600> clock;
+    donut::Machine<3600> machine(clock);
+    size_t numBullets = 0;
+    machine.setSpawner([&](donut::SpawnBatch const& batch) { numBullets += batch.size(); });
+    machine.load(src);
+    for (int i = 0; i < kEnemies; ++i) {
+      machine.spawn("enemy", {donut::Box::integer(i)});
+    }
+    std::unique_ptr<util::ThreadPool> pool = numWorkers > 0 ? std::make_unique<util::ThreadPool>(numWorkers) : nullptr;
+    double const secs = util::measure([&]() {
+      clock.tick();
+      if (pool) {
+        machine.step(*pool);
+      } else {
+        machine.step();
+      }
+    });
+    if (numWorkers == 0) {
+      base = secs;
+    }
+    std::printf("%-8s %12.1f   x%.2f\n", numWorkers == 0 ? "step()" : std::to_string(numWorkers).c_str(), secs * 1e6, base / secs);
+  }
+}
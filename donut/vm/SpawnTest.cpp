@@ -0,0 +1,150 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include "./Spawn.hpp"
+#include "./Machine.hpp"
+#include "../compiler/Driver.hpp"
+
+namespace donut {
+
+TEST(DonutSpawnTest, DirectionsTest) {
+  for (uint32_t const n : {1u, 3u, 4u, 17u, 64u, 1000u}) {
+    std::vector<float> dx(n);
+    std::vector<float> dy(n);
+    double const start = 0.3;
+    double const step = 2.0 * std::numbers::pi / n;
+    directions(dx.data(), dy.data(), n, start, step);
+    for (uint32_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(std::cos(start + step * i), dx[i], 1e-5) << n << ":" << i;
+      EXPECT_NEAR(std::sin(start + step * i), dy[i], 1e-5) << n << ":" << i;
+    }
+  }
+}
+
+TEST(DonutSpawnTest, KindTest) {
+  SpawnBatch batch;
+  double const ring[] = {10, 20, 4, 2, 90};
+  spawn(batch, SpawnKind::Ring, ring);
+  ASSERT_EQ(4, batch.size());
+  EXPECT_EQ(10, batch.x[3]);
+  EXPECT_EQ(20, batch.y[3]);
+  EXPECT_NEAR(0, batch.vx[0], 1e-6);
+  EXPECT_NEAR(2, batch.vy[0], 1e-6);
+  EXPECT_NEAR(-2, batch.vx[1], 1e-6);
+  EXPECT_NEAR(0, batch.vy[1], 1e-6);
+
+  double const fan[] = {0, 0, 3, 1, 0, 90};
+  spawn(batch, SpawnKind::Fan, fan);
+  ASSERT_EQ(3, batch.size());
+  EXPECT_NEAR(std::cos(-std::numbers::pi / 4), batch.vx[0], 1e-6);
+  EXPECT_NEAR(std::sin(-std::numbers::pi / 4), batch.vy[0], 1e-6);
+  EXPECT_NEAR(1, batch.vx[1], 1e-6);
+  EXPECT_NEAR(std::sin(std::numbers::pi / 4), batch.vy[2], 1e-6);
+
+  double const spread[] = {0, 0, 3, 180, 1, 3};
+  spawn(batch, SpawnKind::Spread, spread);
+  ASSERT_EQ(3, batch.size());
+  EXPECT_NEAR(-1, batch.vx[0], 1e-6);
+  EXPECT_NEAR(-2, batch.vx[1], 1e-6);
+  EXPECT_NEAR(-3, batch.vx[2], 1e-6);
+
+  double const none[] = {0, 0, -1, 1, 0};
+  spawn(batch, SpawnKind::Ring, none);
+  EXPECT_EQ(0, batch.size());
+}
+
+TEST(DonutSpawnTest, ScriptTest) {
+  auto src = std::make_shared<Source>(Driver(1).build({"resources/test/spawn/ring.donut"}));
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<std::pair<float, float>> one;
+  std::vector<std::pair<float, float>> bulk;
+  size_t numBatches = 0;
+  machine.registerNative("bullet", [&](Box const* args, uint8_t) -> Box {
+    double const angle = args[3].toNumber() * std::numbers::pi / 180;
+    one.emplace_back(static_cast<float>(args[2].toNumber() * std::cos(angle)), static_cast<float>(args[2].toNumber() * std::sin(angle)));
+    return 0;
+  });
+  machine.setSpawner([&](SpawnBatch const& batch) {
+    numBatches++;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      bulk.emplace_back(batch.vx[i], batch.vy[i]);
+    }
+  });
+  machine.load(src);
+  machine.spawn("loop");
+  machine.spawn("batch");
+  clock.tick();
+  machine.step();
+  ASSERT_EQ(64, one.size());
+  ASSERT_EQ(64, bulk.size());
+  EXPECT_EQ(1, numBatches);
+  for (size_t i = 0; i < one.size(); ++i) {
+    EXPECT_NEAR(one[i].first, bulk[i].first, 1e-5) << i;
+    EXPECT_NEAR(one[i].second, bulk[i].second, 1e-5) << i;
+  }
+}
+
+namespace {
+
+// Bits of every bullet spawned by 200 enemies over 240 frames, with a leap in the middle.
+std::vector<uint32_t> runActors(util::ThreadPool* pool, uint64_t& executed) {
+  auto src = std::make_shared<Source>(Driver(1).build({"resources/test/spawn/actors.donut"}));
+  Clock<3600> clock;
+  Machine<3600> machine(clock);
+  std::vector<uint32_t> bits;
+  machine.setSpawner([&](SpawnBatch const& batch) {
+    bits.emplace_back(static_cast<uint32_t>(batch.size()));
+    for (std::vector<float> const* v : {&batch.x, &batch.y, &batch.vx, &batch.vy}) {
+      size_t const at = bits.size();
+      bits.resize(at + v->size());
+      std::memcpy(bits.data() + at, v->data(), sizeof(float) * v->size());
+    }
+  });
+  machine.load(src);
+  for (int i = 0; i < 200; ++i) {
+    machine.spawn("enemy", {Box::integer(i)});
+  }
+  auto const step = [&]() {
+    clock.tick();
+    if (pool) {
+      machine.step(*pool);
+    } else {
+      machine.step();
+    }
+  };
+  for (int i = 0; i < 120; ++i) {
+    step();
+  }
+  clock.leap(60);
+  for (int i = 0; i < 120; ++i) {
+    step();
+  }
+  executed = machine.numExecuted();
+  return bits;
+}
+
+}
+
+// Bullets are spawned in the same order as step(), whatever the number of workers.
+TEST(DonutSpawnTest, ParallelTest) {
+  uint64_t expectedExecuted = 0;
+  std::vector<uint32_t> const expected = runActors(nullptr, expectedExecuted);
+  ASSERT_LT(10000, expected.size());
+  for (size_t const numWorkers : {1, 2, 4, 7}) {
+    util::ThreadPool pool(numWorkers);
+    uint64_t executed = 0;
+    EXPECT_EQ(expected, runActors(&pool, executed)) << numWorkers << " workers";
+    EXPECT_EQ(expectedExecuted, executed) << numWorkers << " workers";
+  }
+}
+
+}
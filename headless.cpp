@@ -0,0 +1,191 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+// Runs a stage without a window or a GPU, as fast as the CPU allows, and reports the time taken by each phase.
+//
+//   taiju_headless [options] [scripts...]
+//     --frames N      frames to run (default: 3600)
+//     --actors N      fibers of the entry function to spawn, given their index (default: 64)
+//     --entry NAME    entry function taking one argument (default: enemy)
+//     --workers N     step the fibers and move the bullets on N workers; 0 runs them on this thread (default: 0)
+//     --input FILE    replay a recorded input log
+//     --seed N        or play a scripted input made from the seed (default: 1)
+//     --record FILE   save the input log of the run
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "util/ThreadPool.hpp"
+#include "donut/compiler/Driver.hpp"
+#include "donut/vm/Machine.hpp"
+#include "taiju/stage/Stage.hpp"
+#include "taiju/stage/Scenario.hpp"
+#include "taiju/stage/Conductor.hpp"
+#include "taiju/stage/Input.hpp"
+
+namespace {
+
+struct Options final {
+  uint32_t frames = 3600;
+  uint32_t actors = 64;
+  std::string entry = "enemy";
+  size_t workers = 0;
+  std::string input;
+  uint32_t seed = 1;
+  std::string record;
+  std::vector<std::string> scripts;
+};
+
+Options parse(int const argc, char** const argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    auto const value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument(fmt::format("{} needs a value.", arg));
+      }
+      return argv[++i];
+    };
+    if (arg == "--frames") {
+      opts.frames = static_cast<uint32_t>(std::stoul(value()));
+    } else if (arg == "--actors") {
+      opts.actors = static_cast<uint32_t>(std::stoul(value()));
+    } else if (arg == "--entry") {
+      opts.entry = value();
+    } else if (arg == "--workers") {
+      opts.workers = std::stoul(value());
+    } else if (arg == "--input") {
+      opts.input = value();
+    } else if (arg == "--seed") {
+      opts.seed = static_cast<uint32_t>(std::stoul(value()));
+    } else if (arg == "--record") {
+      opts.record = value();
+    } else if (arg.starts_with("--")) {
+      throw std::invalid_argument(fmt::format("Unknown option: {}", arg));
+    } else {
+      opts.scripts.emplace_back(arg);
+    }
+  }
+  if (opts.scripts.empty()) {
+    opts.scripts.emplace_back("resources/test/spawn/actors.donut");
+  }
+  return opts;
+}
+
+// Phases of a frame, in the order they run.
+enum Phase : size_t {
+  Scripts = 0,
+  Witches,
+  Scenario,
+  Bullets,
+  Interact,
+  Commit,
+  NumPhases,
+};
+
+char const* const kPhaseNames[NumPhases] = {"scripts", "witches", "scenario", "bullets", "interact", "commit"};
+
+// Bullets made by the scripts.
+constexpr taiju::Real kBulletRadius = 3;
+constexpr float kBulletDamage = 1;
+
+int run(Options const& opts) {
+  using Clock = std::chrono::steady_clock;
+  auto const stage = std::make_shared<taiju::Stage>();
+  auto const scenario = std::make_shared<taiju::Scenario>(stage);
+  taiju::Conductor conductor(stage, scenario);
+  conductor.init();
+
+  donut::Machine<3600> machine(stage->clock());
+  machine.setSpawner([&stage](donut::SpawnBatch const& batch) {
+    taiju::BulletPool& bullets = stage->bullets();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      bullets.spawn(taiju::Pos{batch.x[i], batch.y[i]}, taiju::Pos{batch.vx[i], batch.vy[i]}, kBulletRadius, kBulletDamage);
+    }
+  });
+  machine.load(std::make_shared<donut::Source>(donut::Driver(1).build(opts.scripts)));
+  for (uint32_t i = 0; i < opts.actors; ++i) {
+    machine.spawn(opts.entry, {donut::Box::integer(static_cast<int32_t>(i))});
+  }
+  std::unique_ptr<util::ThreadPool> pool = opts.workers > 0 ? std::make_unique<util::ThreadPool>(opts.workers) : nullptr;
+
+  taiju::InputLog const input = opts.input.empty() ? taiju::InputLog::scripted(opts.seed, opts.frames) : taiju::InputLog::load(opts.input);
+  taiju::InputLog record;
+
+  double phases[NumPhases] = {};
+  size_t maxBullets = 0;
+  auto const beg = Clock::now();
+  for (uint32_t frame = 0; frame < opts.frames; ++frame) {
+    stage->clock().tick();
+    stage->input() = input.at(frame);
+    record.record(stage->input());
+    auto t = Clock::now();
+    auto const lap = [&t, &phases](Phase const phase) {
+      auto const now = Clock::now();
+      phases[phase] += std::chrono::duration<double>(now - t).count();
+      t = now;
+    };
+    conductor.rewind();
+    if (pool) {
+      machine.step(*pool);
+    } else {
+      machine.step();
+    }
+    lap(Scripts);
+    conductor.moveWitches();
+    lap(Witches);
+    conductor.moveScenario();
+    lap(Scenario);
+    if (pool) {
+      conductor.moveBullets(*pool);
+    } else {
+      conductor.moveBullets();
+    }
+    lap(Bullets);
+    conductor.interact();
+    lap(Interact);
+    conductor.commit();
+    lap(Commit);
+    maxBullets = std::max(maxBullets, stage->bullets().count());
+  }
+  double const total = std::chrono::duration<double>(Clock::now() - beg).count();
+
+  if (!opts.record.empty()) {
+    record.save(opts.record);
+  }
+  std::printf("real      %s\n", TAIJU_FIXED == 0 ? "float" : TAIJU_FIXED == 16 ? "fixed 16.16" : "fixed 32.32");
+  std::printf("frames    %u\n", opts.frames);
+  std::printf("seconds   %.3f\n", total);
+  std::printf("fps       %.1f\n", opts.frames / total);
+  std::printf("bullets   %zu at the end, %zu at most\n", stage->bullets().count(), maxBullets);
+  std::printf("hash      %016llx\n", static_cast<unsigned long long>(stage->bullets().hash()));
+  std::printf("hp        momiji %.1f, kaede %.1f\n", stage->world().get<taiju::Health>(stage->momiji()).hp,
+              stage->world().get<taiju::Health>(stage->kaede()).hp);
+  std::printf("%-10s %12s %8s\n", "phase", "us/frame", "share");
+  for (size_t phase = 0; phase < NumPhases; ++phase) {
+    std::printf("%-10s %12.1f %7.1f%%\n", kPhaseNames[phase], phases[phase] * 1e6 / opts.frames, phases[phase] * 100 / total);
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+  try {
+    return run(parse(argc, argv));
+  } catch (std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
@@ -1,11 +0,0 @@
-/* coding: utf-8 */
-/**
- * wakaba
- *
- * Copyright 2020-, Kaede Fujisaki
- */
-#include "Actor.hpp"
-
-namespace taiju {
-
-}
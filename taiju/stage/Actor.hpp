@@ -1,17 +0,0 @@
-/* coding: utf-8 */
-/**
- * wakaba
- *
- * Copyright 2020-, Kaede Fujisaki
- */
-#pragma once
-
-#include "Geom.hpp"
-
-namespace taiju {
-
-class Actor {
-
-};
-
-}
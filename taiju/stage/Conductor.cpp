@@ -5,19 +5,71 @@
  * Copyright 2020-, Kaede Fujisaki
  */
 #include "Conductor.hpp"
+#include "Scenario.hpp"
+#include "Interact.hpp"
 
 namespace taiju {
 
 Conductor::Conductor(std::shared_ptr<Stage> stage, std::shared_ptr<Scenario> scenario)
 :stage_(std::move(stage))
 ,scenario_(std::move(scenario))
+,leap_(stage_->clock().leap())
 {
 }
 
 void Conductor::init() {
+  this->stage_->init();
+  this->scenario_->init();
 }
 
 void Conductor::move() {
+  this->rewind();
+  this->moveWitches();
+  this->moveScenario();
+  this->moveBullets();
+  this->interact();
+  this->commit();
 }
 
-}
\ No newline at end of file
+void Conductor::move(util::ThreadPool& pool) {
+  this->rewind();
+  this->moveWitches();
+  this->moveScenario();
+  this->moveBullets(pool);
+  this->interact();
+  this->commit();
+}
+
+void Conductor::rewind() {
+  if (this->leap_ != this->stage_->clock().leap()) {
+    this->leap_ = this->stage_->clock().leap();
+    this->stage_->world().restore();
+    this->stage_->bullets().rewind(this->stage_->clock().current() - 1);
+  }
+}
+
+void Conductor::moveWitches() {
+  Momiji::move(this->stage_->world(), this->stage_->input());
+}
+
+void Conductor::moveScenario() {
+  this->scenario_->move();
+}
+
+void Conductor::moveBullets() {
+  this->stage_->bullets().move(this->stage_->clock().current(), kBulletMargin);
+}
+
+void Conductor::moveBullets(util::ThreadPool& pool) {
+  this->stage_->bullets().move(this->stage_->clock().current(), kBulletMargin, pool);
+}
+
+void Conductor::interact() {
+  taiju::interact(*this->stage_);
+}
+
+void Conductor::commit() {
+  this->stage_->world().commit();
+}
+
+}
@@ -9,6 +9,10 @@
 #include <memory>
 #include "Stage.hpp"
 
+namespace util {
+class ThreadPool;
+}
+
 namespace taiju {
 
 class Scenario;
@@ -17,9 +21,29 @@ class Conductor final {
 DEF(std::shared_ptr<Stage>, stage);
 DEF(std::shared_ptr<Scenario>, scenario);
 public:
+  // Bullets farther out of the field than this are removed.
+  static constexpr Real kBulletMargin = 32;
   Conductor(std::shared_ptr<Stage> stage, std::shared_ptr<Scenario> scenario);
   void init();
+  // Runs the phases below in order. Call it after Clock::tick.
   void move();
+  // Same as above, with the bullets moved on the pool. The result does not depend on it.
+  void move(util::ThreadPool& pool);
+
+public:
+  // Brings the world and the bullets back to the frame before the current one if the clock has leapt since
+  // the last call. Call it after Clock::tick, before anything else in the frame changes them: scripts spawn bullets.
+  void rewind();
+  void moveWitches();
+  void moveScenario();
+  void moveBullets();
+  void moveBullets(util::ThreadPool& pool);
+  void interact();
+  // Records the frame into the history of the world.
+  void commit();
+
+private:
+  uint32_t leap_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "./Conductor.hpp"
+#include "./Scenario.hpp"
+#include "../../donut/compiler/Driver.hpp"
+#include "../../donut/vm/Machine.hpp"
+
+namespace taiju {
+
+namespace {
+bool same(Pos const a, Pos const b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+// Runs the actors of the headless benchmark for `frames` frames, going back to `to` once at `at`,
+// and returns the hash of the bullets.
+uint64_t runActors(uint32_t const frames, uint32_t const at, uint32_t const to) {
+  auto const stage = std::make_shared<Stage>();
+  auto const scenario = std::make_shared<Scenario>(stage);
+  Conductor conductor(stage, scenario);
+  conductor.init();
+  donut::Machine<3600> machine(stage->clock());
+  machine.setSpawner([&stage](donut::SpawnBatch const& batch) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+      stage->bullets().spawn(Pos{batch.x[i], batch.y[i]}, Pos{batch.vx[i], batch.vy[i]}, 3, 1);
+    }
+  });
+  machine.load(std::make_shared<donut::Source>(donut::Driver(1).build({"resources/test/spawn/actors.donut"})));
+  for (int32_t i = 0; i < 16; ++i) {
+    machine.spawn("enemy", {donut::Box::integer(i)});
+  }
+  bool leapt = false;
+  while (stage->clock().current() < frames) {
+    if (!leapt && stage->clock().current() == at) {
+      stage->clock().leap(to);
+      leapt = true;
+    }
+    stage->clock().tick();
+    conductor.rewind();
+    machine.step();
+    conductor.move();
+  }
+  return stage->bullets().hash();
+}
+}
+
+TEST(TaijuConductorTest, RewindTest) {
+  auto const stage = std::make_shared<Stage>();
+  auto const scenario = std::make_shared<Scenario>(stage);
+  Conductor conductor(stage, scenario);
+  conductor.init();
+  stage->input() = Input{Button::Right};
+  std::vector<Pos> trail;
+  for (uint32_t frame = 1; frame <= 20; ++frame) {
+    stage->clock().tick();
+    conductor.move();
+    trail.emplace_back(stage->world().get<Body>(stage->momiji()).pos);
+  }
+  ASSERT_FALSE(same(trail[10], trail[19]));
+
+  // The world goes back with the clock, and the frame after the leap moves on from there.
+  stage->clock().leap(10);
+  stage->clock().tick();
+  conductor.move();
+  EXPECT_TRUE(same(trail[10], stage->world().get<Body>(stage->momiji()).pos));
+  EXPECT_TRUE(stage->world().valid(stage->kaede()));
+}
+
+TEST(TaijuConductorTest, BulletRewindTest) {
+  // Bullets spawned in the abandoned future are gone, and the scripts spawn them again as they were.
+  uint64_t const straight = runActors(120, UINT32_MAX, 0);
+  EXPECT_EQ(straight, runActors(120, 80, 40));
+  EXPECT_EQ(straight, runActors(120, 110, 1));
+  EXPECT_NE(straight, runActors(119, UINT32_MAX, 0));
+}
+
+}
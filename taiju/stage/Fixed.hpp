@@ -0,0 +1,156 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <cstdint>
+#include <compare>
+#include <concepts>
+#include <type_traits>
+
+namespace taiju {
+
+// A fixed-point number with `frac` fractional bits, stored in Raw. Products and quotients are taken in Wide.
+// Only integer arithmetic is used, so the results are the same whatever the compiler, its flags or the CPU.
+// Products round toward negative infinity, quotients toward zero, and overflows are not checked.
+template <typename Raw, typename Wide, int frac> class Fixed final {
+  static_assert(std::is_signed_v<Raw> && sizeof(Wide) >= 2 * sizeof(Raw));
+public:
+  using RawType = Raw;
+  using WideType = Wide;
+  static constexpr int kFracBits = frac;
+  static constexpr Raw kOne = Raw(1) << frac;
+
+public:
+  constexpr Fixed() = default;
+  template <std::integral I> constexpr Fixed(I const v)
+  :raw_(static_cast<Raw>(static_cast<Raw>(v) * kOne))
+  {
+  }
+  // Rounds to the nearest; the conversion of a given float always gives the same value.
+  template <std::floating_point F> constexpr Fixed(F const v)
+  :raw_(static_cast<Raw>(static_cast<double>(v) * static_cast<double>(kOne) + (v < 0 ? -0.5 : 0.5)))
+  {
+  }
+  [[nodiscard]] static constexpr Fixed fromRaw(Raw const raw) {
+    Fixed v;
+    v.raw_ = raw;
+    return v;
+  }
+
+public:
+  [[nodiscard]] constexpr Raw raw() const { return this->raw_; }
+  template <std::floating_point F> explicit constexpr operator F() const {
+    return static_cast<F>(static_cast<double>(this->raw_) / static_cast<double>(kOne));
+  }
+  // Rounds toward negative infinity.
+  template <std::integral I> explicit constexpr operator I() const {
+    return static_cast<I>(this->raw_ >> frac);
+  }
+
+public:
+  friend constexpr Fixed operator+(Fixed const a, Fixed const b) { return fromRaw(static_cast<Raw>(a.raw_ + b.raw_)); }
+  friend constexpr Fixed operator-(Fixed const a, Fixed const b) { return fromRaw(static_cast<Raw>(a.raw_ - b.raw_)); }
+  friend constexpr Fixed operator-(Fixed const a) { return fromRaw(static_cast<Raw>(-a.raw_)); }
+  friend constexpr Fixed operator*(Fixed const a, Fixed const b) {
+    return fromRaw(static_cast<Raw>((static_cast<Wide>(a.raw_) * b.raw_) >> frac));
+  }
+  friend constexpr Fixed operator/(Fixed const a, Fixed const b) {
+    return fromRaw(static_cast<Raw>((static_cast<Wide>(a.raw_) << frac) / b.raw_));
+  }
+  constexpr Fixed& operator+=(Fixed const b) { return *this = *this + b; }
+  constexpr Fixed& operator-=(Fixed const b) { return *this = *this - b; }
+  constexpr Fixed& operator*=(Fixed const b) { return *this = *this * b; }
+  constexpr Fixed& operator/=(Fixed const b) { return *this = *this / b; }
+  friend constexpr bool operator==(Fixed const a, Fixed const b) { return a.raw_ == b.raw_; }
+  friend constexpr std::strong_ordering operator<=>(Fixed const a, Fixed const b) { return a.raw_ <=> b.raw_; }
+
+private:
+  Raw raw_ = 0;
+};
+
+template <typename R, typename W, int f> [[nodiscard]] constexpr Fixed<R, W, f> abs(Fixed<R, W, f> const v) {
+  return v < 0 ? -v : v;
+}
+
+// Digit by digit, so it is exact: the largest value whose square does not exceed v.
+template <typename R, typename W, int f> [[nodiscard]] constexpr Fixed<R, W, f> sqrt(Fixed<R, W, f> const v) {
+  if (v.raw() <= 0) {
+    return Fixed<R, W, f>();
+  }
+  W n = static_cast<W>(v.raw()) << f;
+  W root = 0;
+  W bit = W(1) << (sizeof(W) * 8 - 2);
+  while (bit > n) {
+    bit >>= 2;
+  }
+  for (; bit != 0; bit >>= 2) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return Fixed<R, W, f>::fromRaw(static_cast<R>(root));
+}
+
+namespace fixed_detail {
+
+// Angles are worked on with all but two bits of R as fraction, held in W.
+template <typename R> constexpr int kAngleBits = sizeof(R) * 8 - 2;
+template <typename R, typename W> constexpr W angle(double const v) {
+  return static_cast<W>(v * static_cast<double>(W(1) << kAngleBits<R>));
+}
+template <typename R, typename W, int f> constexpr W widen(Fixed<R, W, f> const v) {
+  return static_cast<W>(v.raw()) << (kAngleBits<R> - f);
+}
+
+// Reduced to [-pi/2, pi/2], then a Taylor series up to x^13, and rounded once to f fractional bits.
+template <typename R, typename W, int f> constexpr Fixed<R, W, f> sinOf(W x) {
+  constexpr int bits = kAngleBits<R>;
+  constexpr auto q = angle<R, W>;
+  constexpr W pi = q(3.14159265358979323846);
+  constexpr W halfPi = q(1.57079632679489661923);
+  constexpr W twoPi = q(6.28318530717958647692);
+  auto const mul = [](W const a, W const b) { return (a * b) >> bits; };
+  x %= twoPi;
+  if (x > pi) {
+    x -= twoPi;
+  } else if (x < -pi) {
+    x += twoPi;
+  }
+  if (x > halfPi) {
+    x = pi - x;
+  } else if (x < -halfPi) {
+    x = -pi - x;
+  }
+  W const x2 = mul(x, x);
+  W sum = q(1.0 / 6227020800.0);
+  for (double const c : {-1.0 / 39916800.0, 1.0 / 362880.0, -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0, 1.0}) {
+    sum = mul(sum, x2) + q(c);
+  }
+  W const y = mul(sum, x);
+  return Fixed<R, W, f>::fromRaw(static_cast<R>((y + (W(1) << (bits - f - 1))) >> (bits - f)));
+}
+
+}
+
+template <typename R, typename W, int f> [[nodiscard]] constexpr Fixed<R, W, f> sin(Fixed<R, W, f> const v) {
+  return fixed_detail::sinOf<R, W, f>(fixed_detail::widen(v));
+}
+
+template <typename R, typename W, int f> [[nodiscard]] constexpr Fixed<R, W, f> cos(Fixed<R, W, f> const v) {
+  constexpr W halfPi = fixed_detail::angle<R, W>(1.57079632679489661923);
+  return fixed_detail::sinOf<R, W, f>(fixed_detail::widen(v) + halfPi);
+}
+
+using Fixed16 = Fixed<int32_t, int64_t, 16>;
+#if defined(__SIZEOF_INT128__)
+using Fixed32 = Fixed<int64_t, __int128, 32>;
+#endif
+
+}
@@ -0,0 +1,70 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "./Fixed.hpp"
+
+namespace taiju {
+
+// The same code runs at compile time, so the results do not depend on the build.
+static_assert(sin(Fixed16(0)) == 0);
+static_assert(sqrt(Fixed16(9)) == 3);
+static_assert(Fixed16(1.5f) * Fixed16(-2) == -3);
+
+TEST(TaijuFixedTest, ArithmeticTest) {
+  EXPECT_EQ(65536, Fixed16(1).raw());
+  EXPECT_EQ(-32768, Fixed16(-0.5f).raw());
+  EXPECT_EQ(Fixed16(2.5f), Fixed16(1) + Fixed16(1.5f));
+  EXPECT_EQ(Fixed16(-0.5f), Fixed16(1) - Fixed16(1.5f));
+  EXPECT_EQ(Fixed16(3.75f), Fixed16(2.5f) * Fixed16(1.5f));
+  EXPECT_EQ(Fixed16(0.25f), Fixed16(1) / Fixed16(4));
+  // To integers toward negative infinity.
+  EXPECT_EQ(2, static_cast<int>(Fixed16(2.75f)));
+  EXPECT_EQ(-3, static_cast<int>(Fixed16(-2.25f)));
+  EXPECT_TRUE(Fixed16(-1) < Fixed16(0.5f));
+  EXPECT_EQ(Fixed16(3), abs(Fixed16(-3)));
+#if defined(__SIZEOF_INT128__)
+  EXPECT_EQ(int64_t(1) << 32, Fixed32(1).raw());
+  EXPECT_EQ(Fixed32(-3.75f), Fixed32(2.5f) * Fixed32(-1.5f));
+  EXPECT_FLOAT_EQ(0.1f, static_cast<float>(Fixed32(0.1f)));
+#endif
+}
+
+TEST(TaijuFixedTest, SqrtTest) {
+  EXPECT_EQ(Fixed16(0), sqrt(Fixed16(0)));
+  EXPECT_EQ(Fixed16(0), sqrt(Fixed16(-4)));
+  EXPECT_EQ(Fixed16(12), sqrt(Fixed16(144)));
+#if defined(__SIZEOF_INT128__)
+  EXPECT_EQ(Fixed32(0.5f), sqrt(Fixed32(0.25f)));
+#endif
+  std::mt19937 rand(3);
+  std::uniform_int_distribution<int32_t> raw(1, INT32_MAX);
+  for (int i = 0; i < 1000; ++i) {
+    Fixed16 const v = Fixed16::fromRaw(raw(rand));
+    int64_t const root = sqrt(v).raw();
+    // The largest root whose square does not exceed v.
+    EXPECT_LE(root * root, int64_t(v.raw()) << 16) << v.raw();
+    EXPECT_GT((root + 1) * (root + 1), int64_t(v.raw()) << 16) << v.raw();
+  }
+}
+
+TEST(TaijuFixedTest, TrigTest) {
+  for (int i = -2000; i <= 2000; ++i) {
+    double const a = i * 0.01;
+    SCOPED_TRACE(a);
+    EXPECT_NEAR(std::sin(a), static_cast<double>(sin(Fixed16(a))), 1e-4);
+    EXPECT_NEAR(std::cos(a), static_cast<double>(cos(Fixed16(a))), 1e-4);
+#if defined(__SIZEOF_INT128__)
+    EXPECT_NEAR(std::sin(a), static_cast<double>(sin(Fixed32(a))), 1e-8);
+    EXPECT_NEAR(std::cos(a), static_cast<double>(cos(Fixed32(a))), 1e-8);
+#endif
+  }
+}
+
+}
@@ -8,7 +8,36 @@
 
 #define GLM_FORCE_SWIZZLE
 #include <glm/glm.hpp>
+#include "Fixed.hpp"
+
+// The scalar of the simulation: float, or with TAIJU_FIXED=16 or 32, 16.16 or 32.32 fixed point,
+// which gives the same results, and so the same replays, on every build.
+#if !defined(TAIJU_FIXED)
+#define TAIJU_FIXED 0
+#endif
 
 namespace taiju {
+
+#if TAIJU_FIXED == 0
+using Real = float;
 using Pos = glm::fvec2;
+#else
+#if TAIJU_FIXED == 16
+using Real = Fixed16;
+#elif TAIJU_FIXED == 32 && defined(__SIZEOF_INT128__)
+using Real = Fixed32;
+#else
+#error "TAIJU_FIXED must be 0, 16, or 32 with a compiler that has __int128."
+#endif
+struct Pos final {
+  Real x;
+  Real y;
+  [[nodiscard]] bool operator==(Pos const&) const = default;
+};
+#endif
+
+// The playfield spans [0, kFieldWidth) x [0, kFieldHeight).
+// Positions are kept within 16384 pixels of it, which all the modes can hold.
+constexpr Real kFieldWidth = 384;
+constexpr Real kFieldHeight = 448;
 }
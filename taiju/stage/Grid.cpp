@@ -0,0 +1,62 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Grid.hpp"
+#include "bullets/BulletPool.hpp"
+
+namespace taiju {
+
+Grid::Grid(Real const width, Real const height, Real const cellSize)
+:invCellSize_(cellSize > 0 ? Real(1) / cellSize : Real(0))
+,columns_(static_cast<uint32_t>(std::ceil(static_cast<float>(width) / static_cast<float>(cellSize))))
+,rows_(static_cast<uint32_t>(std::ceil(static_cast<float>(height) / static_cast<float>(cellSize))))
+{
+  if (!(cellSize > 0) || this->columns_ == 0 || this->rows_ == 0) {
+    throw std::invalid_argument(fmt::format("Invalid grid: {}x{} by {}", static_cast<float>(width), static_cast<float>(height),
+                                            static_cast<float>(cellSize)));
+  }
+  this->starts_.resize(size_t(this->columns_) * this->rows_ + 2);
+}
+
+void Grid::build(BulletPool const& bullets) {
+  std::fill(this->starts_.begin(), this->starts_.end(), 0);
+  size_t const n = bullets.size();
+  this->cells_.resize(n);
+  this->entries_.resize(n);
+  Real const* const x = bullets.x();
+  Real const* const y = bullets.y();
+  Real const* const radius = bullets.radius();
+  // Dead slots go to one more cell after the last one, which no query reaches.
+  auto const dead = static_cast<uint32_t>(this->starts_.size() - 2);
+  Real maxRadius = 0;
+  // Counts into starts_[cell + 1], so that the prefix sum gives the beginning of each cell.
+  for (uint32_t i = 0; i < n; ++i) {
+    bool const alive = bullets.alive(i);
+    uint32_t const cell = alive ? this->row(y[i]) * this->columns_ + this->column(x[i]) : dead;
+    this->cells_[i] = cell;
+    this->starts_[cell + 1]++;
+    maxRadius = std::max(maxRadius, alive ? radius[i] : Real(0));
+  }
+  for (size_t cell = 1; cell < this->starts_.size(); ++cell) {
+    this->starts_[cell] += this->starts_[cell - 1];
+  }
+  // Scatters through starts_[cell], which then ends up at the beginning of the next cell; shift it back.
+  for (uint32_t i = 0; i < n; ++i) {
+    this->entries_[this->starts_[this->cells_[i]]++] = i;
+  }
+  for (size_t cell = this->starts_.size() - 1; cell > 0; --cell) {
+    this->starts_[cell] = this->starts_[cell - 1];
+  }
+  this->starts_[0] = 0;
+  this->entries_.resize(bullets.count());
+  this->maxRadius_ = maxRadius;
+}
+
+}
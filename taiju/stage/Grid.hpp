@@ -0,0 +1,79 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Geom.hpp"
+
+namespace taiju {
+
+class BulletPool;
+
+// Uniform spatial hash over the playfield, rebuilt every frame.
+// build() counting-sorts the live bullets by cell, so each row of cells is one contiguous run of entries.
+// Bullets outside the field are kept in the border cells.
+class Grid final {
+public:
+  Grid() = delete;
+  Grid(Grid const&) = delete;
+  Grid(Grid&&) = delete;
+  Grid& operator=(Grid const&) = delete;
+  Grid& operator=(Grid&&) = delete;
+  Grid(Real width, Real height, Real cellSize);
+  ~Grid() noexcept = default;
+
+public:
+  void build(BulletPool const& bullets);
+  // Calls f(index) for every bullet that may overlap the circle; the caller does the exact test.
+  template <typename F> void query(Real const x, Real const y, Real const radius, F&& f) const {
+    Real const reach = radius + this->maxRadius_;
+    uint32_t const left = this->column(x - reach);
+    uint32_t const right = this->column(x + reach);
+    uint32_t const top = this->row(y - reach);
+    uint32_t const bottom = this->row(y + reach);
+    for (uint32_t r = top; r <= bottom; ++r) {
+      uint32_t const beg = this->starts_[r * this->columns_ + left];
+      uint32_t const end = this->starts_[r * this->columns_ + right + 1];
+      for (uint32_t i = beg; i < end; ++i) {
+        f(this->entries_[i]);
+      }
+    }
+  }
+
+public:
+  [[nodiscard]] uint32_t columns() const { return this->columns_; }
+  [[nodiscard]] uint32_t rows() const { return this->rows_; }
+  [[nodiscard]] size_t size() const { return this->entries_.size(); }
+
+private:
+  [[nodiscard]] uint32_t column(Real const x) const {
+    return clamp(x * this->invCellSize_, this->columns_);
+  }
+  [[nodiscard]] uint32_t row(Real const y) const {
+    return clamp(y * this->invCellSize_, this->rows_);
+  }
+  [[nodiscard]] static uint32_t clamp(Real const v, uint32_t const n) {
+    // Also sends NaN to the first cell.
+    if (!(v >= 0)) {
+      return 0;
+    }
+    return v >= static_cast<Real>(n) ? n - 1 : static_cast<uint32_t>(v);
+  }
+
+private:
+  Real invCellSize_;
+  uint32_t columns_;
+  uint32_t rows_;
+  Real maxRadius_ = 0;
+  std::vector<uint32_t> starts_;  // of each cell in entries_, the dead ones, and the end
+  std::vector<uint32_t> entries_; // bullet indices sorted by cell
+  std::vector<uint32_t> cells_;   // of each slot, during build()
+};
+
+}
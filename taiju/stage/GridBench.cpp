@@ -0,0 +1,62 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../util/Bench.hpp"
+#include "./Grid.hpp"
+#include "./Overlap.hpp"
+#include "./Stage.hpp"
+#include "./bullets/BulletPool.hpp"
+
+// N bullets spread over the field, queried by the 4 witches or by 256 shots:
+// all pairs vs. the grid, which is rebuilt every frame.
+BENCH(TaijuGrid) {
+  using namespace taiju;
+  std::printf("%8s %8s %6s %12s %12s %12s %8s\n", "bullets", "queries", "hits", "pairs us", "build us", "grid us", "speedup");
+  for (int const n : {1000, 3000, 10000, 30000, 100000}) {
+    std::mt19937 rand(n);
+    std::uniform_real_distribution<float> x(0, static_cast<float>(kFieldWidth));
+    std::uniform_real_distribution<float> y(0, static_cast<float>(kFieldHeight));
+    std::uniform_real_distribution<float> r(2, 8);
+    BulletPool bullets;
+    for (int i = 0; i < n; ++i) {
+      bullets.spawn(Pos{x(rand), y(rand)}, Pos{0, 0}, r(rand), 1);
+    }
+    Grid grid(kFieldWidth, kFieldHeight, Stage::kCellSize);
+    double const build = util::measure([&]() { grid.build(bullets); });
+    for (size_t const numQueries : {4, 256}) {
+      std::vector<Pos> queries;
+      for (size_t i = 0; i < numQueries; ++i) {
+        queries.emplace_back(Pos{x(rand), y(rand)});
+      }
+      Real const radius = Body::kRadius;
+      size_t hits = 0;
+      auto const test = [&](Pos const& q, uint32_t const i) {
+        hits += overlaps(q.x, q.y, radius, bullets.x()[i], bullets.y()[i], bullets.radius()[i]);
+      };
+      double const pairs = util::measure([&]() {
+        hits = 0;
+        for (Pos const& q : queries) {
+          bullets.forEach([&](uint32_t const i) { test(q, i); });
+        }
+      });
+      size_t const pairHits = hits;
+      double const total = util::measure([&]() {
+        hits = 0;
+        grid.build(bullets);
+        for (Pos const& q : queries) {
+          grid.query(q.x, q.y, radius, [&](uint32_t const i) { test(q, i); });
+        }
+      });
+      std::printf("%8d %8zu %6s %12.1f %12.1f %12.1f   x%.1f\n", n, numQueries, pairHits == hits ? std::to_string(hits).c_str() : "differ",
+                  pairs * 1e6, build * 1e6, total * 1e6, pairs / total);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <algorithm>
+#include "./Grid.hpp"
+#include "./Overlap.hpp"
+#include "./bullets/BulletPool.hpp"
+
+namespace taiju {
+
+TEST(TaijuGridTest, QueryTest) {
+  std::mt19937 rand(42);
+  // Some bullets are out of the field.
+  std::uniform_real_distribution<float> x(-50, static_cast<float>(kFieldWidth) + 50);
+  std::uniform_real_distribution<float> y(-50, static_cast<float>(kFieldHeight) + 50);
+  std::uniform_real_distribution<float> r(0.5f, 6);
+  BulletPool bullets;
+  for (int i = 0; i < 5000; ++i) {
+    bullets.spawn(Pos{x(rand), y(rand)}, Pos{0, 0}, r(rand), 1);
+  }
+  for (uint32_t i = 0; i < 5000; i += 3) {
+    bullets.removeAt(i);
+  }
+  Grid grid(kFieldWidth, kFieldHeight, 16);
+  grid.build(bullets);
+  EXPECT_EQ(bullets.count(), grid.size());
+  for (int q = 0; q < 200; ++q) {
+    Real const qx = x(rand);
+    Real const qy = y(rand);
+    Real const qr = r(rand) * 4;
+    std::vector<uint32_t> found;
+    grid.query(qx, qy, qr, [&](uint32_t const i) { found.emplace_back(i); });
+    std::sort(found.begin(), found.end());
+    EXPECT_TRUE(std::adjacent_find(found.begin(), found.end()) == found.end());
+    bullets.forEach([&](uint32_t const i) {
+      bool const found_ = std::binary_search(found.begin(), found.end(), i);
+      if (overlaps(qx, qy, qr, bullets.x()[i], bullets.y()[i], bullets.radius()[i])) {
+        EXPECT_TRUE(found_) << "bullet " << i << " at query " << q;
+      }
+      if (found_) {
+        EXPECT_TRUE(bullets.alive(i));
+      }
+    });
+  }
+}
+
+TEST(TaijuGridTest, RebuildTest) {
+  BulletPool bullets;
+  Grid grid(kFieldWidth, kFieldHeight, 16);
+  BulletHandle const a = bullets.spawn(Pos{10, 10}, Pos{100, 0}, 1, 1);
+  grid.build(bullets);
+  size_t n = 0;
+  grid.query(10, 10, 1, [&](uint32_t const i) { EXPECT_EQ(a.index, i); n++; });
+  EXPECT_EQ(1, n);
+  bullets.move(1);
+  grid.build(bullets);
+  n = 0;
+  grid.query(10, 10, 1, [&](uint32_t) { n++; });
+  EXPECT_EQ(0, n);
+  grid.query(110, 10, 1, [&](uint32_t) { n++; });
+  EXPECT_EQ(1, n);
+  bullets.clear();
+  grid.build(bullets);
+  EXPECT_EQ(0, grid.size());
+  EXPECT_THROW(Grid(kFieldWidth, kFieldHeight, 0), std::invalid_argument);
+}
+
+}
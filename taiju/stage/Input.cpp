@@ -0,0 +1,71 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Input.hpp"
+#include "../../util/File.hpp"
+
+namespace taiju {
+
+namespace {
+
+constexpr char kMagic[4] = {'T', 'J', 'I', 'N'};
+
+struct Header final {
+  char magic[4];
+  uint32_t formatVersion;
+};
+
+}
+
+InputLog InputLog::load(std::string const& filename) {
+  std::vector<uint8_t> const bytes = util::readAllFromFile(filename);
+  Header header{};
+  if (bytes.size() < sizeof(Header)) {
+    throw std::runtime_error(fmt::format("Invalid input log: {}: too short.", filename));
+  }
+  std::memcpy(&header, bytes.data(), sizeof(Header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error(fmt::format("Invalid input log: {}: bad magic.", filename));
+  }
+  if (header.formatVersion != kFormatVersion) {
+    throw std::runtime_error(fmt::format("Invalid input log: {}: version {} (expected {}).", filename, header.formatVersion, kFormatVersion));
+  }
+  InputLog log;
+  log.frames_.assign(bytes.begin() + sizeof(Header), bytes.end());
+  return log;
+}
+
+InputLog InputLog::scripted(uint32_t const seed, size_t const numFrames) {
+  // Only the engine is specified by the standard, not the distributions; the log must not depend on the library.
+  std::mt19937 rand(seed);
+  InputLog log;
+  while (log.frames_.size() < numFrames) {
+    auto const held = static_cast<uint8_t>(rand() % 0x40u);
+    size_t const hold = 5 + rand() % 56u;
+    log.frames_.resize(std::min(numFrames, log.frames_.size() + hold), held);
+  }
+  return log;
+}
+
+void InputLog::save(std::string const& filename) const {
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.formatVersion = kFormatVersion;
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+  out.write(reinterpret_cast<char const*>(this->frames_.data()), static_cast<std::streamsize>(this->frames_.size()));
+  if (!out) {
+    throw std::runtime_error(fmt::format("Failed to write input log: {}", filename));
+  }
+}
+
+}
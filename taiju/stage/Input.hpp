@@ -0,0 +1,77 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace taiju {
+
+enum class Button : uint8_t {
+  Up = 1u << 0u,
+  Down = 1u << 1u,
+  Left = 1u << 2u,
+  Right = 1u << 3u,
+  Shot = 1u << 4u,
+  Slow = 1u << 5u,
+};
+
+[[nodiscard]] constexpr uint8_t bitsOf(Button const button) {
+  return static_cast<uint8_t>(button);
+}
+[[nodiscard]] constexpr Button operator|(Button const a, Button const b) {
+  return static_cast<Button>(bitsOf(a) | bitsOf(b));
+}
+
+// Buttons held in a frame.
+struct Input final {
+  uint8_t buttons = 0;
+  constexpr Input() = default;
+  constexpr explicit Input(uint8_t const buttons) : buttons(buttons) {}
+  constexpr explicit Input(Button const buttons) : buttons(bitsOf(buttons)) {}
+  // True if any of `button` is held.
+  [[nodiscard]] bool held(Button const button) const {
+    return (this->buttons & bitsOf(button)) != 0;
+  }
+};
+
+// Inputs of a play, one per frame: recorded from a play, or scripted.
+class InputLog final {
+public:
+  static constexpr uint32_t kFormatVersion = 1;
+
+public:
+  InputLog() = default;
+  InputLog(InputLog const&) = delete;
+  InputLog& operator=(InputLog const&) = delete;
+  InputLog(InputLog&&) = default;
+  InputLog& operator=(InputLog&&) = default;
+  ~InputLog() noexcept = default;
+
+public:
+  [[nodiscard]] static InputLog load(std::string const& filename);
+  // Deterministic random play: each combination of buttons is held for a while, as a player would.
+  [[nodiscard]] static InputLog scripted(uint32_t seed, size_t numFrames);
+  void save(std::string const& filename) const;
+  void record(Input const input) {
+    this->frames_.emplace_back(input.buttons);
+  }
+
+public:
+  // Nothing is held after the end.
+  [[nodiscard]] Input at(size_t const frame) const {
+    return frame < this->frames_.size() ? Input{this->frames_[frame]} : Input{};
+  }
+  [[nodiscard]] size_t size() const { return this->frames_.size(); }
+
+private:
+  std::vector<uint8_t> frames_;
+};
+
+}
@@ -0,0 +1,55 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "./Input.hpp"
+#include "../../util/TempDir.hpp"
+
+namespace taiju {
+
+TEST(TaijuInputTest, ScriptedTest) {
+  InputLog const a = InputLog::scripted(7, 1000);
+  InputLog const b = InputLog::scripted(7, 1000);
+  InputLog const c = InputLog::scripted(8, 1000);
+  ASSERT_EQ(1000, a.size());
+  size_t changes = 0;
+  bool differs = false;
+  for (size_t frame = 0; frame < a.size(); ++frame) {
+    EXPECT_EQ(a.at(frame).buttons, b.at(frame).buttons);
+    EXPECT_EQ(0, a.at(frame).buttons & ~0x3fu);
+    differs |= a.at(frame).buttons != c.at(frame).buttons;
+    changes += frame > 0 && a.at(frame).buttons != a.at(frame - 1).buttons;
+  }
+  EXPECT_TRUE(differs);
+  // Buttons are held for 5 frames or more.
+  EXPECT_LE(changes, 1000 / 5);
+  EXPECT_EQ(0, a.at(1000).buttons);
+}
+
+TEST(TaijuInputTest, FileTest) {
+  util::TempDir const dir("taiju-input-test");
+  std::filesystem::path const path = dir / "input.log";
+  InputLog log;
+  log.record(Input{Button::Up | Button::Shot});
+  log.record(Input{});
+  log.record(Input{Button::Left});
+  log.save(path.string());
+  InputLog const loaded = InputLog::load(path.string());
+  ASSERT_EQ(3, loaded.size());
+  EXPECT_TRUE(loaded.at(0).held(Button::Up));
+  EXPECT_TRUE(loaded.at(0).held(Button::Shot));
+  EXPECT_FALSE(loaded.at(0).held(Button::Down));
+  EXPECT_EQ(0, loaded.at(1).buttons);
+  EXPECT_TRUE(loaded.at(2).held(Button::Left));
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "TJXX\1\0\0\0";
+  EXPECT_THROW(InputLog::load(path.string()), std::runtime_error);
+}
+
+}
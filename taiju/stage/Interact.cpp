@@ -4,8 +4,120 @@
  *
  * Copyright 2020-, Kaede Fujisaki
  */
+#include <bit>
+#include <vector>
+#include <utility>
 #include "Interact.hpp"
+#include "Overlap.hpp"
+#include "witches/Sora.hpp"
+#include "witches/Chitose.hpp"
+#include "witches/Momiji.hpp"
+#include "witches/Kaede.hpp"
+#include "bullets/BulletPool.hpp"
+#include "World.hpp"
+#include "Stage.hpp"
 
 namespace taiju {
 
-}
\ No newline at end of file
+namespace {
+
+// Bullets found by the broad phase, gathered into columns for overlap().
+struct Candidates final {
+  std::vector<uint32_t> bullets;
+  std::vector<Real> x;
+  std::vector<Real> y;
+  std::vector<Real> radius;
+  std::vector<uint64_t> hits;
+};
+
+// Calls f(components..., bullet) for each live bullet that overlaps a witch with the components, and is not taken yet.
+template <typename... Cs, typename F>
+void sweep(World& world, BulletPool const& bullets, Grid const& grid, Candidates& c, std::vector<uint64_t>& taken, F&& f) {
+  world.each<Body const, Cs...>([&](Entity, Body const& body, Cs&... components) {
+    c.bullets.clear();
+    c.x.clear();
+    c.y.clear();
+    c.radius.clear();
+    grid.query(body.pos.x, body.pos.y, body.radius, [&](uint32_t const bullet) {
+      c.bullets.emplace_back(bullet);
+      c.x.emplace_back(bullets.x()[bullet]);
+      c.y.emplace_back(bullets.y()[bullet]);
+      c.radius.emplace_back(bullets.radius()[bullet]);
+    });
+    size_t const n = c.bullets.size();
+    c.hits.resize((n + 63) / 64);
+    overlap(body.pos.x, body.pos.y, body.radius, c.x.data(), c.y.data(), c.radius.data(), n, c.hits.data());
+    for (size_t word = 0; word < c.hits.size(); ++word) {
+      for (uint64_t bits = c.hits[word]; bits != 0; bits &= bits - 1) {
+        uint32_t const bullet = c.bullets[word * 64 + std::countr_zero(bits)];
+        uint64_t const bit = uint64_t(1) << (bullet % 64);
+        if ((taken[bullet / 64] & bit) == 0) {
+          taken[bullet / 64] |= bit;
+          f(components..., bullet);
+        }
+      }
+    }
+  });
+}
+
+}
+
+void Contacts::clear() {
+  this->sora.clear();
+  this->chitose.clear();
+  this->momiji.clear();
+  this->kaede.clear();
+  this->taken.clear();
+}
+
+void interact(Stage& stage) {
+  Contacts& contacts = stage.contacts();
+  collide(stage, contacts);
+  apply(contacts, stage.bullets());
+}
+
+void collide(Stage& stage, Contacts& contacts) {
+  BulletPool const& bullets = std::as_const(stage).bullets();
+  Grid& grid = stage.grid();
+  World& world = stage.world();
+  grid.build(bullets);
+  contacts.clear();
+  contacts.taken.resize((bullets.size() + 63) / 64, 0);
+  Candidates candidates;
+  sweep<Sora const>(world, bullets, grid, candidates, contacts.taken, [&](Sora const&, uint32_t const bullet) {
+    contacts.sora.emplace_back(bullet);
+  });
+  sweep<Chitose const>(world, bullets, grid, candidates, contacts.taken, [&](Chitose const&, uint32_t const bullet) {
+    contacts.chitose.emplace_back(bullet);
+  });
+  sweep<Momiji const, Health>(world, bullets, grid, candidates, contacts.taken, [&](Momiji const&, Health& health, uint32_t const bullet) {
+    contacts.momiji.emplace_back(Contacts::Damage{&health, bullet});
+  });
+  sweep<Kaede const, Health>(world, bullets, grid, candidates, contacts.taken, [&](Kaede const&, Health& health, uint32_t const bullet) {
+    contacts.kaede.emplace_back(Contacts::Damage{&health, bullet});
+  });
+}
+
+void apply(Contacts const& contacts, BulletPool& bullets) {
+  float const* const damage = bullets.damage();
+  for (Contacts::Damage const& c : contacts.momiji) {
+    c.health->hp -= damage[c.bullet];
+  }
+  for (Contacts::Damage const& c : contacts.kaede) {
+    c.health->hp -= damage[c.bullet];
+  }
+  for (uint32_t const bullet : contacts.sora) {
+    bullets.removeAt(bullet);
+  }
+  for (uint32_t const bullet : contacts.chitose) {
+    bullets.removeAt(bullet);
+  }
+  for (Contacts::Damage const& c : contacts.momiji) {
+    bullets.removeAt(c.bullet);
+  }
+  for (Contacts::Damage const& c : contacts.kaede) {
+    bullets.removeAt(c.bullet);
+  }
+}
+
+}
@@ -6,21 +6,39 @@
  */
 #pragma once
 
-#include <memory>
+#include <vector>
+#include <cstdint>
 
 namespace taiju {
 
+struct Health;
+class BulletPool;
+class Stage;
+
 // Witches x Bullets
-class Sora;
-class Chitose;
-class Momiji;
-class Kaede;
-class Bullet;
+// Hits found by the narrow phase, by the type of the witch, in the order they were found.
+// A bullet is taken by the first witch that overlaps it, so it appears once at most.
+struct Contacts final {
+  struct Damage final {
+    // Points into a column of the World, so it is valid until an entity is spawned or despawned.
+    Health* health;
+    uint32_t bullet;
+  };
+  std::vector<uint32_t> sora;
+  std::vector<uint32_t> chitose;
+  std::vector<Damage> momiji;
+  std::vector<Damage> kaede;
+  // Bullets already in the contacts, as bits by index.
+  std::vector<uint64_t> taken;
+  void clear();
+};
 
-void interact(std::shared_ptr<Sora> sora, std::shared_ptr<Bullet> bullet);
-void interact(std::shared_ptr<Chitose> chitose, std::shared_ptr<Bullet> bullet);
-void interact(std::shared_ptr<Momiji> kaede, std::shared_ptr<Bullet> bullet);
-void interact(std::shared_ptr<Kaede> momiji, std::shared_ptr<Bullet> bullet);
+// Runs the interactions of the frame: collide() then apply() on the contacts of the stage.
+void interact(Stage& stage);
+// The grid of the stage is the broad phase, and overlap() the narrow one.
+void collide(Stage& stage, Contacts& contacts);
+// Applies the damage, then removes the bullets.
+void apply(Contacts const& contacts, BulletPool& bullets);
 
 // Witches x Objects
 
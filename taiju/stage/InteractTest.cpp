@@ -0,0 +1,60 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include "./Stage.hpp"
+#include "./Interact.hpp"
+
+namespace taiju {
+
+TEST(TaijuInteractTest, ContactTest) {
+  Stage stage;
+  stage.init();
+  World& world = stage.world();
+  BulletPool& bullets = stage.bullets();
+  Pos const sora = world.get<Body>(stage.sora()).pos;
+  Pos const momiji = world.get<Body>(stage.momiji()).pos;
+  Pos const kaede = world.get<Body>(stage.kaede()).pos;
+  BulletHandle const a = bullets.spawn(sora, Pos{0, 0}, 2, 7);
+  BulletHandle const b = bullets.spawn(momiji, Pos{0, 0}, 2, 3);
+  BulletHandle const c = bullets.spawn(Pos{momiji.x + 1, momiji.y}, Pos{0, 0}, 2, 4);
+  BulletHandle const d = bullets.spawn(kaede, Pos{0, 0}, 2, 5);
+  BulletHandle const miss = bullets.spawn(Pos{10, 10}, Pos{0, 0}, 2, 5);
+
+  Contacts contacts;
+  collide(stage, contacts);
+  EXPECT_EQ(1, contacts.sora.size());
+  EXPECT_EQ(0, contacts.chitose.size());
+  ASSERT_EQ(2, contacts.momiji.size());
+  ASSERT_EQ(1, contacts.kaede.size());
+  EXPECT_EQ(&world.get<Health>(stage.momiji()), contacts.momiji[0].health);
+
+  apply(contacts, bullets);
+  EXPECT_EQ(Health::kMaxHp - 7, world.get<Health>(stage.momiji()).hp);
+  EXPECT_EQ(Health::kMaxHp - 5, world.get<Health>(stage.kaede()).hp);
+  EXPECT_FALSE(bullets.valid(a));
+  EXPECT_FALSE(bullets.valid(b));
+  EXPECT_FALSE(bullets.valid(c));
+  EXPECT_FALSE(bullets.valid(d));
+  EXPECT_TRUE(bullets.valid(miss));
+}
+
+TEST(TaijuInteractTest, TakenOnceTest) {
+  Stage stage;
+  stage.init();
+  World& world = stage.world();
+  Pos const momiji = world.get<Body>(stage.momiji()).pos;
+  // Kaede is put over Momiji: the bullet is taken by Momiji, which is swept first.
+  world.get<Body>(stage.kaede()).pos = momiji;
+  stage.bullets().spawn(momiji, Pos{0, 0}, 2, 10);
+  interact(stage);
+  EXPECT_EQ(Health::kMaxHp - 10, world.get<Health>(stage.momiji()).hp);
+  EXPECT_EQ(Health::kMaxHp, world.get<Health>(stage.kaede()).hp);
+  EXPECT_EQ(0, stage.bullets().count());
+}
+
+}
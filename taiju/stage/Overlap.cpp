@@ -0,0 +1,268 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "Overlap.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TAIJU_OVERLAP_X86 1
+#include <immintrin.h>
+#endif
+
+namespace taiju {
+
+namespace {
+
+using Kernel = void (*)(Real, Real, Real, Real const*, Real const*, Real const*, size_t, uint64_t*);
+
+// Bits of [beg, end) within a word.
+uint64_t scalarBits(Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y, Real const* const radius,
+                    size_t const beg, size_t const end) {
+  uint64_t bits = 0;
+  for (size_t i = beg; i < end; ++i) {
+    bits |= uint64_t(overlaps(cx, cy, r, x[i], y[i], radius[i])) << (i % 64);
+  }
+  return bits;
+}
+
+void overlapScalar(Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y, Real const* const radius,
+                   size_t const n, uint64_t* const hits) {
+  for (size_t word = 0; word * 64 < n; ++word) {
+    hits[word] = scalarBits(cx, cy, r, x, y, radius, word * 64, std::min(n, word * 64 + 64));
+  }
+}
+
+#if defined(TAIJU_OVERLAP_X86) && TAIJU_FIXED == 0
+
+__attribute__((target("sse4.1")))
+void overlapSSE41(float const cx, float const cy, float const r, float const* const x, float const* const y, float const* const radius,
+                  size_t const n, uint64_t* const hits) {
+  __m128 const vx = _mm_set1_ps(cx);
+  __m128 const vy = _mm_set1_ps(cy);
+  __m128 const vr = _mm_set1_ps(r);
+  for (size_t word = 0; word * 64 < n; ++word) {
+    size_t const beg = word * 64;
+    size_t const end = std::min(n, beg + 64);
+    uint64_t bits = 0;
+    size_t i = beg;
+    for (; i + 4 <= end; i += 4) {
+      __m128 const dx = _mm_sub_ps(vx, _mm_loadu_ps(x + i));
+      __m128 const dy = _mm_sub_ps(vy, _mm_loadu_ps(y + i));
+      __m128 const rr = _mm_add_ps(vr, _mm_loadu_ps(radius + i));
+      __m128 const d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      bits |= uint64_t(_mm_movemask_ps(_mm_cmplt_ps(d2, _mm_mul_ps(rr, rr)))) << (i - beg);
+    }
+    hits[word] = bits | scalarBits(cx, cy, r, x, y, radius, i, end);
+  }
+}
+
+// The tail of a word is read with masked loads, so the scalar code is never called with the upper halves dirty.
+__attribute__((target("avx2")))
+void overlapAVX2(float const cx, float const cy, float const r, float const* const x, float const* const y, float const* const radius,
+                 size_t const n, uint64_t* const hits) {
+  __m256 const vx = _mm256_set1_ps(cx);
+  __m256 const vy = _mm256_set1_ps(cy);
+  __m256 const vr = _mm256_set1_ps(r);
+  __m256i const lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (size_t word = 0; word * 64 < n; ++word) {
+    size_t const beg = word * 64;
+    size_t const end = std::min(n, beg + 64);
+    uint64_t bits = 0;
+    for (size_t i = beg; i < end; i += 8) {
+      __m256 dx;
+      __m256 dy;
+      __m256 rr;
+      uint32_t valid = 0xff;
+      if (i + 8 <= end) {
+        dx = _mm256_loadu_ps(x + i);
+        dy = _mm256_loadu_ps(y + i);
+        rr = _mm256_loadu_ps(radius + i);
+      } else {
+        __m256i const mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(end - i)), lanes);
+        dx = _mm256_maskload_ps(x + i, mask);
+        dy = _mm256_maskload_ps(y + i, mask);
+        rr = _mm256_maskload_ps(radius + i, mask);
+        valid = (1u << (end - i)) - 1;
+      }
+      dx = _mm256_sub_ps(vx, dx);
+      dy = _mm256_sub_ps(vy, dy);
+      rr = _mm256_add_ps(vr, rr);
+      __m256 const d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+      uint32_t const lt = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(rr, rr), _CMP_LT_OQ)));
+      bits |= uint64_t(lt & valid) << (i - beg);
+    }
+    hits[word] = bits;
+  }
+  _mm256_zeroupper();
+}
+
+#endif
+
+#if defined(TAIJU_OVERLAP_X86) && TAIJU_FIXED == 16
+
+// The squares of 16.16 need 64 bits: the even lanes and the odd ones are multiplied separately,
+// and d2 < rr^2 is read from the sign of d2 - rr^2, which both fit in int64.
+// Returns the sign bits of the even lanes in the even bits and those of the odd lanes in the odd ones.
+uint32_t interleave(uint32_t const even, uint32_t const odd) {
+  auto const spread = [](uint32_t v) {
+    v = (v | (v << 2)) & 0x33u;
+    return (v | (v << 1)) & 0x55u;
+  };
+  return spread(even) | (spread(odd) << 1);
+}
+
+// Of the even lanes only.
+__attribute__((target("sse4.1")))
+uint32_t evenBits(__m128i const dx, __m128i const dy, __m128i const rr) {
+  __m128i const d2 = _mm_add_epi64(_mm_mul_epi32(dx, dx), _mm_mul_epi32(dy, dy));
+  return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(_mm_sub_epi64(d2, _mm_mul_epi32(rr, rr)))));
+}
+
+__attribute__((target("sse4.1")))
+uint32_t fixedBits(__m128i const dx, __m128i const dy, __m128i const rr) {
+  return interleave(evenBits(dx, dy, rr), evenBits(_mm_srli_epi64(dx, 32), _mm_srli_epi64(dy, 32), _mm_srli_epi64(rr, 32)));
+}
+
+__attribute__((target("sse4.1")))
+void overlapSSE41(Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y, Real const* const radius,
+                  size_t const n, uint64_t* const hits) {
+  __m128i const vx = _mm_set1_epi32(cx.raw());
+  __m128i const vy = _mm_set1_epi32(cy.raw());
+  __m128i const vr = _mm_set1_epi32(r.raw());
+  for (size_t word = 0; word * 64 < n; ++word) {
+    size_t const beg = word * 64;
+    size_t const end = std::min(n, beg + 64);
+    uint64_t bits = 0;
+    size_t i = beg;
+    for (; i + 4 <= end; i += 4) {
+      __m128i const dx = _mm_sub_epi32(vx, _mm_loadu_si128(reinterpret_cast<__m128i const*>(x + i)));
+      __m128i const dy = _mm_sub_epi32(vy, _mm_loadu_si128(reinterpret_cast<__m128i const*>(y + i)));
+      __m128i const rr = _mm_add_epi32(vr, _mm_loadu_si128(reinterpret_cast<__m128i const*>(radius + i)));
+      bits |= uint64_t(fixedBits(dx, dy, rr)) << (i - beg);
+    }
+    hits[word] = bits | scalarBits(cx, cy, r, x, y, radius, i, end);
+  }
+}
+
+__attribute__((target("avx2")))
+uint32_t evenBits(__m256i const dx, __m256i const dy, __m256i const rr) {
+  __m256i const d2 = _mm256_add_epi64(_mm256_mul_epi32(dx, dx), _mm256_mul_epi32(dy, dy));
+  return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_sub_epi64(d2, _mm256_mul_epi32(rr, rr)))));
+}
+
+__attribute__((target("avx2")))
+uint32_t fixedBits(__m256i const dx, __m256i const dy, __m256i const rr) {
+  return interleave(evenBits(dx, dy, rr), evenBits(_mm256_srli_epi64(dx, 32), _mm256_srli_epi64(dy, 32), _mm256_srli_epi64(rr, 32)));
+}
+
+__attribute__((target("avx2")))
+void overlapAVX2(Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y, Real const* const radius,
+                 size_t const n, uint64_t* const hits) {
+  __m256i const vx = _mm256_set1_epi32(cx.raw());
+  __m256i const vy = _mm256_set1_epi32(cy.raw());
+  __m256i const vr = _mm256_set1_epi32(r.raw());
+  __m256i const lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  auto const column = [](Real const* const p) { return reinterpret_cast<int const*>(p); };
+  for (size_t word = 0; word * 64 < n; ++word) {
+    size_t const beg = word * 64;
+    size_t const end = std::min(n, beg + 64);
+    uint64_t bits = 0;
+    for (size_t i = beg; i < end; i += 8) {
+      __m256i dx;
+      __m256i dy;
+      __m256i rr;
+      uint32_t valid = 0xff;
+      if (i + 8 <= end) {
+        dx = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + i));
+        dy = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(y + i));
+        rr = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(radius + i));
+      } else {
+        __m256i const mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(end - i)), lanes);
+        dx = _mm256_maskload_epi32(column(x + i), mask);
+        dy = _mm256_maskload_epi32(column(y + i), mask);
+        rr = _mm256_maskload_epi32(column(radius + i), mask);
+        valid = (1u << (end - i)) - 1;
+      }
+      dx = _mm256_sub_epi32(vx, dx);
+      dy = _mm256_sub_epi32(vy, dy);
+      rr = _mm256_add_epi32(vr, rr);
+      bits |= uint64_t(fixedBits(dx, dy, rr) & valid) << (i - beg);
+    }
+    hits[word] = bits;
+  }
+  _mm256_zeroupper();
+}
+
+#endif
+
+Kernel kernelOf(OverlapKernel const kernel) {
+  if (!supported(kernel)) {
+    throw std::invalid_argument(fmt::format("Overlap kernel not supported on this CPU: {}", nameOf(kernel)));
+  }
+  switch (kernel) {
+#if defined(TAIJU_OVERLAP_X86) && TAIJU_FIXED != 32
+    case OverlapKernel::SSE41:
+      return overlapSSE41;
+    case OverlapKernel::AVX2:
+      return overlapAVX2;
+#endif
+    default:
+      return overlapScalar;
+  }
+}
+
+}
+
+void overlap(Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y, Real const* const radius,
+             size_t const n, uint64_t* const hits) {
+  static Kernel const best = kernelOf(bestOverlapKernel());
+  best(cx, cy, r, x, y, radius, n, hits);
+}
+
+void overlap(OverlapKernel const kernel, Real const cx, Real const cy, Real const r, Real const* const x, Real const* const y,
+             Real const* const radius, size_t const n, uint64_t* const hits) {
+  kernelOf(kernel)(cx, cy, r, x, y, radius, n, hits);
+}
+
+bool supported(OverlapKernel const kernel) {
+  switch (kernel) {
+    case OverlapKernel::Scalar:
+      return true;
+#if defined(TAIJU_OVERLAP_X86) && TAIJU_FIXED != 32
+    case OverlapKernel::SSE41:
+      return __builtin_cpu_supports("sse4.1");
+    case OverlapKernel::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+OverlapKernel bestOverlapKernel() {
+  for (OverlapKernel const kernel : {OverlapKernel::AVX2, OverlapKernel::SSE41}) {
+    if (supported(kernel)) {
+      return kernel;
+    }
+  }
+  return OverlapKernel::Scalar;
+}
+
+char const* nameOf(OverlapKernel const kernel) {
+  switch (kernel) {
+    case OverlapKernel::Scalar:
+      return "scalar";
+    case OverlapKernel::SSE41:
+      return "sse4.1";
+    case OverlapKernel::AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+}
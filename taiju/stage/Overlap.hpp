@@ -0,0 +1,50 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "Geom.hpp"
+
+namespace taiju {
+
+// Narrow phase: tests one circle against n circles stored as columns.
+// Bit i of the mask is set iff (cx - x[i])^2 + (cy - y[i])^2 < (r + radius[i])^2.
+// hits must have (n + 63) / 64 words; they are overwritten, so dead slots have to be masked afterwards.
+// Every kernel computes the same float operations in the same order, so they agree bit for bit
+// as long as the compiler does not fuse them into FMAs: CMakeLists.txt builds with -ffp-contract=off.
+// In fixed point the squares are exact in the wide type; centers must be less than 32768 pixels apart.
+// 16.16 has the SIMD kernels too, 32.32 only the scalar one.
+enum class OverlapKernel : uint8_t {
+  Scalar = 0,
+  SSE41,
+  AVX2,
+};
+
+// The test of one pair, as the kernels do it.
+[[nodiscard]] inline bool overlaps(Real const cx, Real const cy, Real const r, Real const x, Real const y, Real const radius) {
+#if TAIJU_FIXED == 0
+  float const dx = cx - x;
+  float const dy = cy - y;
+  float const rr = r + radius;
+#else
+  auto const dx = static_cast<Real::WideType>((cx - x).raw());
+  auto const dy = static_cast<Real::WideType>((cy - y).raw());
+  auto const rr = static_cast<Real::WideType>((r + radius).raw());
+#endif
+  return dx * dx + dy * dy < rr * rr;
+}
+
+void overlap(Real cx, Real cy, Real r, Real const* x, Real const* y, Real const* radius, size_t n, uint64_t* hits);
+void overlap(OverlapKernel kernel, Real cx, Real cy, Real r, Real const* x, Real const* y, Real const* radius, size_t n, uint64_t* hits);
+
+// Whether the CPU runs the kernel; the best one is used by overlap() without a kernel.
+[[nodiscard]] bool supported(OverlapKernel kernel);
+[[nodiscard]] OverlapKernel bestOverlapKernel();
+[[nodiscard]] char const* nameOf(OverlapKernel kernel);
+
+}
@@ -0,0 +1,46 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../../util/Bench.hpp"
+#include "./Overlap.hpp"
+
+// One witch against the bullets of a long column (the whole pool) or of a short one (a run of the grid).
+BENCH(TaijuOverlap) {
+  using namespace taiju;
+  std::printf("%-8s %8s %12s\n", "kernel", "bullets", "ns/bullet");
+  for (size_t const n : {48, 100000}) {
+    std::mt19937 rand(1);
+    std::uniform_real_distribution<float> pos(0, 400);
+    std::uniform_real_distribution<float> r(2, 8);
+    std::vector<Real> x(n);
+    std::vector<Real> y(n);
+    std::vector<Real> radius(n);
+    for (size_t i = 0; i < n; ++i) {
+      x[i] = pos(rand);
+      y[i] = pos(rand);
+      radius[i] = r(rand);
+    }
+    std::vector<uint64_t> hits((n + 63) / 64);
+    for (OverlapKernel const kernel : {OverlapKernel::Scalar, OverlapKernel::SSE41, OverlapKernel::AVX2}) {
+      if (!supported(kernel)) {
+        std::printf("%-8s %8zu %12s\n", nameOf(kernel), n, "-");
+        continue;
+      }
+      // Short columns are tested many times per measurement, so the clock does not dominate.
+      size_t const reps = 100000 / n;
+      double const secs = util::measure([&]() {
+        for (size_t rep = 0; rep < reps; ++rep) {
+          overlap(kernel, 200, 200, 1, x.data(), y.data(), radius.data(), n, hits.data());
+        }
+      });
+      std::printf("%-8s %8zu %12.3f\n", nameOf(kernel), n, secs * 1e9 / static_cast<double>(n * reps));
+    }
+  }
+}
@@ -0,0 +1,91 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "./Overlap.hpp"
+
+namespace taiju {
+
+namespace {
+
+struct Circles final {
+  std::vector<Real> x;
+  std::vector<Real> y;
+  std::vector<Real> radius;
+};
+
+Circles randomCircles(size_t const n, uint32_t const seed) {
+  std::mt19937 rand(seed);
+  std::uniform_real_distribution<float> pos(-20, 20);
+  std::uniform_real_distribution<float> r(0, 8);
+  Circles c;
+  for (size_t i = 0; i < n; ++i) {
+    c.x.emplace_back(pos(rand));
+    c.y.emplace_back(pos(rand));
+    c.radius.emplace_back(r(rand));
+  }
+  return c;
+}
+
+}
+
+TEST(TaijuOverlapTest, ScalarTest) {
+  Circles const c = randomCircles(200, 1);
+  std::vector<uint64_t> hits(4, ~uint64_t(0));
+  overlap(OverlapKernel::Scalar, 1.5f, -2, 3, c.x.data(), c.y.data(), c.radius.data(), c.x.size(), hits.data());
+  for (size_t i = 0; i < c.x.size(); ++i) {
+#if TAIJU_FIXED == 0
+    float const dx = 1.5f - c.x[i];
+    float const dy = -2 - c.y[i];
+    float const rr = 3 + c.radius[i];
+#else
+    // Exact in the wide type.
+    auto const dx = static_cast<Real::WideType>(Real(1.5f).raw() - c.x[i].raw());
+    auto const dy = static_cast<Real::WideType>(Real(-2).raw() - c.y[i].raw());
+    auto const rr = static_cast<Real::WideType>(Real(3).raw() + c.radius[i].raw());
+#endif
+    EXPECT_EQ(dx * dx + dy * dy < rr * rr, ((hits[i / 64] >> (i % 64)) & 1u) != 0) << i;
+  }
+  // The bits after n are cleared.
+  EXPECT_EQ(0, hits[3] >> (200 % 64));
+}
+
+TEST(TaijuOverlapTest, KernelTest) {
+  ASSERT_TRUE(supported(OverlapKernel::Scalar));
+  ASSERT_TRUE(supported(bestOverlapKernel()));
+  for (OverlapKernel const kernel : {OverlapKernel::SSE41, OverlapKernel::AVX2}) {
+    if (!supported(kernel)) {
+      EXPECT_THROW(overlap(kernel, 0, 0, 1, nullptr, nullptr, nullptr, 0, nullptr), std::invalid_argument);
+      continue;
+    }
+    SCOPED_TRACE(nameOf(kernel));
+    for (size_t const n : {0, 1, 3, 4, 7, 8, 9, 63, 64, 65, 130, 1000}) {
+      SCOPED_TRACE(n);
+      Circles const c = randomCircles(n, static_cast<uint32_t>(n));
+      size_t const words = (n + 63) / 64;
+      std::vector<uint64_t> expected(words);
+      std::vector<uint64_t> actual(words, ~uint64_t(0));
+      for (float const r : {0.0f, 1.0f, 12.0f}) {
+        overlap(OverlapKernel::Scalar, 0.25f, 0.5f, r, c.x.data(), c.y.data(), c.radius.data(), n, expected.data());
+        overlap(kernel, 0.25f, 0.5f, r, c.x.data(), c.y.data(), c.radius.data(), n, actual.data());
+        EXPECT_EQ(expected, actual);
+      }
+    }
+    // Unaligned columns.
+    Circles const c = randomCircles(101, 7);
+    uint64_t expected[2];
+    uint64_t actual[2];
+    overlap(OverlapKernel::Scalar, 0, 0, 4, c.x.data() + 1, c.y.data() + 3, c.radius.data() + 2, 98, expected);
+    overlap(kernel, 0, 0, 4, c.x.data() + 1, c.y.data() + 3, c.radius.data() + 2, 98, actual);
+    EXPECT_EQ(expected[0], actual[0]);
+    EXPECT_EQ(expected[1], actual[1]);
+  }
+}
+
+}
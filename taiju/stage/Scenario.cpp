@@ -10,15 +10,17 @@
 namespace taiju {
 Scenario::Scenario(std::shared_ptr<Stage> stage)
 :stage_(std::move(stage))
+,timeline_(stage_->clock())
 {
 }
 
 void Scenario::init() {
+  // シナリオは Sequence を timeline().add(開始フレーム, ...) で登録する
 }
 
 void Scenario::move(){
   // 現在のフレーム数に応じてイベントを発生させる
-  uint32_t const current = stage_->clock().current();
+  this->timeline_.move();
 }
 
 }
\ No newline at end of file
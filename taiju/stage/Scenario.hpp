@@ -6,12 +6,14 @@
  */
 #pragma once
 #include "Value.hpp"
+#include "Timeline.hpp"
 
 namespace taiju {
 
 class Stage;
 class Scenario {
 DEF(std::shared_ptr<Stage>, stage);
+DEF_RW(Timeline, timeline, public, public);
 public:
   explicit Scenario(std::shared_ptr<Stage> stage);
   void init();
@@ -0,0 +1,102 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <array>
+#include <new>
+#include "Sequence.hpp"
+#include "Timeline.hpp"
+#include "../../util/BlockPool.hpp"
+
+namespace taiju {
+
+namespace {
+
+// Coroutine frames are pooled by size class: 128, 256, ..., 4096 bytes.
+// Larger frames fall back to the heap. Scenarios run on a single thread.
+constexpr size_t kMinFrameSize = 128;
+constexpr size_t kNumClasses = 6;
+
+size_t liveFrames = 0;
+
+std::array<util::BlockPool, kNumClasses>& pools() {
+  static std::array<util::BlockPool, kNumClasses> pools{
+      util::BlockPool(kMinFrameSize << 0),
+      util::BlockPool(kMinFrameSize << 1),
+      util::BlockPool(kMinFrameSize << 2),
+      util::BlockPool(kMinFrameSize << 3),
+      util::BlockPool(kMinFrameSize << 4),
+      util::BlockPool(kMinFrameSize << 5),
+  };
+  return pools;
+}
+
+size_t classOf(size_t const size) {
+  size_t cls = 0;
+  while (cls < kNumClasses && (kMinFrameSize << cls) < size) {
+    cls++;
+  }
+  return cls;
+}
+
+}
+
+void* Sequence::promise_type::operator new(size_t const size) {
+  size_t const cls = classOf(size);
+  void* const ptr = cls < kNumClasses ? pools()[cls].allocate() : ::operator new(size);
+  liveFrames++;
+  return ptr;
+}
+
+void Sequence::promise_type::operator delete(void* const ptr, size_t const size) noexcept {
+  size_t const cls = classOf(size);
+  if (cls < kNumClasses) {
+    pools()[cls].deallocate(ptr);
+  } else {
+    ::operator delete(ptr);
+  }
+  liveFrames--;
+}
+
+size_t Sequence::numFrames() {
+  return liveFrames;
+}
+
+void Sequence::promise_type::unhandled_exception() {
+  // The parent resumes from the queue, not from inside this handler.
+  if (this->parent && --this->parent.promise().pending == 0) {
+    this->timeline->schedule(this->parent, this->root, this->timeline->now());
+  }
+  throw;
+}
+
+std::coroutine_handle<> Sequence::FinalAwaiter::await_suspend(Handle const h) noexcept {
+  Handle const parent = h.promise().parent;
+  if (parent && --parent.promise().pending == 0) {
+    return parent;
+  }
+  return std::noop_coroutine();
+}
+
+void FramesAwaiter::await_suspend(Sequence::Handle const h) const {
+  Sequence::promise_type const& promise = h.promise();
+  promise.timeline->schedule(h, promise.root, promise.timeline->now() + this->frames);
+}
+
+bool AllAwaiter::await_suspend(Sequence::Handle const h) {
+  Sequence::promise_type& promise = h.promise();
+  // One extra count, so that children finishing right away do not resume the parent from here.
+  promise.pending = this->children.size() + 1;
+  for (Sequence& child : this->children) {
+    Sequence::promise_type& p = child.handle().promise();
+    p.timeline = promise.timeline;
+    p.root = promise.root;
+    p.parent = h;
+    child.handle().resume();
+  }
+  return --promise.pending != 0;
+}
+
+}
@@ -0,0 +1,129 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+namespace taiju {
+
+class Timeline;
+
+// A coroutine of a scenario, driven by a Timeline:
+//
+//   Sequence opening(Scenario& s) {
+//     co_await frames(30);
+//     co_await all(left(s), right(s));
+//   }
+//
+// Its frame is allocated from a pool instead of the heap.
+class Sequence final {
+public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter final {
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle h) noexcept;
+    void await_resume() const noexcept {}
+  };
+
+  struct promise_type final {
+    Timeline* timeline = nullptr;
+    uint32_t root = 0;   // index of the root sequence in the timeline
+    Handle parent;       // waiting for this sequence in all()
+    size_t pending = 0;  // children that this sequence is waiting for
+
+    Sequence get_return_object() { return Sequence(Handle::from_promise(*this)); }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    // Releases the parent before rethrowing, as the final suspend point is never reached.
+    void unhandled_exception();
+
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size) noexcept;
+  };
+
+public:
+  Sequence() = default;
+  Sequence(Sequence const&) = delete;
+  Sequence& operator=(Sequence const&) = delete;
+  Sequence(Sequence&& other) noexcept
+  :handle_(std::exchange(other.handle_, {}))
+  {
+  }
+  Sequence& operator=(Sequence&& other) noexcept {
+    if (this != &other) {
+      this->reset();
+      this->handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Sequence() noexcept {
+    this->reset();
+  }
+
+public:
+  [[nodiscard]] Handle handle() const { return this->handle_; }
+  [[nodiscard]] bool done() const { return !this->handle_ || this->handle_.done(); }
+  // Frames allocated and not yet freed, for leak checks.
+  [[nodiscard]] static size_t numFrames();
+
+private:
+  explicit Sequence(Handle handle)
+  :handle_(handle)
+  {
+  }
+  void reset() noexcept {
+    if (this->handle_) {
+      this->handle_.destroy();
+      this->handle_ = {};
+    }
+  }
+
+private:
+  Handle handle_;
+};
+
+// co_await frames(n): resumes n frames later in subjective time.
+struct FramesAwaiter final {
+  uint32_t frames;
+  [[nodiscard]] bool await_ready() const noexcept { return this->frames == 0; }
+  void await_suspend(Sequence::Handle h) const;
+  void await_resume() const noexcept {}
+};
+
+[[nodiscard]] inline FramesAwaiter frames(uint32_t const n) {
+  return FramesAwaiter{n};
+}
+
+// co_await all(a, b, ...): starts the sequences in order and resumes when all of them have finished.
+struct AllAwaiter final {
+  std::vector<Sequence> children;
+  [[nodiscard]] bool await_ready() const noexcept { return this->children.empty(); }
+  bool await_suspend(Sequence::Handle h);
+  void await_resume() const noexcept {}
+};
+
+[[nodiscard]] inline AllAwaiter all(std::vector<Sequence> children) {
+  return AllAwaiter{std::move(children)};
+}
+
+template <typename... Sequences>
+[[nodiscard]] AllAwaiter all(Sequence&& first, Sequences&&... rest) {
+  std::vector<Sequence> children;
+  children.reserve(1 + sizeof...(rest));
+  children.emplace_back(std::move(first));
+  (children.emplace_back(std::forward<Sequences>(rest)), ...);
+  return AllAwaiter{std::move(children)};
+}
+
+}
@@ -8,7 +8,17 @@
 
 namespace taiju {
 
+Stage::Stage()
+:world_(clock_)
+,grid_(kFieldWidth, kFieldHeight, kCellSize)
+{
+}
+
 void Stage::init() {
+  this->sora_ = this->world_.spawn(Sora{}, Body{Pos{kFieldWidth * 0.5f, kFieldHeight * 0.2f}});
+  this->chitose_ = this->world_.spawn(Chitose{}, Body{Pos{kFieldWidth * 0.25f, kFieldHeight * 0.2f}});
+  this->momiji_ = this->world_.spawn(Momiji{}, Body{Pos{kFieldWidth * 0.5f, kFieldHeight * 0.85f}}, Health{});
+  this->kaede_ = this->world_.spawn(Kaede{}, Body{Pos{kFieldWidth * 0.75f, kFieldHeight * 0.85f}}, Health{});
 }
 
 }
\ No newline at end of file
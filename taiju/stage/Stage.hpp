@@ -5,31 +5,40 @@
  * Copyright 2020-, Kaede Fujisaki
  */
 #pragma once
-#include <vector>
-#include <memory>
+#include "World.hpp"
 #include "witches/Witch.hpp"
 #include "witches/Sora.hpp"
 #include "witches/Chitose.hpp"
 #include "witches/Momiji.hpp"
 #include "witches/Kaede.hpp"
+#include "bullets/BulletPool.hpp"
+#include "Grid.hpp"
+#include "Interact.hpp"
+#include "Input.hpp"
 
 namespace taiju {
 
 class Stage {
-DEF(Clock, clock);
-DEF(std::vector<std::shared_ptr<Actor>>, actors);
-DEF(std::shared_ptr<Sora>, sora);
-DEF(std::shared_ptr<Chitose>, chitose);
-DEF(std::shared_ptr<Momiji>, momiji);
-DEF(std::shared_ptr<Kaede>, kaede);
+DEF_RW(Clock, clock, public, public);
+DEF_RW(World, world, public, public);
+DEF(Entity, sora);
+DEF(Entity, chitose);
+DEF(Entity, momiji);
+DEF(Entity, kaede);
+DEF_RW(BulletPool, bullets, public, public);
+DEF_RW(Grid, grid, public, public);
+DEF_RW(Contacts, contacts, public, public);
+DEF_RW(Input, input, public, public);
 public:
-  Stage() = default;
+  static constexpr Real kCellSize = 16;
+  Stage();
   Stage(Stage const&) = delete;
   Stage(Stage&&) = delete;
   Stage& operator=(Stage const&) = delete;
   Stage& operator=(Stage&&) = delete;
 
 public:
+  // Places the witches.
   void init();
 };
 
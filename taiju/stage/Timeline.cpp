@@ -0,0 +1,173 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <algorithm>
+#include "Timeline.hpp"
+
+namespace taiju {
+
+namespace {
+
+struct Later final {
+  template <typename E>
+  bool operator()(E const& a, E const& b) const {
+    return a.at != b.at ? a.at > b.at : a.order > b.order;
+  }
+};
+
+}
+
+Timeline::Timeline(Clock const& clock)
+:clock_(clock)
+,active_(&queue_)
+,now_(clock.current())
+,leap_(clock.leap())
+{
+}
+
+void Timeline::add(uint32_t const at, Factory factory) {
+  auto const root = static_cast<uint32_t>(this->roots_.size());
+  this->roots_.emplace_back(Root{std::move(factory), at, Sequence(), std::nullopt, false});
+  auto const it = std::upper_bound(this->starts_.begin(), this->starts_.end(), at, [this](uint32_t const at, uint32_t const r) {
+    return at < this->roots_[r].startAt;
+  });
+  bool const started = static_cast<size_t>(it - this->starts_.begin()) < this->cursor_;
+  this->starts_.insert(it, root);
+  // Before a root that has started already: start it now, as the cursor has passed.
+  if (started) {
+    this->cursor_++;
+    this->rebuild(root, this->clock_.current());
+  }
+}
+
+void Timeline::move() {
+  uint32_t const now = this->clock_.current();
+  if (this->leap_ != this->clock_.leap()) {
+    this->leap_ = this->clock_.leap();
+    this->seek(now);
+  }
+  this->now_ = now;
+  while (this->cursor_ < this->starts_.size() && this->roots_[this->starts_[this->cursor_]].startAt <= now) {
+    this->rebuild(this->starts_[this->cursor_++], now);
+  }
+  // Entries overdue after a forward leap see the frame they were scheduled at.
+  while (!this->queue_.empty() && this->queue_.front().at <= now) {
+    std::pop_heap(this->queue_.begin(), this->queue_.end(), Later());
+    Entry const entry = this->queue_.back();
+    this->queue_.pop_back();
+    this->now_ = entry.at;
+    this->resume(entry);
+  }
+  this->now_ = now;
+}
+
+// The state is as of the end of the frame before `now`: roots that start at or after `now` go back
+// into the table, and those that have run at or after `now` are rebuilt.
+void Timeline::seek(uint32_t const now) {
+  auto const beg = this->resumed_.lower_bound(std::make_pair(now, uint32_t(0)));
+  std::vector<uint32_t> stale;
+  for (auto it = beg; it != this->resumed_.end(); ++it) {
+    stale.emplace_back(it->second);
+    this->roots_[it->second].stale = true;
+  }
+  this->resumed_.erase(beg, this->resumed_.end());
+  auto const seek = static_cast<size_t>(
+      std::lower_bound(this->starts_.begin(), this->starts_.end(), now, [this](uint32_t const r, uint32_t const at) {
+        return this->roots_[r].startAt < at;
+      }) - this->starts_.begin());
+  for (size_t i = seek; i < this->cursor_; ++i) {
+    this->roots_[this->starts_[i]].stale = true;
+  }
+  auto const it = std::remove_if(this->queue_.begin(), this->queue_.end(), [this](Entry const& e) {
+    return this->roots_[e.root].stale;
+  });
+  if (it != this->queue_.end()) {
+    this->queue_.erase(it, this->queue_.end());
+    std::make_heap(this->queue_.begin(), this->queue_.end(), Later());
+  }
+  for (size_t i = seek; i < this->cursor_; ++i) {
+    Root& r = this->roots_[this->starts_[i]];
+    r.sequence = Sequence();
+    r.lastResumedAt.reset();
+    r.stale = false;
+  }
+  this->cursor_ = std::min(this->cursor_, seek);
+  std::sort(stale.begin(), stale.end());
+  for (uint32_t const root : stale) {
+    if (this->roots_[root].stale) {
+      this->roots_[root].stale = false;
+      this->rebuild(root, now);
+    }
+  }
+}
+
+void Timeline::schedule(std::coroutine_handle<> const handle, uint32_t const root, uint32_t const at) {
+  this->active_->emplace_back(Entry{at, this->order_++, root, handle});
+  std::push_heap(this->active_->begin(), this->active_->end(), Later());
+}
+
+bool Timeline::finished() const {
+  return this->cursor_ == this->starts_.size() && std::all_of(this->roots_.begin(), this->roots_.end(), [](Root const& root) {
+    return root.sequence.done();
+  });
+}
+
+// Recreates the root sequence, and fast-forwards it through the frames before `now`.
+// The queue must not hold entries of the root.
+void Timeline::rebuild(uint32_t const root, uint32_t const now) {
+  Root& r = this->roots_[root];
+  if (r.lastResumedAt.has_value()) {
+    this->resumed_.erase(std::make_pair(r.lastResumedAt.value(), root));
+    this->numRebuilt_++;
+  }
+  r.sequence = r.factory();
+  r.lastResumedAt.reset();
+  Sequence::promise_type& promise = r.sequence.handle().promise();
+  promise.timeline = this;
+  promise.root = root;
+  std::vector<Entry> replay;
+  this->active_ = &replay;
+  this->replaying_ = true;
+  uint32_t const savedNow = this->now_;
+  this->schedule(r.sequence.handle(), root, r.startAt);
+  try {
+    while (!replay.empty() && replay.front().at < now) {
+      std::pop_heap(replay.begin(), replay.end(), Later());
+      Entry const entry = replay.back();
+      replay.pop_back();
+      this->now_ = entry.at;
+      this->resume(entry);
+    }
+  } catch (...) {
+    this->active_ = &this->queue_;
+    this->replaying_ = false;
+    this->now_ = savedNow;
+    throw;
+  }
+  this->active_ = &this->queue_;
+  this->replaying_ = false;
+  this->now_ = savedNow;
+  for (Entry const& entry : replay) {
+    this->queue_.emplace_back(entry);
+    std::push_heap(this->queue_.begin(), this->queue_.end(), Later());
+  }
+}
+
+void Timeline::resume(Entry const& entry) {
+  Root& r = this->roots_[entry.root];
+  if (!r.lastResumedAt.has_value()) {
+    this->resumed_.emplace(entry.at, entry.root);
+  } else if (r.lastResumedAt.value() != entry.at) {
+    // Reuses the node instead of allocating another.
+    auto node = this->resumed_.extract(std::make_pair(r.lastResumedAt.value(), entry.root));
+    node.value().first = entry.at;
+    this->resumed_.insert(std::move(node));
+  }
+  r.lastResumedAt = entry.at;
+  entry.handle.resume();
+}
+
+}
@@ -0,0 +1,92 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <set>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <coroutine>
+#include <cstdint>
+#include "Value.hpp"
+#include "Sequence.hpp"
+
+namespace taiju {
+
+// Schedules Sequences on subjective time.
+// Root sequences are kept in a table sorted by the frame they start at, and are made only when the
+// cursor of the table reaches that frame. Suspended sequences are queued by the frame they resume at.
+// After Clock::leap, the cursor is moved back by a binary search, and only the root sequences that
+// have been resumed after the destination are rebuilt: they are fast-forwarded to the destination
+// with replaying() set, so their effects must be skipped while replaying.
+// Sequences must be deterministic: they may only depend on now() and their own locals.
+class Timeline final {
+public:
+  using Factory = std::function<Sequence()>;
+
+public:
+  Timeline() = delete;
+  Timeline(Timeline const&) = delete;
+  Timeline(Timeline&&) = delete;
+  Timeline& operator=(Timeline const&) = delete;
+  Timeline& operator=(Timeline&&) = delete;
+  explicit Timeline(Clock const& clock);
+  ~Timeline() noexcept = default;
+
+public:
+  // Starts the sequence made by `factory` at frame `at`.
+  void add(uint32_t at, Factory factory);
+  // Resumes the sequences due to the current frame. Call it after Clock::tick.
+  void move();
+  // Used by the awaitables.
+  void schedule(std::coroutine_handle<> handle, uint32_t root, uint32_t at);
+
+public:
+  // The frame the running sequence sees; it differs from the clock while replaying.
+  [[nodiscard]] uint32_t now() const { return this->now_; }
+  [[nodiscard]] bool replaying() const { return this->replaying_; }
+  [[nodiscard]] bool finished() const;
+  // Total number of root sequences rebuilt by leaps; those that start after the destination are not counted.
+  [[nodiscard]] size_t numRebuilt() const { return this->numRebuilt_; }
+  // Root sequences that have been started and not dropped by a leap since.
+  [[nodiscard]] size_t numStarted() const { return this->cursor_; }
+
+private:
+  struct Entry final {
+    uint32_t at;
+    uint64_t order; // FIFO among the entries of the same frame
+    uint32_t root;
+    std::coroutine_handle<> handle;
+  };
+  struct Root final {
+    Factory factory;
+    uint32_t startAt;
+    Sequence sequence;
+    std::optional<uint32_t> lastResumedAt;
+    bool stale;
+  };
+  void seek(uint32_t now);
+  void rebuild(uint32_t root, uint32_t now);
+  void resume(Entry const& entry);
+
+private:
+  Clock const& clock_;
+  std::vector<Root> roots_;   // in the order they are added
+  std::vector<uint32_t> starts_; // roots sorted by startAt, then by the order they are added
+  size_t cursor_ = 0;         // the roots before it in starts_ have been started
+  std::set<std::pair<uint32_t, uint32_t>> resumed_; // (lastResumedAt, root) of the started roots
+  std::vector<Entry> queue_;  // heap
+  std::vector<Entry>* active_; // queue_, or the one used while replaying
+  uint64_t order_ = 0;
+  uint32_t now_ = 0;
+  uint32_t leap_ = 0;
+  bool replaying_ = false;
+  size_t numRebuilt_ = 0;
+};
+
+}
@@ -0,0 +1,63 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../../util/Bench.hpp"
+#include "./Timeline.hpp"
+
+namespace {
+
+taiju::Sequence burst(taiju::Timeline& t, size_t& shots) {
+  for (int i = 0; i < 3; ++i) {
+    if (!t.replaying()) {
+      shots++;
+    }
+    co_await taiju::frames(20);
+  }
+}
+
+}
+
+// Stages of n events at random frames, each a short sequence: whole runs of 3600 frames,
+// then leaps to random frames of a finished run.
+BENCH(TaijuTimeline) {
+  using namespace taiju;
+  constexpr uint32_t kFrames = 3600;
+  std::printf("%-8s %12s %12s\n", "events", "us/frame", "us/leap");
+  for (size_t const n : {100, 1000, 10000}) {
+    std::mt19937 rand(1);
+    std::vector<uint32_t> starts;
+    for (size_t i = 0; i < n; ++i) {
+      starts.emplace_back(1 + rand() % kFrames);
+    }
+    size_t shots = 0;
+    auto const run = [&](Clock& clock, Timeline& timeline) {
+      for (uint32_t const at : starts) {
+        timeline.add(at, [&]() { return burst(timeline, shots); });
+      }
+      for (uint32_t i = 0; i < kFrames; ++i) {
+        clock.tick();
+        timeline.move();
+      }
+    };
+    double const frame = util::measure([&]() {
+      Clock clock;
+      Timeline timeline(clock);
+      run(clock, timeline);
+    }) / kFrames;
+    Clock clock;
+    Timeline timeline(clock);
+    run(clock, timeline);
+    double const leap = util::measure([&]() {
+      clock.leap(1 + rand() % kFrames);
+      timeline.move();
+    });
+    std::printf("%-8zu %12.2f %12.1f\n", n, frame * 1e6, leap * 1e6);
+  }
+}
@@ -0,0 +1,193 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <stdexcept>
+#include "./Timeline.hpp"
+
+namespace taiju {
+
+namespace {
+
+using Log = std::vector<std::pair<uint32_t, std::string>>;
+
+Sequence shot(Timeline& t, Log& log, std::string name, uint32_t interval, int count) {
+  for (int i = 0; i < count; ++i) {
+    if (!t.replaying()) {
+      log.emplace_back(t.now(), name + std::to_string(i));
+    }
+    co_await frames(interval);
+  }
+}
+
+Sequence wave(Timeline& t, Log& log) {
+  co_await frames(10);
+  co_await all(shot(t, log, "a", 5, 3), shot(t, log, "b", 7, 2));
+  if (!t.replaying()) {
+    log.emplace_back(t.now(), "done");
+  }
+}
+
+Sequence fail(uint32_t after) {
+  co_await frames(after);
+  throw std::runtime_error("fail");
+}
+
+Sequence guard(Timeline& t, Log& log) {
+  co_await all(shot(t, log, "a", 2, 2), fail(1));
+  log.emplace_back(t.now(), "done");
+}
+
+Sequence boss(Timeline& t, Log& log) {
+  co_await frames(100);
+  if (!t.replaying()) {
+    log.emplace_back(t.now(), "boss");
+  }
+}
+
+}
+
+TEST(TaijuTimelineTest, RunTest) {
+  Clock clock;
+  Timeline timeline(clock);
+  Log log;
+  timeline.add(1, [&]() { return wave(timeline, log); });
+  for (int i = 0; i < 40; ++i) {
+    clock.tick();
+    timeline.move();
+  }
+  Log const expected = {
+      {11, "a0"}, {11, "b0"}, {16, "a1"}, {18, "b1"}, {21, "a2"}, {26, "done"},
+  };
+  EXPECT_EQ(expected, log);
+  EXPECT_TRUE(timeline.finished());
+}
+
+TEST(TaijuTimelineTest, LeapTest) {
+  size_t const numFrames = Sequence::numFrames();
+  {
+    Clock clock;
+    Timeline timeline(clock);
+    Log log;
+    timeline.add(1, [&]() { return wave(timeline, log); });
+    timeline.add(1, [&]() { return boss(timeline, log); });
+    for (int i = 0; i < 20; ++i) {
+      clock.tick();
+      timeline.move();
+    }
+    // Go back into the middle of all(); the frames in between are not replayed with effects.
+    clock.leap(15);
+    log.clear();
+    for (int i = 0; i < 100; ++i) {
+      clock.tick();
+      timeline.move();
+    }
+    Log const expected = {
+        {16, "a1"}, {18, "b1"}, {21, "a2"}, {26, "done"}, {101, "boss"},
+    };
+    EXPECT_EQ(expected, log);
+    // The boss has been waiting since frame 1, so it is left as it is.
+    EXPECT_EQ(1, timeline.numRebuilt());
+    EXPECT_TRUE(timeline.finished());
+  }
+  EXPECT_EQ(numFrames, Sequence::numFrames());
+}
+
+TEST(TaijuTimelineTest, TableTest) {
+  Clock clock;
+  Timeline timeline(clock);
+  Log log;
+  // Added out of order; the ones of the same frame run in the order they are added.
+  for (uint32_t const at : {50, 10, 30, 10, 70, 90, 30}) {
+    std::string const name = std::to_string(at) + "-" + std::to_string(log.size());
+    timeline.add(at, [&timeline, &log, name]() { return shot(timeline, log, name + ":", 4, 3); });
+    log.emplace_back(0, "");
+  }
+  log.clear();
+  for (int i = 0; i < 60; ++i) {
+    clock.tick();
+    timeline.move();
+  }
+  EXPECT_EQ(5, timeline.numStarted());
+  Log const first = log;
+
+  // Back to frame 20: the events of 30 and 50 go back into the table, and those of 10, which finish at 22, are rebuilt.
+  clock.leap(20);
+  log.clear();
+  for (int i = 0; i < 40; ++i) {
+    clock.tick();
+    timeline.move();
+  }
+  Log expected;
+  for (auto const& entry : first) {
+    if (entry.first > 20) {
+      expected.emplace_back(entry);
+    }
+  }
+  EXPECT_EQ(expected, log);
+  EXPECT_EQ(2, timeline.numRebuilt());
+
+  // Forward into the middle of the event of 90: it is fast-forwarded without effects.
+  clock.leap(95);
+  log.clear();
+  for (int i = 0; i < 20; ++i) {
+    clock.tick();
+    timeline.move();
+  }
+  EXPECT_EQ((Log{{98, "90-5:2"}}), log);
+  EXPECT_TRUE(timeline.finished());
+}
+
+TEST(TaijuTimelineTest, OverdueTest) {
+  Clock clock;
+  Timeline timeline(clock);
+  Log log;
+  timeline.add(1, [&]() { return wave(timeline, log); });
+  for (int i = 0; i < 12; ++i) {
+    clock.tick();
+    timeline.move();
+  }
+  // Forward past the rest of the wave: it runs in one frame, but sees the frames it was waiting for.
+  clock.leap(30);
+  log.clear();
+  clock.tick();
+  timeline.move();
+  Log const expected = {
+      {16, "a1"}, {18, "b1"}, {21, "a2"}, {26, "done"},
+  };
+  EXPECT_EQ(expected, log);
+  EXPECT_EQ(31, timeline.now());
+  EXPECT_TRUE(timeline.finished());
+}
+
+TEST(TaijuTimelineTest, ThrowTest) {
+  size_t const numFrames = Sequence::numFrames();
+  {
+    Clock clock;
+    Timeline timeline(clock);
+    Log log;
+    timeline.add(1, [&]() { return guard(timeline, log); });
+    clock.tick();
+    timeline.move();
+    clock.tick();
+    EXPECT_THROW(timeline.move(), std::runtime_error);
+    // The other child goes on, and the parent is not left waiting for the one that threw.
+    for (int i = 0; i < 10; ++i) {
+      clock.tick();
+      timeline.move();
+    }
+    Log const expected = {
+        {1, "a0"}, {3, "a1"}, {5, "done"},
+    };
+    EXPECT_EQ(expected, log);
+    EXPECT_TRUE(timeline.finished());
+  }
+  EXPECT_EQ(numFrames, Sequence::numFrames());
+}
+
+}
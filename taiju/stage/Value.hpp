@@ -10,6 +10,8 @@
 #include "../../donut/runtime/Value.hpp"
 
 namespace taiju {
-using Clock = donut::Clock<3600>;
-template <typename T> using Value = donut::Value<T, 3600>;
+// Frames of history a Value keeps, and so how far back Clock::leap can go.
+constexpr size_t kHistoryLength = 3600;
+using Clock = donut::Clock<kHistoryLength>;
+template <typename T> using Value = donut::Value<T, kHistoryLength>;
 }
@@ -0,0 +1,129 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <atomic>
+#include "World.hpp"
+
+namespace taiju {
+
+uint32_t newComponentId() {
+  static std::atomic<uint32_t> next = 0;
+  uint32_t const id = next++;
+  if (id >= kMaxComponents) {
+    throw std::logic_error(fmt::format("Too many component types: at most {}.", kMaxComponents));
+  }
+  return id;
+}
+
+Table::Table(Clock& clock, uint64_t const mask)
+:mask_(mask)
+,entities_(clock)
+{
+}
+
+bool Table::swapRemove(size_t const row, Entity& moved) {
+  for (std::unique_ptr<ColumnBase> const& column : this->columns_) {
+    column->swapRemove(row);
+  }
+  this->entities_.swapRemove(row);
+  if (row == this->size()) {
+    return false;
+  }
+  moved = this->entities()[row];
+  return true;
+}
+
+void Table::push(Entity const entity) {
+  this->entities_.push(entity);
+}
+
+void Table::commit() {
+  for (std::unique_ptr<ColumnBase> const& column : this->columns_) {
+    column->commit();
+  }
+  this->entities_.commit();
+}
+
+void Table::restore() {
+  for (std::unique_ptr<ColumnBase> const& column : this->columns_) {
+    column->restore();
+  }
+  this->entities_.restore();
+}
+
+World::World(Clock& clock)
+:clock_(clock)
+{
+}
+
+Entity World::allocate(uint32_t const table, Table& t) {
+  uint32_t index;
+  if (this->free_.empty()) {
+    index = static_cast<uint32_t>(this->generations_.size());
+    this->generations_.emplace_back(0);
+    this->highWater_.emplace_back(0);
+    this->locations_.emplace_back();
+  } else {
+    index = this->free_.back();
+    this->free_.pop_back();
+  }
+  Entity const entity{index, this->generations_[index]};
+  this->locations_[index] = Location{table, static_cast<uint32_t>(t.size())};
+  t.push(entity);
+  this->count_++;
+  return entity;
+}
+
+bool World::despawn(Entity const entity) {
+  if (!this->valid(entity)) {
+    return false;
+  }
+  Location const loc = this->locations_[entity.index];
+  Entity moved{};
+  if (this->tables_[loc.table]->swapRemove(loc.row, moved)) {
+    this->locations_[moved.index].row = loc.row;
+  }
+  this->locations_[entity.index].table = kNoTable;
+  this->generations_[entity.index] = ++this->highWater_[entity.index];
+  this->free_.emplace_back(entity.index);
+  this->count_--;
+  return true;
+}
+
+void World::commit() {
+  for (std::unique_ptr<Table> const& table : this->tables_) {
+    table->commit();
+  }
+}
+
+void World::restore() {
+  for (Location& loc : this->locations_) {
+    loc.table = kNoTable;
+  }
+  this->count_ = 0;
+  for (uint32_t i = 0; i < this->tables_.size(); ++i) {
+    Table& table = *this->tables_[i];
+    table.restore();
+    std::vector<Entity> const& entities = table.entities();
+    for (uint32_t row = 0; row < entities.size(); ++row) {
+      Entity const entity = entities[row];
+      this->generations_[entity.index] = entity.generation;
+      this->locations_[entity.index] = Location{i, row};
+    }
+    this->count_ += entities.size();
+  }
+  // Slots left empty by the leap get a generation none of their handles has had, in the abandoned future
+  // included, so those handles stay stale.
+  this->free_.clear();
+  for (uint32_t index = static_cast<uint32_t>(this->locations_.size()); index > 0; --index) {
+    if (this->locations_[index - 1].table == kNoTable) {
+      this->generations_[index - 1] = ++this->highWater_[index - 1];
+      this->free_.emplace_back(index - 1);
+    }
+  }
+}
+
+}
@@ -0,0 +1,283 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <bit>
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <fmt/format.h>
+#include "Value.hpp"
+
+namespace taiju {
+
+// Refers to an entity of a World. A handle goes stale when its entity is despawned.
+// The default one refers to nothing.
+struct Entity final {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+  [[nodiscard]] bool operator==(Entity const&) const = default;
+};
+
+// Components are plain structs; each type gets a bit of the archetype masks.
+constexpr size_t kMaxComponents = 64;
+uint32_t newComponentId();
+template <typename T> uint32_t componentIdOf() {
+  static uint32_t const id = newComponentId();
+  return id;
+}
+template <typename... Cs> uint64_t componentMaskOf() {
+  return ((uint64_t(1) << componentIdOf<std::remove_const_t<Cs>>()) | ... | uint64_t(0));
+}
+
+class ColumnBase {
+public:
+  ColumnBase() = default;
+  ColumnBase(ColumnBase const&) = delete;
+  ColumnBase(ColumnBase&&) = delete;
+  ColumnBase& operator=(ColumnBase const&) = delete;
+  ColumnBase& operator=(ColumnBase&&) = delete;
+  virtual ~ColumnBase() noexcept = default;
+
+public:
+  virtual void swapRemove(size_t row) = 0;
+  virtual void commit() = 0;
+  virtual void restore() = 0;
+};
+
+// The rows of one component in a table. They are edited in place during a frame, and recorded into the
+// history by commit() in chunks of kChunkRows rows: a chunk no row of which was written since the last commit
+// is shared with the previous frame instead of copied. Writes go through at(), push() and swapRemove();
+// the mutable rows() counts as a write to every row, so read through the const one.
+template <typename T> class Column final : public ColumnBase {
+  static_assert(std::is_copy_constructible_v<T>);
+  using Chunk = std::shared_ptr<std::vector<T> const>;
+public:
+  static constexpr size_t kChunkRows = 64;
+  explicit Column(Clock& clock)
+  :history_(std::make_unique<Value<std::vector<Chunk>>>(clock))
+  {
+  }
+  ~Column() noexcept override = default;
+
+public:
+  void swapRemove(size_t const row) override {
+    this->touch(row);
+    this->touch(this->rows_.size() - 1);
+    this->rows_[row] = std::move(this->rows_.back());
+    this->rows_.pop_back();
+  }
+  void push(T value) {
+    this->rows_.emplace_back(std::move(value));
+    this->touch(this->rows_.size() - 1);
+  }
+  void commit() override {
+    size_t const numChunks = (this->rows_.size() + kChunkRows - 1) / kChunkRows;
+    this->chunks_.resize(numChunks);
+    for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+      if (this->chunks_[chunk] && !this->allDirty_ && (chunk >= this->dirty_.size() || !this->dirty_[chunk])) {
+        continue;
+      }
+      auto const beg = this->rows_.begin() + static_cast<ptrdiff_t>(chunk * kChunkRows);
+      auto const end = this->rows_.begin() + static_cast<ptrdiff_t>(std::min(this->rows_.size(), (chunk + 1) * kChunkRows));
+      this->chunks_[chunk] = std::make_shared<std::vector<T> const>(beg, end);
+    }
+    *this->history_ = std::vector<Chunk>(this->chunks_);
+    this->dirty_.clear();
+    this->allDirty_ = false;
+  }
+  void restore() override {
+    auto const chunks = std::as_const(*this->history_).get();
+    this->chunks_ = chunks.has_value() ? chunks.value() : std::vector<Chunk>();
+    this->rows_.clear();
+    for (Chunk const& chunk : this->chunks_) {
+      this->rows_.insert(this->rows_.end(), chunk->begin(), chunk->end());
+    }
+    this->dirty_.clear();
+    this->allDirty_ = false;
+  }
+  [[nodiscard]] T& at(size_t const row) {
+    this->touch(row);
+    return this->rows_[row];
+  }
+  [[nodiscard]] std::vector<T>& rows() {
+    this->allDirty_ = true;
+    return this->rows_;
+  }
+  [[nodiscard]] std::vector<T> const& rows() const { return this->rows_; }
+
+private:
+  void touch(size_t const row) {
+    size_t const chunk = row / kChunkRows;
+    if (chunk >= this->dirty_.size()) {
+      this->dirty_.resize(chunk + 1);
+    }
+    this->dirty_[chunk] = true;
+  }
+
+private:
+  std::vector<T> rows_;
+  std::vector<Chunk> chunks_; // as of the last commit
+  std::vector<bool> dirty_;
+  bool allDirty_ = false;
+  std::unique_ptr<Value<std::vector<Chunk>>> history_;
+};
+
+// Entities of one archetype: a column per component, and the entities in the same row order.
+class Table final {
+public:
+  Table(Clock& clock, uint64_t mask);
+  Table(Table const&) = delete;
+  Table(Table&&) = delete;
+  Table& operator=(Table const&) = delete;
+  Table& operator=(Table&&) = delete;
+  ~Table() noexcept = default;
+
+public:
+  template <typename T> void addColumn(Clock& clock) {
+    this->slots_[componentIdOf<T>()] = static_cast<uint8_t>(this->columns_.size());
+    this->columns_.emplace_back(std::make_unique<Column<T>>(clock));
+  }
+  template <typename T> [[nodiscard]] Column<T>& column() {
+    return static_cast<Column<T>&>(*this->columns_[this->slots_[componentIdOf<T>()]]);
+  }
+  template <typename T> [[nodiscard]] Column<T> const& column() const {
+    return static_cast<Column<T> const&>(*this->columns_[this->slots_[componentIdOf<T>()]]);
+  }
+  void push(Entity entity);
+  // Returns the entity moved into the row, if any.
+  bool swapRemove(size_t row, Entity& moved);
+  void commit();
+  void restore();
+
+public:
+  [[nodiscard]] uint64_t mask() const { return this->mask_; }
+  [[nodiscard]] bool has(uint64_t const mask) const { return (this->mask_ & mask) == mask; }
+  [[nodiscard]] std::vector<Entity> const& entities() const { return this->entities_.rows(); }
+  [[nodiscard]] size_t size() const { return this->entities_.rows().size(); }
+
+private:
+  uint64_t mask_;
+  std::array<uint8_t, kMaxComponents> slots_{};
+  std::vector<std::unique_ptr<ColumnBase>> columns_;
+  Column<Entity> entities_;
+};
+
+// Entities stored by archetype: those with the same set of components share a table, so systems
+// run over contiguous columns. An entity keeps the components it was spawned with.
+// Call commit() once per frame to record the tables, and restore() after Clock::leap to bring them back
+// (Conductor::rewind does so before the frame is moved).
+class World final {
+public:
+  World() = delete;
+  explicit World(Clock& clock);
+  World(World const&) = delete;
+  World(World&&) = delete;
+  World& operator=(World const&) = delete;
+  World& operator=(World&&) = delete;
+  ~World() noexcept = default;
+
+public:
+  template <typename... Cs> Entity spawn(Cs... components) {
+    uint64_t const mask = componentMaskOf<Cs...>();
+    if (std::popcount(mask) != sizeof...(Cs)) {
+      throw std::invalid_argument("An entity can not have the same component twice.");
+    }
+    uint32_t const table = this->tableOf<Cs...>(mask);
+    Table& t = *this->tables_[table];
+    (t.column<Cs>().push(std::move(components)), ...);
+    return this->allocate(table, t);
+  }
+  // Returns false if the handle is stale.
+  bool despawn(Entity entity);
+  void commit();
+  void restore();
+
+public:
+  [[nodiscard]] bool valid(Entity const entity) const {
+    return entity.index < this->generations_.size() && this->generations_[entity.index] == entity.generation &&
+           this->locations_[entity.index].table != kNoTable;
+  }
+  template <typename T> [[nodiscard]] bool has(Entity const entity) const {
+    return this->valid(entity) && this->tables_[this->locations_[entity.index].table]->has(componentMaskOf<T>());
+  }
+  template <typename T> [[nodiscard]] T& get(Entity const entity) {
+    Location const& loc = this->locate<T>(entity);
+    return this->tables_[loc.table]->column<T>().at(loc.row);
+  }
+  template <typename T> [[nodiscard]] T const& get(Entity const entity) const {
+    Location const& loc = this->locate<T>(entity);
+    return std::as_const(*this->tables_[loc.table]).column<T>().rows()[loc.row];
+  }
+  // Calls f(entity, components...) for each entity that has all of Cs, table by table.
+  // Pass the components f only reads as const (each<Body const, Health>), so that commit() does not record them.
+  template <typename... Cs, typename F> void each(F&& f) {
+    uint64_t const mask = componentMaskOf<Cs...>();
+    for (std::unique_ptr<Table> const& table : this->tables_) {
+      if (!table->has(mask)) {
+        continue;
+      }
+      std::vector<Entity> const& entities = std::as_const(*table).entities();
+      std::tuple<Cs*...> const columns{rowsOf<Cs>(*table)...};
+      for (size_t row = 0; row < entities.size(); ++row) {
+        f(entities[row], std::get<Cs*>(columns)[row]...);
+      }
+    }
+  }
+  [[nodiscard]] size_t count() const { return this->count_; }
+  [[nodiscard]] size_t numTables() const { return this->tables_.size(); }
+
+private:
+  static constexpr uint32_t kNoTable = UINT32_MAX;
+  struct Location final {
+    uint32_t table;
+    uint32_t row;
+  };
+  template <typename... Cs> uint32_t tableOf(uint64_t const mask) {
+    for (uint32_t i = 0; i < this->tables_.size(); ++i) {
+      if (this->tables_[i]->mask() == mask) {
+        return i;
+      }
+    }
+    auto& table = this->tables_.emplace_back(std::make_unique<Table>(this->clock_, mask));
+    (table->addColumn<Cs>(this->clock_), ...);
+    return static_cast<uint32_t>(this->tables_.size() - 1);
+  }
+  template <typename C> static C* rowsOf(Table& table) {
+    if constexpr (std::is_const_v<C>) {
+      return std::as_const(table).column<std::remove_const_t<C>>().rows().data();
+    } else {
+      return table.column<C>().rows().data();
+    }
+  }
+  template <typename T> Location const& locate(Entity const entity) const {
+    if (!this->has<T>(entity)) {
+      throw std::invalid_argument(fmt::format("Entity {}:{} has no component {}.", entity.index, entity.generation, componentIdOf<T>()));
+    }
+    return this->locations_[entity.index];
+  }
+  Entity allocate(uint32_t table, Table& t);
+
+private:
+  Clock& clock_;
+  std::vector<std::unique_ptr<Table>> tables_;
+  std::vector<uint32_t> generations_;
+  // The highest generation each slot has had. It is not restored, so that no handle is handed out twice.
+  std::vector<uint32_t> highWater_;
+  std::vector<Location> locations_;
+  std::vector<uint32_t> free_;
+  size_t count_ = 0;
+};
+
+}
@@ -0,0 +1,54 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cstdio>
+#include <vector>
+#include "../../util/Bench.hpp"
+#include "./World.hpp"
+
+namespace {
+struct BenchPosition final {
+  float x;
+  float y;
+};
+struct BenchSpeed final {
+  float vx;
+  float vy;
+};
+}
+
+// A frame of a world with `n` entities: either every entity moves, or one in a hundred does,
+// then commit() records it into the history.
+BENCH(TaijuWorldCommit) {
+  using namespace taiju;
+  std::printf("%-10s %-8s %12s\n", "entities", "moved", "us/frame");
+  for (size_t const n : {1000, 4000, 16000}) {
+    for (size_t const stride : {1, 100}) {
+      Clock clock;
+      World world(clock);
+      std::vector<Entity> entities;
+      for (size_t i = 0; i < n; ++i) {
+        entities.emplace_back(world.spawn(BenchPosition{0, 0}, BenchSpeed{1, 2}));
+      }
+      double const frame = util::measure([&]() {
+        clock.tick();
+        if (stride == 1) {
+          world.each<BenchPosition, BenchSpeed const>([](Entity, BenchPosition& pos, BenchSpeed const& speed) {
+            pos.x += speed.vx;
+            pos.y += speed.vy;
+          });
+        } else {
+          for (size_t i = clock.current() % stride; i < n; i += stride) {
+            world.get<BenchPosition>(entities[i]).x += 1;
+          }
+        }
+        world.commit();
+      });
+      std::printf("%-10zu %-8s %12.1f\n", n, stride == 1 ? "all" : "1%", frame * 1e6);
+    }
+  }
+}
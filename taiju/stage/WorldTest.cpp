@@ -0,0 +1,152 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "./World.hpp"
+
+namespace taiju {
+
+namespace {
+struct Position final {
+  float x;
+};
+struct Speed final {
+  float v;
+};
+struct Tag final {
+};
+}
+
+TEST(TaijuWorldTest, SpawnTest) {
+  Clock clock;
+  World world(clock);
+  Entity const a = world.spawn(Position{1}, Speed{10});
+  Entity const b = world.spawn(Position{2});
+  Entity const c = world.spawn(Speed{30}, Position{3});
+  Entity const d = world.spawn(Position{4}, Tag{});
+  EXPECT_EQ(4, world.count());
+  // The order of the components does not matter.
+  EXPECT_EQ(3, world.numTables());
+  EXPECT_TRUE(world.has<Speed>(a));
+  EXPECT_FALSE(world.has<Speed>(b));
+  EXPECT_EQ(30, world.get<Speed>(c).v);
+  EXPECT_THROW(static_cast<void>(world.get<Speed>(b)), std::invalid_argument);
+  EXPECT_THROW(world.spawn(Tag{}, Tag{}), std::invalid_argument);
+  EXPECT_FALSE(world.valid(Entity{}));
+
+  world.each<Position, Speed>([](Entity, Position& pos, Speed const& speed) { pos.x += speed.v; });
+  EXPECT_EQ(11, world.get<Position>(a).x);
+  EXPECT_EQ(2, world.get<Position>(b).x);
+  EXPECT_EQ(33, world.get<Position>(c).x);
+  std::vector<Entity> visited;
+  world.each<Position const>([&](Entity const e, Position const&) { visited.emplace_back(e); });
+  EXPECT_EQ(4, visited.size());
+
+  // The last row of the table moves into the hole.
+  EXPECT_TRUE(world.despawn(a));
+  EXPECT_FALSE(world.despawn(a));
+  EXPECT_FALSE(world.valid(a));
+  EXPECT_EQ(33, world.get<Position>(c).x);
+  EXPECT_EQ(30, world.get<Speed>(c).v);
+  Entity const e = world.spawn(Position{5}, Speed{50});
+  EXPECT_EQ(a.index, e.index);
+  EXPECT_NE(a, e);
+  EXPECT_EQ(4, world.get<Position>(d).x);
+  EXPECT_EQ(4, world.count());
+}
+
+TEST(TaijuWorldTest, RewindTest) {
+  Clock clock;
+  World world(clock);
+  Entity const a = world.spawn(Position{0}, Speed{1});
+  Entity b{};
+  for (uint32_t frame = 1; frame <= 20; ++frame) {
+    clock.tick();
+    world.each<Position, Speed>([](Entity, Position& pos, Speed const& speed) { pos.x += speed.v; });
+    if (frame == 10) {
+      b = world.spawn(Position{100}, Speed{-1});
+    }
+    if (frame == 15) {
+      world.despawn(a);
+    }
+    world.commit();
+  }
+  EXPECT_FALSE(world.valid(a));
+  EXPECT_EQ(90, world.get<Position>(b).x);
+
+  clock.leap(12);
+  world.restore();
+  EXPECT_TRUE(world.valid(a));
+  EXPECT_TRUE(world.valid(b));
+  EXPECT_EQ(12, world.get<Position>(a).x);
+  EXPECT_EQ(98, world.get<Position>(b).x);
+
+  // Before b was spawned: its handle goes stale, and its slot is not handed out again under it.
+  clock.leap(5);
+  world.restore();
+  EXPECT_EQ(1, world.count());
+  EXPECT_EQ(5, world.get<Position>(a).x);
+  EXPECT_FALSE(world.valid(b));
+  Entity const c = world.spawn(Position{0});
+  EXPECT_NE(b, c);
+  EXPECT_FALSE(world.valid(b));
+}
+
+TEST(TaijuWorldTest, StaleHandleTest) {
+  Clock clock;
+  World world(clock);
+  Entity const a = world.spawn(Position{0});
+  Entity d{};
+  for (uint32_t frame = 1; frame <= 20; ++frame) {
+    clock.tick();
+    if (frame == 15) {
+      world.despawn(a);
+      d = world.spawn(Position{1});
+      ASSERT_EQ(a.index, d.index);
+    }
+    world.commit();
+  }
+  // Back before d was spawned: a is back under its old generation, but the one d had is not handed out again.
+  clock.leap(12);
+  world.restore();
+  EXPECT_TRUE(world.valid(a));
+  EXPECT_FALSE(world.valid(d));
+  world.despawn(a);
+  Entity const e = world.spawn(Position{2});
+  EXPECT_EQ(a.index, e.index);
+  EXPECT_NE(d, e);
+  EXPECT_FALSE(world.valid(d));
+}
+
+TEST(TaijuWorldTest, ChunkTest) {
+  // Spans several chunks of the columns, so that some are recorded and others shared.
+  constexpr uint32_t kEntities = 200;
+  Clock clock;
+  World world(clock);
+  std::vector<Entity> entities;
+  for (uint32_t i = 0; i < kEntities; ++i) {
+    entities.emplace_back(world.spawn(Position{static_cast<float>(i)}));
+  }
+  for (uint32_t frame = 1; frame <= 20; ++frame) {
+    clock.tick();
+    world.get<Position>(entities[frame * 7]).x = -static_cast<float>(frame);
+    if (frame == 10) {
+      world.despawn(entities[3]);
+    }
+    world.commit();
+  }
+  clock.leap(8);
+  world.restore();
+  EXPECT_EQ(kEntities, world.count());
+  for (uint32_t i = 0; i < kEntities; ++i) {
+    bool const written = i % 7 == 0 && 1 <= i / 7 && i / 7 <= 8;
+    EXPECT_EQ(written ? -static_cast<float>(i / 7) : static_cast<float>(i), world.get<Position>(entities[i]).x) << i;
+  }
+}
+
+}
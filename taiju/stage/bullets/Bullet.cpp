@@ -1,7 +0,0 @@
-/* coding: utf-8 */
-/**
- * wakaba
- *
- * Copyright 2020-, Kaede Fujisaki
- */
-#include "Bullet.hpp"
@@ -1,21 +0,0 @@
-/* coding: utf-8 */
-/**
- * wakaba
- *
- * Copyright 2020-, Kaede Fujisaki
- */
-#pragma once
-
-#include <cstdint>
-#include <glm/glm.hpp>
-#include "../Value.hpp"
-
-namespace taiju {
-
-class Bullet {
-VDEF(glm::fvec2, pos);
-VDEF(float, radius);
-VDEF(float, damage);
-};
-
-}
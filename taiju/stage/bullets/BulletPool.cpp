@@ -0,0 +1,408 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <bit>
+#include <algorithm>
+#include <type_traits>
+#include "../../../util/ThreadPool.hpp"
+#include "BulletPool.hpp"
+
+namespace taiju {
+
+uint32_t BulletPool::allocate(Real const radius, float const damage) {
+  uint32_t index;
+  if (this->free_.empty()) {
+    index = static_cast<uint32_t>(this->size());
+    this->x_.emplace_back();
+    this->y_.emplace_back();
+    this->vx_.emplace_back();
+    this->vy_.emplace_back();
+    this->radius_.emplace_back();
+    this->damage_.emplace_back();
+    this->x0_.emplace_back();
+    this->y0_.emplace_back();
+    this->born_.emplace_back(0);
+    this->generations_.emplace_back(0);
+    this->paths_.emplace_back();
+    this->removedAt_.emplace_back(0);
+    if (index % 64 == 0) {
+      this->alive_.emplace_back(0);
+      this->parametric_.emplace_back(0);
+    }
+    this->log(Change::Kind::Grow, index);
+  } else {
+    index = this->free_.back();
+    this->free_.pop_back();
+    this->log(Change::Kind::Reuse, index);
+  }
+  this->born_[index] = this->steps_;
+  this->radius_[index] = radius;
+  this->damage_[index] = damage;
+  this->alive_[index / 64] |= uint64_t(1) << (index % 64);
+  this->count_++;
+  return index;
+}
+
+BulletHandle BulletPool::spawn(Pos const pos, Pos const vel, Real const radius, float const damage) {
+  uint32_t const index = this->allocate(radius, damage);
+  this->x_[index] = pos.x;
+  this->y_[index] = pos.y;
+  this->vx_[index] = vel.x;
+  this->vy_[index] = vel.y;
+  this->x0_[index] = pos.x;
+  this->y0_[index] = pos.y;
+  return BulletHandle{index, this->generations_[index]};
+}
+
+BulletHandle BulletPool::spawn(Path const& path, Real const radius, float const damage) {
+  uint32_t const index = this->allocate(radius, damage);
+  Pos const pos = path.at(path.from);
+  this->x_[index] = pos.x;
+  this->y_[index] = pos.y;
+  // So that the integration in move() leaves it as it is.
+  this->vx_[index] = 0;
+  this->vy_[index] = 0;
+  this->paths_[index] = path;
+  this->parametric_[index / 64] |= uint64_t(1) << (index % 64);
+  return BulletHandle{index, this->generations_[index]};
+}
+
+bool BulletPool::remove(BulletHandle const handle) {
+  if (!this->valid(handle)) {
+    return false;
+  }
+  this->removeAt(handle.index);
+  return true;
+}
+
+void BulletPool::removeAt(uint32_t const index) {
+  if (this->alive(index)) {
+    this->retire(index, this->now_ + 1);
+  }
+}
+
+void BulletPool::retire(uint32_t const index, uint32_t const at) {
+  if (!this->parametric(index)) {
+    this->release(index);
+    return;
+  }
+  this->log(Change::Kind::Retire, index);
+  this->alive_[index / 64] &= ~(uint64_t(1) << (index % 64));
+  this->removedAt_[index] = at;
+  this->count_--;
+}
+
+void BulletPool::release(uint32_t const index) {
+  this->log(Change::Kind::Release, index);
+  if (this->alive(index)) {
+    this->count_--;
+  }
+  this->alive_[index / 64] &= ~(uint64_t(1) << (index % 64));
+  this->parametric_[index / 64] &= ~(uint64_t(1) << (index % 64));
+  this->generations_[index]++;
+  this->free_.emplace_back(index);
+}
+
+void BulletPool::clear() {
+  for (uint32_t index = 0; index < this->size(); ++index) {
+    if (this->alive(index) || this->parametric(index)) {
+      this->release(index);
+    }
+  }
+}
+
+void BulletPool::move(uint32_t const now, Real const margin) {
+  size_t const numChunks = (this->size() + kChunkSize - 1) / kChunkSize;
+  this->doomed_.assign(this->alive_.size(), 0);
+  this->dropped_.assign(this->alive_.size(), 0);
+  this->revived_.assign(this->alive_.size(), 0);
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    this->moveChunk(chunk, now, margin);
+  }
+  this->settle(now);
+}
+
+void BulletPool::move(uint32_t const now, Real const margin, util::ThreadPool& pool) {
+  size_t const numChunks = (this->size() + kChunkSize - 1) / kChunkSize;
+  this->doomed_.assign(this->alive_.size(), 0);
+  this->dropped_.assign(this->alive_.size(), 0);
+  this->revived_.assign(this->alive_.size(), 0);
+  pool.run(numChunks, [this, now, margin](size_t, size_t const chunk) {
+    this->moveChunk(chunk, now, margin);
+  });
+  this->settle(now);
+}
+
+void BulletPool::moveChunk(size_t const chunk, uint32_t const now, Real const margin) {
+  size_t const beg = chunk * kChunkSize;
+  size_t const end = std::min(this->size(), beg + kChunkSize);
+  Real* const x = this->x_.data();
+  Real* const y = this->y_.data();
+  Real const* const vx = this->vx_.data();
+  Real const* const vy = this->vy_.data();
+  for (size_t i = beg; i < end; ++i) {
+    x[i] += vx[i];
+    y[i] += vy[i];
+  }
+  Real const left = -margin;
+  Real const top = -margin;
+  Real const right = kFieldWidth + margin;
+  Real const bottom = kFieldHeight + margin;
+  for (size_t word = beg / 64; word * 64 < end; ++word) {
+    uint64_t doomed = 0;
+    uint64_t dropped = 0;
+    uint64_t revived = 0;
+    for (uint64_t bits = this->parametric_[word]; bits != 0; bits &= bits - 1) {
+      auto const index = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+      uint64_t const bit = uint64_t(1) << (index % 64);
+      Path const& path = this->paths_[index];
+      if (now < path.from) {
+        dropped |= bit;
+        continue;
+      }
+      if ((this->alive_[word] & bit) == 0) {
+        uint32_t const removedAt = this->removedAt_[index];
+        if (now < removedAt) {
+          revived |= bit;
+        } else {
+          // Out of reach of any leap.
+          if (now - removedAt >= kHistoryLength) {
+            dropped |= bit;
+          }
+          continue;
+        }
+      }
+      Pos const pos = path.at(now);
+      x[index] = pos.x;
+      y[index] = pos.y;
+    }
+    for (uint64_t bits = (this->alive_[word] | revived) & ~dropped; bits != 0; bits &= bits - 1) {
+      size_t const index = word * 64 + std::countr_zero(bits);
+      if (!(left <= x[index] && x[index] <= right && top <= y[index] && y[index] <= bottom)) {
+        doomed |= uint64_t(1) << (index % 64);
+      }
+    }
+    this->doomed_[word] = doomed;
+    this->dropped_[word] = dropped;
+    this->revived_[word] = revived;
+  }
+}
+
+void BulletPool::settle(uint32_t const now) {
+  this->changing_ = now;
+  for (size_t word = 0; word < this->alive_.size(); ++word) {
+    for (uint64_t bits = this->revived_[word]; bits != 0; bits &= bits - 1) {
+      this->log(Change::Kind::Revive, static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+    }
+    this->alive_[word] |= this->revived_[word];
+    this->count_ += static_cast<size_t>(std::popcount(this->revived_[word]));
+    for (uint64_t bits = this->dropped_[word]; bits != 0; bits &= bits - 1) {
+      this->release(static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+    }
+    for (uint64_t bits = this->doomed_[word]; bits != 0; bits &= bits - 1) {
+      this->retire(static_cast<uint32_t>(word * 64 + std::countr_zero(bits)), now);
+    }
+  }
+  this->log(Change::Kind::Move, 0);
+  this->steps_++;
+  if (this->steps_ % kRebaseInterval == 0) {
+    this->forEach([this](uint32_t const index) {
+      if (!this->parametric(index) && this->steps_ - this->born_[index] >= kHistoryLength) {
+        this->log(Change::Kind::Rebase, index);
+        this->x0_[index] = this->x_[index];
+        this->y0_[index] = this->y_[index];
+        this->born_[index] = this->steps_;
+      }
+    });
+  }
+  this->now_ = now;
+  this->changing_ = now + 1;
+  // Out of reach of any leap.
+  while (!this->changes_.empty() && this->changes_.front().frame + kHistoryLength <= now) {
+    this->changes_.pop_front();
+  }
+}
+
+BulletPool::Slot BulletPool::slotAt(uint32_t const index) const {
+  return Slot{
+      Pos{this->x0_[index], this->y0_[index]},
+      Pos{this->vx_[index], this->vy_[index]},
+      this->radius_[index],
+      this->damage_[index],
+      this->paths_[index],
+      this->born_[index],
+      this->removedAt_[index],
+  };
+}
+
+void BulletPool::log(Change::Kind const kind, uint32_t const index) {
+  Change& change = this->changes_.emplace_back(Change{kind, this->changing_, index, false, false, Slot{}});
+  switch (kind) {
+    case Change::Kind::Reuse:
+      change.slot = this->slotAt(index);
+      break;
+    case Change::Kind::Release:
+      change.alive = this->alive(index);
+      change.parametric = this->parametric(index);
+      break;
+    case Change::Kind::Retire:
+      change.slot.removedAt = this->removedAt_[index];
+      break;
+    case Change::Kind::Rebase:
+      change.slot.origin = Pos{this->x0_[index], this->y0_[index]};
+      change.slot.born = this->born_[index];
+      break;
+    default:
+      break;
+  }
+}
+
+void BulletPool::undo(Change const& change) {
+  uint32_t const index = change.index;
+  uint64_t const bit = uint64_t(1) << (index % 64);
+  switch (change.kind) {
+    case Change::Kind::Grow:
+      this->count_--;
+      this->x_.pop_back();
+      this->y_.pop_back();
+      this->vx_.pop_back();
+      this->vy_.pop_back();
+      this->radius_.pop_back();
+      this->damage_.pop_back();
+      this->x0_.pop_back();
+      this->y0_.pop_back();
+      this->born_.pop_back();
+      this->generations_.pop_back();
+      this->paths_.pop_back();
+      this->removedAt_.pop_back();
+      if (index % 64 == 0) {
+        this->alive_.pop_back();
+        this->parametric_.pop_back();
+      } else {
+        this->alive_[index / 64] &= ~bit;
+        this->parametric_[index / 64] &= ~bit;
+      }
+      break;
+    case Change::Kind::Reuse: {
+      Slot const& slot = change.slot;
+      this->count_--;
+      this->alive_[index / 64] &= ~bit;
+      this->parametric_[index / 64] &= ~bit;
+      this->x0_[index] = slot.origin.x;
+      this->y0_[index] = slot.origin.y;
+      this->vx_[index] = slot.vel.x;
+      this->vy_[index] = slot.vel.y;
+      this->radius_[index] = slot.radius;
+      this->damage_[index] = slot.damage;
+      this->paths_[index] = slot.path;
+      this->born_[index] = slot.born;
+      this->removedAt_[index] = slot.removedAt;
+      this->free_.emplace_back(index);
+      break;
+    }
+    case Change::Kind::Release:
+      this->free_.pop_back();
+      this->generations_[index]--;
+      if (change.alive) {
+        this->alive_[index / 64] |= bit;
+        this->count_++;
+      }
+      if (change.parametric) {
+        this->parametric_[index / 64] |= bit;
+      }
+      break;
+    case Change::Kind::Retire:
+      this->alive_[index / 64] |= bit;
+      this->removedAt_[index] = change.slot.removedAt;
+      this->count_++;
+      break;
+    case Change::Kind::Revive:
+      this->alive_[index / 64] &= ~bit;
+      this->count_--;
+      break;
+    case Change::Kind::Move:
+      this->steps_--;
+      break;
+    case Change::Kind::Rebase:
+      this->x0_[index] = change.slot.origin.x;
+      this->y0_[index] = change.slot.origin.y;
+      this->born_[index] = change.slot.born;
+      break;
+  }
+}
+
+void BulletPool::rewind(uint32_t const now) {
+  while (!this->changes_.empty() && this->changes_.back().frame > now) {
+    this->undo(this->changes_.back());
+    this->changes_.pop_back();
+  }
+  // Integrated bullets are moved again from where they were spawned, a move at a time over all of them
+  // as move() does, so that the additions are the very same ones.
+  std::vector<uint32_t> integrated;
+  uint32_t first = this->steps_;
+  this->forEach([&](uint32_t const index) {
+    if (this->parametric(index)) {
+      Pos const pos = this->paths_[index].at(now);
+      this->x_[index] = pos.x;
+      this->y_[index] = pos.y;
+      return;
+    }
+    this->x_[index] = this->x0_[index];
+    this->y_[index] = this->y0_[index];
+    integrated.emplace_back(index);
+    first = std::min(first, this->born_[index]);
+  });
+  for (uint32_t step = first; step < this->steps_; ++step) {
+    for (uint32_t const index : integrated) {
+      if (this->born_[index] <= step) {
+        this->x_[index] += this->vx_[index];
+        this->y_[index] += this->vy_[index];
+      }
+    }
+  }
+  this->now_ = now;
+  this->changing_ = now + 1;
+}
+
+uint64_t BulletPool::hash() const {
+  // FNV-1a over 32-bit words.
+  uint64_t h = 0xcbf29ce484222325u;
+  auto const mix = [&h](uint32_t const v) {
+    h = (h ^ v) * 0x100000001b3u;
+  };
+  auto const mixReal = [&mix](auto const v) {
+    if constexpr (std::is_floating_point_v<decltype(v)>) {
+      mix(std::bit_cast<uint32_t>(v));
+    } else {
+      auto const raw = static_cast<uint64_t>(v.raw());
+      for (size_t shift = 0; shift < sizeof(v.raw()) * 8; shift += 32) {
+        mix(static_cast<uint32_t>(raw >> shift));
+      }
+    }
+  };
+  this->forEach([&](uint32_t const index) {
+    mix(index);
+    mix(this->generations_[index]);
+    mix(this->parametric(index));
+    for (Real const v : {this->x_[index], this->y_[index], this->vx_[index], this->vy_[index], this->radius_[index]}) {
+      mixReal(v);
+    }
+    mix(std::bit_cast<uint32_t>(this->damage_[index]));
+  });
+  for (size_t word = 0; word < this->alive_.size(); ++word) {
+    for (uint64_t bits = this->parametric_[word] & ~this->alive_[word]; bits != 0; bits &= bits - 1) {
+      auto const index = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+      mix(index);
+      mix(this->removedAt_[index]);
+    }
+  }
+  for (uint32_t const index : this->free_) {
+    mix(index);
+  }
+  return h;
+}
+
+}
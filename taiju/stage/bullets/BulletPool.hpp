@@ -0,0 +1,188 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <bit>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../Geom.hpp"
+#include "../Value.hpp"
+#include "Path.hpp"
+
+namespace util {
+class ThreadPool;
+}
+
+namespace taiju {
+
+// Refers to a bullet in a BulletPool. A handle goes stale when its bullet is removed,
+// even if the slot is reused by a later bullet. BulletPool::rewind brings generations back with the slots,
+// so a handle from the abandoned future refers to the bullet spawned again in its place.
+struct BulletHandle final {
+  uint32_t index;
+  uint32_t generation;
+  [[nodiscard]] bool operator==(BulletHandle const&) const = default;
+};
+
+// Bullets stored as structure of arrays, so that update and collision loops run over contiguous scalars.
+// Removed slots are reused from a free list; their columns keep stale values and must be masked by alive().
+// A bullet either integrates its velocity every frame, or follows a Path. Changes to the slots are logged
+// for kHistoryLength frames, and rewind() undoes them, so that the pool is as it was in the frame a leap goes to.
+// Without rewind(), a move() back in time only brings back path bullets: a removed one keeps its slot for
+// kHistoryLength frames, and comes back if `now` is before its removal. Its handle is not valid in the meantime,
+// and is again once it is back.
+class BulletPool final {
+public:
+#if TAIJU_FIXED == 0
+  static constexpr Real kNoMargin = 1e30f;
+#else
+  // As far as positions may go; the bounds of the field stay representable.
+  static constexpr Real kNoMargin = 16384;
+#endif
+  // Slots moved by one task of move(); a multiple of 64, so that tasks never share a word of bits.
+  static constexpr size_t kChunkSize = 4096;
+public:
+  BulletPool() = default;
+  BulletPool(BulletPool const&) = delete;
+  BulletPool(BulletPool&&) = delete;
+  BulletPool& operator=(BulletPool const&) = delete;
+  BulletPool& operator=(BulletPool&&) = delete;
+  ~BulletPool() noexcept = default;
+
+public:
+  BulletHandle spawn(Pos pos, Pos vel, Real radius, float damage);
+  BulletHandle spawn(Path const& path, Real radius, float damage);
+  // Returns false if the handle is stale. Removes the bullet from the frame after the last move().
+  bool remove(BulletHandle handle);
+  void removeAt(uint32_t index);
+  // Frees every slot, those kept for a rewind included.
+  void clear();
+  // Moves the bullets to the frame `now`: integrated ones by their velocity, the others onto their paths.
+  // Bullets whose paths start after `now`, which are left in the future by Clock::leap, are freed,
+  // and those more than `margin` out of the field are removed. Removed path bullets come back
+  // if `now` is before their removal.
+  void move(uint32_t now, Real margin = kNoMargin);
+  // Same as above, with the slots split into chunks over the pool. Removals are applied in index order
+  // afterwards, so the result, free list included, is identical to the single-threaded one.
+  void move(uint32_t now, Real margin, util::ThreadPool& pool);
+  // Brings the pool back to as it was after move(now), at most kHistoryLength frames back: spawns and removals
+  // made for later frames are undone, and the bullets are put where they were.
+  void rewind(uint32_t now);
+  // Hash of the live and removed bullets and of the free list, for checking that two runs agree bit for bit.
+  [[nodiscard]] uint64_t hash() const;
+
+public:
+  [[nodiscard]] bool valid(BulletHandle const handle) const {
+    return handle.index < this->size() && this->generations_[handle.index] == handle.generation && this->alive(handle.index);
+  }
+  [[nodiscard]] bool alive(uint32_t const index) const {
+    return (this->alive_[index / 64] >> (index % 64)) & 1u;
+  }
+  [[nodiscard]] bool parametric(uint32_t const index) const {
+    return (this->parametric_[index / 64] >> (index % 64)) & 1u;
+  }
+  [[nodiscard]] Path const& path(uint32_t const index) const {
+    return this->paths_[index];
+  }
+  [[nodiscard]] BulletHandle handleAt(uint32_t const index) const {
+    return BulletHandle{index, this->generations_[index]};
+  }
+  // Calls f(index) for each live bullet in index order.
+  template <typename F> void forEach(F&& f) const {
+    for (size_t word = 0; word < this->alive_.size(); ++word) {
+      for (uint64_t bits = this->alive_[word]; bits != 0; bits &= bits - 1) {
+        f(static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+      }
+    }
+  }
+  [[nodiscard]] Pos pos(uint32_t const index) const {
+    return Pos{this->x_[index], this->y_[index]};
+  }
+  // Number of slots, live or not. Columns are this long.
+  [[nodiscard]] size_t size() const { return this->x_.size(); }
+  [[nodiscard]] size_t count() const { return this->count_; }
+  [[nodiscard]] Real const* x() const { return this->x_.data(); }
+  [[nodiscard]] Real const* y() const { return this->y_.data(); }
+  [[nodiscard]] Real const* vx() const { return this->vx_.data(); }
+  [[nodiscard]] Real const* vy() const { return this->vy_.data(); }
+  [[nodiscard]] Real const* radius() const { return this->radius_.data(); }
+  [[nodiscard]] float const* damage() const { return this->damage_.data(); }
+  [[nodiscard]] uint64_t const* aliveBits() const { return this->alive_.data(); }
+
+private:
+  // What a slot holds besides its position and bits.
+  struct Slot final {
+    Pos origin; // where an integrated bullet was spawned
+    Pos vel;
+    Real radius;
+    float damage;
+    Path path;
+    uint32_t born; // moves made before it was spawned
+    uint32_t removedAt;
+  };
+  // A change to the slots, undone by rewind().
+  struct Change final {
+    enum class Kind : uint8_t {
+      Grow,    // a new slot was allocated
+      Reuse,   // a free slot was allocated; `slot` is what it held
+      Release, // `alive` and `parametric` are its bits before
+      Retire,  // `slot.removedAt` is the one before
+      Revive,
+      Move,
+      Rebase,  // `slot.origin` and `slot.born` are the ones before
+    };
+    Kind kind;
+    uint32_t frame; // the frame it was made for
+    uint32_t index;
+    bool alive;
+    bool parametric;
+    Slot slot;
+  };
+  // Integrated bullets older than kHistoryLength moves are looked for every this many moves, and get their
+  // current position as origin, so that rewind() never moves a bullet again from further back.
+  static constexpr uint32_t kRebaseInterval = 64;
+  [[nodiscard]] Slot slotAt(uint32_t index) const;
+  void log(Change::Kind kind, uint32_t index);
+  void undo(Change const& change);
+  uint32_t allocate(Real radius, float damage);
+  // Path bullets keep their slots as of frame `at`; the others are freed.
+  void retire(uint32_t index, uint32_t at);
+  void release(uint32_t index);
+  // Moves the slots of one chunk, and marks the bullets to remove, free and bring back.
+  void moveChunk(size_t chunk, uint32_t now, Real margin);
+  // Applies the marks in index order.
+  void settle(uint32_t now);
+
+private:
+  std::vector<Real> x_;
+  std::vector<Real> y_;
+  std::vector<Real> vx_;
+  std::vector<Real> vy_;
+  std::vector<Real> radius_;
+  std::vector<float> damage_;
+  std::vector<Real> x0_;
+  std::vector<Real> y0_;
+  std::vector<uint32_t> born_;
+  std::vector<uint32_t> generations_;
+  std::vector<uint64_t> alive_;
+  std::vector<Path> paths_;
+  std::vector<uint64_t> parametric_; // set for path bullets, removed ones included
+  std::vector<uint32_t> removedAt_;   // first frame a removed path bullet is gone in
+  std::vector<uint32_t> free_;
+  std::vector<uint64_t> doomed_;
+  std::vector<uint64_t> dropped_;
+  std::vector<uint64_t> revived_;
+  std::deque<Change> changes_;
+  uint32_t steps_ = 0;      // moves made so far
+  uint32_t now_ = 0;
+  uint32_t changing_ = 1;   // the frame changes are made for: the next one, or the one being settled
+  size_t count_ = 0;
+};
+
+}
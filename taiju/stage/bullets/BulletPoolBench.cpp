@@ -0,0 +1,120 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../../util/Bench.hpp"
+#include "../../../util/ThreadPool.hpp"
+#include "../Value.hpp"
+#include "../Conductor.hpp"
+#include "./BulletPool.hpp"
+
+// Spiral bullets moved every frame: positions recorded into a Value history each frame,
+// vs. paths evaluated by the pool. Then a leap back by 60 frames and the next frame.
+BENCH(TaijuBulletPath) {
+  using namespace taiju;
+  constexpr uint32_t kBullets = 1000;
+  constexpr uint32_t kFrames = 600;
+  auto const pathOf = [](uint32_t const i) {
+    return Path::spiral(0, Pos{192, 128}, 4, 0.5f, static_cast<float>(i) * 0.0063f, 0.02f);
+  };
+  std::printf("%-10s %12s %12s %14s\n", "store", "us/frame", "us/rewind", "bytes/bullet");
+  {
+    Clock clock;
+    volatile float sink = 0;
+    std::vector<std::unique_ptr<Value<Pos>>> history;
+    for (uint32_t i = 0; i < kBullets; ++i) {
+      history.emplace_back(std::make_unique<Value<Pos>>(clock));
+    }
+    double const frame = util::measure([&]() {
+      if (clock.current() >= kFrames) {
+        clock.leap(0);
+      }
+      clock.tick();
+      uint32_t const now = clock.current();
+      for (uint32_t i = 0; i < kBullets; ++i) {
+        *history[i] = pathOf(i).at(now);
+      }
+    });
+    double const rewind = util::measure([&]() {
+      clock.leap(clock.current() > 60 ? clock.current() - 60 : 0);
+      clock.tick();
+      float sum = 0;
+      for (uint32_t i = 0; i < kBullets; ++i) {
+        auto const pos = std::as_const(*history[i]).get();
+        sum += pos.has_value() ? static_cast<float>(pos.value().x) : 0;
+      }
+      sink = sum;
+    });
+    std::printf("%-10s %12.1f %12.1f %14zu\n", "Value", frame * 1e6, rewind * 1e6, sizeof(Value<Pos>));
+  }
+  {
+    BulletPool pool;
+    for (uint32_t i = 0; i < kBullets; ++i) {
+      pool.spawn(pathOf(i), 2, 1);
+    }
+    uint32_t now = 0;
+    double const frame = util::measure([&]() {
+      now = now >= kFrames ? 1 : now + 1;
+      pool.move(now);
+    });
+    double const rewind = util::measure([&]() {
+      now = now > 60 ? now - 60 : 1;
+      pool.move(now);
+    });
+    std::printf("%-10s %12.1f %12.1f %14zu\n", "Path", frame * 1e6, rewind * 1e6, sizeof(Path) + 5 * sizeof(Real) + sizeof(float) + sizeof(uint32_t));
+  }
+}
+
+// 100k bullets, half on paths, moved by move() and on 1 to 16 workers.
+// The hash is taken after 100 more frames on a fresh pool, so it must be the same on every row.
+BENCH(TaijuBulletUpdate) {
+  using namespace taiju;
+  constexpr uint32_t kBullets = 100000;
+  auto const fill = [](BulletPool& pool) {
+    for (uint32_t i = 0; i < kBullets; ++i) {
+      Pos const pos{static_cast<float>(i % 384), static_cast<float>(i % 448)};
+      float const angle = static_cast<float>(i) * 0.0063f;
+      if (i % 2 == 0) {
+        pool.spawn(pos, Pos{std::cos(angle) * 0.01f, std::sin(angle) * 0.01f}, 2, 1);
+      } else {
+        pool.spawn(Path::spiral(0, pos, 0.01f, 0.001f, angle, 0.02f), 2, 1);
+      }
+    }
+  };
+  std::printf("%-8s %12s %8s %18s\n", "workers", "us/frame", "speedup", "hash");
+  double base = 0;
+  for (size_t const numWorkers : {0, 1, 2, 4, 8, 16}) {
+    std::unique_ptr<util::ThreadPool> threads = numWorkers > 0 ? std::make_unique<util::ThreadPool>(numWorkers) : nullptr;
+    auto const move = [&threads](BulletPool& pool, uint32_t const now) {
+      if (threads) {
+        pool.move(now, Conductor::kBulletMargin, *threads);
+      } else {
+        pool.move(now, Conductor::kBulletMargin);
+      }
+    };
+    BulletPool pool;
+    fill(pool);
+    uint32_t now = 0;
+    double const secs = util::measure([&]() {
+      move(pool, ++now);
+    });
+    BulletPool fresh;
+    fill(fresh);
+    for (uint32_t frame = 1; frame <= 100; ++frame) {
+      move(fresh, frame);
+    }
+    if (numWorkers == 0) {
+      base = secs;
+    }
+    std::printf("%-8s %12.1f   x%.2f %18llx\n", numWorkers == 0 ? "move()" : std::to_string(numWorkers).c_str(), secs * 1e6, base / secs,
+                static_cast<unsigned long long>(fresh.hash()));
+  }
+}
@@ -0,0 +1,327 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+#include "../../../util/ThreadPool.hpp"
+#include "./BulletPool.hpp"
+
+namespace taiju {
+
+TEST(TaijuBulletPoolTest, SpawnTest) {
+  BulletPool pool;
+  BulletHandle const a = pool.spawn(Pos{1, 2}, Pos{0.5f, -1}, 3, 10);
+  BulletHandle const b = pool.spawn(Pos{4, 5}, Pos{0, 0}, 1, 20);
+  EXPECT_EQ(2, pool.count());
+  EXPECT_TRUE(pool.valid(a));
+  EXPECT_TRUE(pool.valid(b));
+  EXPECT_EQ(1, pool.x()[a.index]);
+  EXPECT_EQ(5, pool.y()[b.index]);
+  EXPECT_EQ(3, pool.radius()[a.index]);
+  EXPECT_EQ(20, pool.damage()[b.index]);
+  pool.move(1);
+  pool.move(2);
+  EXPECT_EQ(2, pool.pos(a.index).x);
+  EXPECT_EQ(0, pool.pos(a.index).y);
+  EXPECT_EQ(4, pool.pos(b.index).x);
+}
+
+TEST(TaijuBulletPoolTest, ReuseTest) {
+  BulletPool pool;
+  std::vector<BulletHandle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.emplace_back(pool.spawn(Pos{static_cast<float>(i), 0}, Pos{0, 0}, 1, 1));
+  }
+  EXPECT_TRUE(pool.remove(handles[70]));
+  EXPECT_FALSE(pool.remove(handles[70]));
+  EXPECT_FALSE(pool.valid(handles[70]));
+  EXPECT_EQ(99, pool.count());
+
+  // The slot is reused, but the old handle stays stale.
+  BulletHandle const reused = pool.spawn(Pos{-1, 0}, Pos{0, 0}, 1, 1);
+  EXPECT_EQ(70, reused.index);
+  EXPECT_NE(handles[70], reused);
+  EXPECT_FALSE(pool.valid(handles[70]));
+  EXPECT_FALSE(pool.remove(handles[70]));
+  EXPECT_TRUE(pool.valid(reused));
+  EXPECT_EQ(100, pool.size());
+
+  pool.removeAt(3);
+  pool.removeAt(64);
+  std::vector<uint32_t> visited;
+  pool.forEach([&](uint32_t const index) { visited.emplace_back(index); });
+  ASSERT_EQ(98, visited.size());
+  for (size_t i = 1; i < visited.size(); ++i) {
+    EXPECT_LT(visited[i - 1], visited[i]);
+    EXPECT_NE(3, visited[i]);
+    EXPECT_NE(64, visited[i]);
+  }
+
+  pool.clear();
+  EXPECT_EQ(0, pool.count());
+  EXPECT_FALSE(pool.valid(reused));
+  pool.forEach([](uint32_t) { FAIL(); });
+  pool.spawn(Pos{0, 0}, Pos{0, 0}, 1, 1);
+  EXPECT_EQ(100, pool.size());
+}
+
+// 16.16 keeps about 5 decimal digits, so its sines are only that close.
+#if TAIJU_FIXED == 16
+constexpr double kPathTolerance = 1e-3;
+#define EXPECT_PATH_EQ(expected, actual) EXPECT_NEAR(expected, static_cast<float>(actual), kPathTolerance)
+#else
+constexpr double kPathTolerance = 1e-5;
+#define EXPECT_PATH_EQ(expected, actual) EXPECT_FLOAT_EQ(expected, static_cast<float>(actual))
+#endif
+
+TEST(TaijuBulletPoolTest, PathTest) {
+  Path const linear = Path::linear(10, Pos{1, 2}, Pos{0.5f, -1});
+  EXPECT_EQ(1, linear.at(10).x);
+  EXPECT_EQ(6, linear.at(20).x);
+  EXPECT_EQ(-8, linear.at(20).y);
+  Path const accelerated = Path::accelerated(0, Pos{0, 0}, Pos{1, 0}, Pos{0, 2});
+  EXPECT_EQ(4, accelerated.at(4).x);
+  EXPECT_EQ(16, accelerated.at(4).y);
+  // Swings to the left of a bullet going right, that is +y.
+  Path const sine = Path::sine(0, Pos{0, 0}, Pos{2, 0}, 3, std::numbers::pi_v<float> / 20);
+  EXPECT_PATH_EQ(20, sine.at(10).x);
+  EXPECT_PATH_EQ(3, sine.at(10).y);
+  EXPECT_NEAR(0, static_cast<float>(sine.at(20).y), kPathTolerance);
+  Path const spiral = Path::spiral(5, Pos{10, 10}, 1, 0.5f, 0, std::numbers::pi_v<float> / 2);
+  EXPECT_PATH_EQ(11, spiral.at(5).x);
+  EXPECT_NEAR(10, static_cast<float>(spiral.at(6).x), kPathTolerance);
+  EXPECT_PATH_EQ(11.5f, spiral.at(6).y);
+}
+
+TEST(TaijuBulletPoolTest, RewindTest) {
+  BulletPool pool;
+  BulletHandle const a = pool.spawn(Path::spiral(0, Pos{0, 0}, 1, 0.25f, 0, 0.1f), 1, 1);
+  BulletHandle const integrated = pool.spawn(Pos{0, 0}, Pos{1, 1}, 1, 1);
+  std::vector<Pos> trail;
+  BulletHandle b{};
+  for (uint32_t now = 1; now <= 30; ++now) {
+    if (now == 20) {
+      b = pool.spawn(Path::sine(20, Pos{5, 5}, Pos{0, 1}, 2, 0.3f), 1, 1);
+    }
+    pool.move(now);
+    trail.emplace_back(pool.pos(a.index));
+    EXPECT_EQ(a.index, pool.handleAt(a.index).index);
+  }
+  EXPECT_TRUE(pool.parametric(a.index));
+  EXPECT_FALSE(pool.parametric(integrated.index));
+  EXPECT_EQ(30, pool.x()[integrated.index]);
+
+  // Going back to frame 10: the paths are where they were, and b is not spawned yet.
+  pool.move(10);
+  EXPECT_EQ(trail[9].x, pool.pos(a.index).x);
+  EXPECT_EQ(trail[9].y, pool.pos(a.index).y);
+  EXPECT_FALSE(pool.valid(b));
+  EXPECT_EQ(2, pool.count());
+  for (uint32_t now = 11; now <= 30; ++now) {
+    pool.move(now);
+    EXPECT_EQ(trail[now - 1].x, pool.pos(a.index).x);
+    EXPECT_EQ(trail[now - 1].y, pool.pos(a.index).y);
+  }
+  // Reusing the slot of a path with an integrated bullet makes it integrated.
+  BulletHandle const c = pool.spawn(Pos{0, 0}, Pos{1, 0}, 1, 1);
+  EXPECT_EQ(b.index, c.index);
+  EXPECT_FALSE(pool.parametric(c.index));
+  pool.move(31);
+  EXPECT_EQ(1, pool.x()[c.index]);
+}
+
+TEST(TaijuBulletPoolTest, RemovedPathTest) {
+  BulletPool pool;
+  // Leaves the field by the right edge at frame 39.
+  BulletHandle const leaving = pool.spawn(Path::linear(0, Pos{kFieldWidth - 30, 10}, Pos{1, 0}), 1, 1);
+  BulletHandle const hit = pool.spawn(Path::linear(0, Pos{10, 10}, Pos{0, 1}), 1, 1);
+  BulletHandle const integrated = pool.spawn(Pos{10, 10}, Pos{1, 0}, 1, 1);
+  for (uint32_t now = 1; now <= 50; ++now) {
+    pool.move(now, 8);
+    EXPECT_EQ(now < 39, pool.valid(leaving)) << now;
+    if (now == 20) {
+      EXPECT_TRUE(pool.remove(hit));
+      EXPECT_TRUE(pool.remove(integrated));
+    }
+  }
+  EXPECT_FALSE(pool.valid(hit));
+  EXPECT_EQ(0, pool.count());
+  // Their slots are kept, so new bullets do not take them.
+  BulletHandle const other = pool.spawn(Pos{0, 0}, Pos{0, 0}, 1, 1);
+  EXPECT_EQ(integrated.index, other.index);
+  pool.remove(other);
+
+  // Back before both removals: the path bullets are back, with the same handles. The integrated one is not.
+  pool.move(15, 8);
+  EXPECT_TRUE(pool.valid(leaving));
+  EXPECT_TRUE(pool.valid(hit));
+  EXPECT_FALSE(pool.valid(integrated));
+  EXPECT_EQ(2, pool.count());
+  EXPECT_PATH_EQ(369, pool.pos(leaving.index).x);
+  EXPECT_PATH_EQ(25, pool.pos(hit.index).y);
+  // The frame the hit happened in still has the bullet; the removal is for the script to make again.
+  pool.move(20, 8);
+  EXPECT_TRUE(pool.valid(hit));
+  pool.remove(hit);
+  pool.move(21, 8);
+  EXPECT_FALSE(pool.valid(hit));
+
+  // Once no leap can reach the removal, the slot is freed.
+  pool.move(21 + kHistoryLength, 8);
+  EXPECT_EQ(0, pool.count());
+  EXPECT_NE(hit, pool.spawn(Pos{0, 0}, Pos{0, 0}, 1, 1));
+  EXPECT_EQ(3, pool.size());
+  pool.move(22 + kHistoryLength, 8);
+  EXPECT_FALSE(pool.valid(leaving));
+  EXPECT_FALSE(pool.valid(hit));
+}
+
+TEST(TaijuBulletPoolTest, MarginTest) {
+  BulletPool pool;
+  BulletHandle const inside = pool.spawn(Pos{-9, kFieldHeight + 9}, Pos{0, 0}, 1, 1);
+  BulletHandle const leaving = pool.spawn(Pos{kFieldWidth + 9, 0}, Pos{2, 0}, 1, 1);
+  pool.move(1, 10);
+  EXPECT_TRUE(pool.valid(inside));
+  EXPECT_FALSE(pool.valid(leaving));
+  EXPECT_EQ(1, pool.count());
+}
+
+// Many frames of spawns, removals, culling and leaps: the parallel moves must leave the same state.
+TEST(TaijuBulletPoolTest, ParallelTest) {
+  std::mt19937 rand(42);
+  auto const uniform = [&rand](float const from, float const to) {
+    return from + (to - from) * static_cast<float>(rand() % 65536) / 65536.0f;
+  };
+  util::ThreadPool threads(4);
+  BulletPool serial;
+  BulletPool parallel;
+  uint32_t now = 0;
+  for (uint32_t frame = 0; frame < 2000; ++frame) {
+    now = frame % 300 == 299 ? now - 50 : now + 1;
+    for (int i = 0; i < 40; ++i) {
+      Pos const pos{uniform(0, static_cast<float>(kFieldWidth)), uniform(0, static_cast<float>(kFieldHeight))};
+      float const angle = uniform(0, 6.2832f);
+      if (rand() % 2 == 0) {
+        Pos const vel{std::cos(angle) * 2, std::sin(angle) * 2};
+        EXPECT_EQ(serial.spawn(pos, vel, 2, 1), parallel.spawn(pos, vel, 2, 1));
+      } else {
+        Path const path = Path::spiral(now, pos, 1.5f, 0.05f, angle, 0.03f);
+        EXPECT_EQ(serial.spawn(path, 2, 1), parallel.spawn(path, 2, 1));
+      }
+    }
+    if (serial.size() > 0) {
+      auto const index = static_cast<uint32_t>(rand() % serial.size());
+      serial.removeAt(index);
+      parallel.removeAt(index);
+    }
+    serial.move(now, 16);
+    parallel.move(now, 16, threads);
+    ASSERT_EQ(serial.count(), parallel.count());
+    ASSERT_EQ(serial.hash(), parallel.hash()) << "frame " << frame;
+  }
+  EXPECT_GT(serial.size(), BulletPool::kChunkSize);
+}
+
+// Spawns, removals and culling of both kinds of bullets, the same in every run of a frame.
+TEST(TaijuBulletPoolTest, UndoTest) {
+  auto const frame = [](BulletPool& pool, uint32_t const now) {
+    std::mt19937 rand(now);
+    for (int i = 0; i < 20; ++i) {
+      Pos const pos{static_cast<float>(rand() % 384), static_cast<float>(rand() % 448)};
+      float const angle = static_cast<float>(rand() % 628) * 0.01f;
+      if (rand() % 2 == 0) {
+        pool.spawn(pos, Pos{std::cos(angle) * 3, std::sin(angle) * 3}, 2, 1);
+      } else {
+        pool.spawn(Path::spiral(now, pos, 1.5f, 0.05f, angle, 0.03f), 2, 1);
+      }
+    }
+    if (pool.size() > 0) {
+      pool.removeAt(static_cast<uint32_t>(rand() % pool.size()));
+    }
+    pool.move(now, 16);
+  };
+  BulletPool straight;
+  BulletPool rewound;
+  std::vector<uint64_t> hashes;
+  for (uint32_t now = 1; now <= 200; ++now) {
+    frame(straight, now);
+    frame(rewound, now);
+    hashes.emplace_back(straight.hash());
+  }
+  for (uint32_t const to : {150u, 60u, 0u}) {
+    rewound.rewind(to);
+    if (to > 0) {
+      EXPECT_EQ(hashes[to - 1], rewound.hash()) << to;
+    }
+    for (uint32_t now = to + 1; now <= 200; ++now) {
+      frame(rewound, now);
+    }
+    EXPECT_EQ(straight.hash(), rewound.hash()) << to;
+    EXPECT_EQ(straight.count(), rewound.count()) << to;
+  }
+  EXPECT_EQ(0, (rewound.rewind(0), rewound.size()));
+}
+
+TEST(TaijuBulletPoolTest, RebaseTest) {
+  // Older than the history: the bullet is moved again from a later origin, to the very same place.
+  BulletPool pool;
+  BulletHandle const slow = pool.spawn(Pos{10, 10}, Pos{0.01f, 0.03f}, 1, 1);
+  std::vector<Pos> trail;
+  for (uint32_t now = 1; now <= kHistoryLength + 300; ++now) {
+    pool.move(now);
+    trail.emplace_back(pool.pos(slow.index));
+  }
+  for (size_t const to : {kHistoryLength + 250, kHistoryLength + 100, size_t(400)}) {
+    pool.rewind(static_cast<uint32_t>(to));
+    EXPECT_TRUE(pool.valid(slow));
+    EXPECT_TRUE(trail[to - 1].x == pool.pos(slow.index).x) << to;
+    EXPECT_TRUE(trail[to - 1].y == pool.pos(slow.index).y) << to;
+  }
+}
+
+// Bullets made and moved in Real only, through every kind of motion and the culling.
+// Fixed point must give the same hash on every compiler, flag and CPU, so it is pinned.
+TEST(TaijuBulletPoolTest, ReplayTest) {
+#if TAIJU_FIXED == 0
+  GTEST_SKIP() << "Float results depend on the build.";
+#else
+  BulletPool pool;
+  for (int32_t i = 0; i < 3000; ++i) {
+    Pos const pos{Real(i % 384), Real(i % 448)};
+    Real const angle = Real(i) * Real(0.0063f);
+    Pos const vel{cos(angle) * 2, sin(angle) * 2};
+    switch (i % 4) {
+      case 0:
+        pool.spawn(pos, vel, 2, 1);
+        break;
+      case 1:
+        pool.spawn(Path::accelerated(0, pos, vel, Pos{0, Real(0.01f)}), 2, 1);
+        break;
+      case 2:
+        pool.spawn(Path::sine(0, pos, vel, 6, Real(0.1f)), 2, 1);
+        break;
+      default:
+        pool.spawn(Path::spiral(0, pos, 1, Real(0.5f), angle, Real(0.03f)), 2, 1);
+        break;
+    }
+  }
+  for (uint32_t now = 1; now <= 300; ++now) {
+    pool.move(now, 32);
+  }
+  EXPECT_GT(pool.count(), 300);
+#if TAIJU_FIXED == 16
+  EXPECT_EQ(0x5661cb70555455b4u, pool.hash());
+#else
+  EXPECT_EQ(0x8a9c5e162bbc1d7du, pool.hash());
+#endif
+#endif
+}
+
+}
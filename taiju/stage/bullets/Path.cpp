@@ -0,0 +1,67 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <cmath>
+#include "Path.hpp"
+
+namespace taiju {
+
+Path Path::linear(uint32_t const from, Pos const origin, Pos const velocity) {
+  return Path{Motion::Linear, from, origin, {velocity.x, velocity.y, 0, 0}};
+}
+
+Path Path::accelerated(uint32_t const from, Pos const origin, Pos const velocity, Pos const accel) {
+  return Path{Motion::Accelerated, from, origin, {velocity.x, velocity.y, accel.x, accel.y}};
+}
+
+Path Path::sine(uint32_t const from, Pos const origin, Pos const velocity, Real const amplitude, Real const omega) {
+  return Path{Motion::Sine, from, origin, {velocity.x, velocity.y, amplitude, omega}};
+}
+
+Path Path::spiral(uint32_t const from, Pos const center, Real const radius, Real const radiusSpeed, Real const angle, Real const omega) {
+  return Path{Motion::Spiral, from, center, {radius, radiusSpeed, angle, omega}};
+}
+
+namespace {
+
+// Plain names, so that the fixed-point overloads are found by argument-dependent lookup.
+using std::sin;
+using std::cos;
+
+Real length(Real const x, Real const y) {
+#if TAIJU_FIXED == 0
+  return std::hypot(x, y);
+#else
+  return sqrt(x * x + y * y);
+#endif
+}
+
+}
+
+Pos Path::at(uint32_t const now) const {
+  Real const t = static_cast<int32_t>(now - this->from);
+  auto const& p = this->params;
+  switch (this->motion) {
+    case Motion::Linear:
+      return Pos{this->origin.x + p[0] * t, this->origin.y + p[1] * t};
+    case Motion::Accelerated:
+      return Pos{this->origin.x + (p[0] + p[2] * t * Real(0.5f)) * t, this->origin.y + (p[1] + p[3] * t * Real(0.5f)) * t};
+    case Motion::Sine: {
+      // Sideways is the velocity turned by 90 degrees.
+      Real const speed = length(p[0], p[1]);
+      Real const swing = speed > 0 ? p[2] * sin(p[3] * t) / speed : Real(0);
+      return Pos{this->origin.x + p[0] * t - p[1] * swing, this->origin.y + p[1] * t + p[0] * swing};
+    }
+    case Motion::Spiral: {
+      Real const r = p[0] + p[1] * t;
+      Real const theta = p[2] + p[3] * t;
+      return Pos{this->origin.x + r * cos(theta), this->origin.y + r * sin(theta)};
+    }
+  }
+  return this->origin;
+}
+
+}
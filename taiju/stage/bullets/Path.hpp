@@ -0,0 +1,39 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "../Geom.hpp"
+
+namespace taiju {
+
+enum class Motion : uint8_t {
+  Linear = 0,  // origin + v t
+  Accelerated, // origin + v t + a t^2 / 2
+  Sine,        // origin + v t, swinging sideways by amplitude * sin(omega t)
+  Spiral,      // around origin, at radius r0 + dr t and angle theta0 + omega t
+};
+
+// A closed-form bullet path: the position is a function of the frames since `from`,
+// so it needs no per-frame state and is valid at any frame, rewound ones included.
+struct Path final {
+  Motion motion;
+  uint32_t from;
+  Pos origin;
+  std::array<Real, 4> params;
+
+  [[nodiscard]] static Path linear(uint32_t from, Pos origin, Pos velocity);
+  [[nodiscard]] static Path accelerated(uint32_t from, Pos origin, Pos velocity, Pos accel);
+  [[nodiscard]] static Path sine(uint32_t from, Pos origin, Pos velocity, Real amplitude, Real omega);
+  [[nodiscard]] static Path spiral(uint32_t from, Pos center, Real radius, Real radiusSpeed, Real angle, Real omega);
+
+  // `now` must not be before `from`.
+  [[nodiscard]] Pos at(uint32_t now) const;
+};
+
+}
@@ -6,13 +6,11 @@
  */
 #pragma once
 
-#include <cstdint>
-#include "../Value.hpp"
 #include "Witch.hpp"
 
 namespace taiju {
 
-class Chitose final : public Witch {
+struct Chitose final {
 };
 
-}
\ No newline at end of file
+}
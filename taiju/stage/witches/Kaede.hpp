@@ -6,13 +6,11 @@
  */
 #pragma once
 
-#include <cstdint>
-#include "../Value.hpp"
 #include "Witch.hpp"
 
 namespace taiju {
 
-class Kaede final : public FriendWitch {
+struct Kaede final {
 };
 
 }
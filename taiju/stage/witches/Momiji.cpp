@@ -4,12 +4,20 @@
  *
  * Copyright 2020-, Kaede Fujisaki
  */
+#include <algorithm>
 #include "Momiji.hpp"
-#include "../Stage.hpp"
+#include "../World.hpp"
 
 namespace taiju {
 
-void Momiji::move(std::shared_ptr<Stage>) {
+void Momiji::move(World& world, Input const input) {
+  Real const speed = input.held(Button::Slow) ? kSlowSpeed : kSpeed;
+  Real const dx = static_cast<int>(input.held(Button::Right)) - static_cast<int>(input.held(Button::Left));
+  Real const dy = static_cast<int>(input.held(Button::Down)) - static_cast<int>(input.held(Button::Up));
+  world.each<Momiji const, Body>([&](Entity, Momiji const&, Body& body) {
+    body.pos.x = std::clamp(body.pos.x + dx * speed, Real(0), kFieldWidth);
+    body.pos.y = std::clamp(body.pos.y + dy * speed, Real(0), kFieldHeight);
+  });
 }
 
 }
@@ -6,16 +6,18 @@
  */
 #pragma once
 
-#include <cstdint>
 #include "Witch.hpp"
-#include "../Value.hpp"
+#include "../Input.hpp"
 
 namespace taiju {
 
-class Stage;
-class Momiji final : public FriendWitch {
-public:
-  void move(std::shared_ptr<Stage>);
+class World;
+struct Momiji final {
+  // Pixels per frame.
+  static constexpr Real kSpeed = 4;
+  static constexpr Real kSlowSpeed = 2;
+  // Moves the Momiji of the world by the input, within the field.
+  static void move(World& world, Input input);
 };
 
 }
@@ -1,15 +0,0 @@
-/* coding: utf-8 */
-/**
- * wakaba
- *
- * Copyright 2020-, Kaede Fujisaki
- */
-#include "Sora.hpp"
-
-namespace taiju {
-
-void Sora::hit(std::shared_ptr<Bullet> bullet) {
-
-}
-
-}
\ No newline at end of file
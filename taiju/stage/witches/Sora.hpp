@@ -10,10 +10,7 @@
 
 namespace taiju {
 
-class Bullet;
-class Sora final : Witch {
-public:
-  void hit(std::shared_ptr<Bullet> bullet);
+struct Sora final {
 };
 
 }
@@ -7,25 +7,20 @@
 #pragma once
 
 #include "../Geom.hpp"
-#include "../Actor.hpp"
-#include "../Value.hpp"
 
 namespace taiju {
 
-class Witch : public Actor {
-VDEF_RW(Pos, pos, public, protected);
-public:
-  static constexpr float kRadius = 1;
-  [[nodiscard]] float radius() const {
-    return kRadius;
-  }
+// Components of the witches, which are entities of the World of the stage.
+// Every witch has a Body and the tag of its own, and those that take damage have Health.
+struct Body final {
+  static constexpr Real kRadius = 1;
+  Pos pos;
+  Real radius = kRadius;
 };
 
-class Bullet;
-class FriendWitch : public Witch {
-VDEF_RW(float, hp, public, protected);
-public:
-  void hit(std::shared_ptr<Bullet> const& bullet);
+struct Health final {
+  static constexpr float kMaxHp = 100;
+  float hp = kMaxHp;
 };
 
 }
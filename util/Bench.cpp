@@ -0,0 +1,45 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <vector>
+#include <utility>
+#include <cstdio>
+#include "Bench.hpp"
+
+namespace util {
+
+namespace {
+
+std::vector<std::pair<std::string, std::function<void()>>>& benches() {
+  static std::vector<std::pair<std::string, std::function<void()>>> benches;
+  return benches;
+}
+
+}
+
+int registerBench(char const* name, std::function<void()> body) {
+  benches().emplace_back(name, std::move(body));
+  return static_cast<int>(benches().size());
+}
+
+int runBenches(std::string const& filter) {
+  for (auto const& [name, body] : benches()) {
+    if (name.find(filter) == std::string::npos) {
+      continue;
+    }
+    std::printf("=== %s\n", name.c_str());
+    std::fflush(stdout);
+    body();
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+  return util::runBenches(argc > 1 ? argv[1] : "");
+}
@@ -0,0 +1,41 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <functional>
+#include <cstddef>
+
+namespace util {
+
+// Minimal benchmark registry. Benchmarks are run by bench_main.
+int registerBench(char const* name, std::function<void()> body);
+int runBenches(std::string const& filter);
+
+// Runs f() repeatedly for at least `minDuration`, and returns the average seconds per call.
+template <typename F>
+double measure(F&& f, std::chrono::milliseconds const minDuration = std::chrono::milliseconds(200)) {
+  using Clock = std::chrono::steady_clock;
+  size_t count = 0;
+  auto const beg = Clock::now();
+  auto now = beg;
+  do {
+    f();
+    count++;
+    now = Clock::now();
+  } while (now - beg < minDuration);
+  return std::chrono::duration<double>(now - beg).count() / static_cast<double>(count);
+}
+
+}
+
+#define BENCH(name) \
+  static void name##Bench(); \
+  [[maybe_unused]] static int const name##Registered = ::util::registerBench(#name, name##Bench); \
+  static void name##Bench()
@@ -0,0 +1,53 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <algorithm>
+#include <new>
+#include "BlockPool.hpp"
+
+namespace util {
+
+namespace {
+
+constexpr size_t kAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+}
+
+BlockPool::BlockPool(size_t const blockSize, size_t const blocksPerChunk)
+:blockSize_((std::max(blockSize, sizeof(void*)) + kAlignment - 1) / kAlignment * kAlignment)
+,blocksPerChunk_(std::max<size_t>(1, blocksPerChunk))
+{
+}
+
+void* BlockPool::allocate() {
+  if (this->free_ == nullptr) {
+    this->grow();
+  }
+  void* const block = this->free_;
+  this->free_ = *static_cast<void**>(block);
+  this->numAllocated_++;
+  return block;
+}
+
+void BlockPool::deallocate(void* const ptr) noexcept {
+  *static_cast<void**>(ptr) = this->free_;
+  this->free_ = ptr;
+  this->numAllocated_--;
+}
+
+void BlockPool::grow() {
+  auto chunk = std::make_unique<std::byte[]>(this->blockSize_ * this->blocksPerChunk_);
+  // Link the blocks in address order, so they are handed out sequentially.
+  for (size_t i = this->blocksPerChunk_; i > 0; --i) {
+    void* const block = chunk.get() + (i - 1) * this->blockSize_;
+    *static_cast<void**>(block) = this->free_;
+    this->free_ = block;
+  }
+  this->chunks_.emplace_back(std::move(chunk));
+}
+
+}
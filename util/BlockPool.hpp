@@ -0,0 +1,46 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace util {
+
+// Fixed-size blocks carved out of chunks, recycled through an intrusive free list.
+// Chunks are never returned to the system until the pool is destroyed. Not thread-safe.
+class BlockPool final {
+public:
+  BlockPool() = delete;
+  BlockPool(BlockPool const&) = delete;
+  BlockPool(BlockPool&&) = delete;
+  BlockPool& operator=(BlockPool const&) = delete;
+  BlockPool& operator=(BlockPool&&) = delete;
+  // Blocks are aligned as operator new does.
+  explicit BlockPool(size_t blockSize, size_t blocksPerChunk = 64);
+  ~BlockPool() noexcept = default;
+
+public:
+  void* allocate();
+  void deallocate(void* ptr) noexcept;
+  [[nodiscard]] size_t blockSize() const { return this->blockSize_; }
+  [[nodiscard]] size_t numAllocated() const { return this->numAllocated_; }
+
+private:
+  void grow();
+
+private:
+  size_t const blockSize_;
+  size_t const blocksPerChunk_;
+  std::vector<std::unique_ptr<std::byte[]>> chunks_;
+  void* free_ = nullptr;
+  size_t numAllocated_ = 0;
+};
+
+}
@@ -38,7 +38,7 @@ std::vector<uint8_t> readAllFromFile(std::string const &fileName) noexcept(false
   std::vector<uint8_t> dat;
   dat.resize(fileSize);
   size_t pos = 0;
-  while(!std::feof(file)) {
+  while(pos < dat.size() && !std::feof(file)) {
     size_t const left = dat.size() - pos;
 #ifdef WIN32
     size_t const readed = fread_s(std::next(dat.data(), pos), dat.size() - pos, 1, left, file);
@@ -46,11 +46,12 @@ std::vector<uint8_t> readAllFromFile(std::string const &fileName) noexcept(false
     size_t const readed = fread(std::next(dat.data(), pos), 1, left, file);
 #endif
     if (readed < left && std::ferror(file) != 0) {
+      int const readErr = std::ferror(file);
       fclose(file);
       throw std::filesystem::filesystem_error(
           "Error to read all contents from the file",
           fileName,
-          std::make_error_code(static_cast<std::errc>(std::ferror(file))));
+          std::make_error_code(static_cast<std::errc>(readErr)));
     }
     pos += readed;
   }
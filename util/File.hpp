@@ -9,6 +9,8 @@
 
 #include <optional>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace util {
 
@@ -82,7 +82,7 @@ private:
     if (level_ > level) {
       return;
     }
-    std::string const msg = fmt::format(fmt, std::forward<Args>(args)...);
+    std::string const msg = fmt::vformat(fmt, fmt::make_format_args(args...));
     std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
     std::time_t t = std::chrono::system_clock::to_time_t(now);
     std::tm tm{};
@@ -0,0 +1,52 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "File.hpp"
+#include "MappedFile.hpp"
+
+namespace util {
+
+MappedFile::MappedFile(std::filesystem::path const& path) {
+#if defined(WIN32)
+  if (!std::filesystem::exists(path)) {
+    return;
+  }
+  this->buff_ = readAllFromFile(path.string());
+  this->data_ = this->buff_.data();
+  this->size_ = this->buff_.size();
+#else
+  int const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* const addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      this->data_ = static_cast<uint8_t const*>(addr);
+      this->size_ = static_cast<size_t>(st.st_size);
+    }
+  }
+  ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() noexcept {
+#if !defined(WIN32)
+  if (this->data_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(this->data_), this->size_);
+  }
+#endif
+}
+
+}
@@ -0,0 +1,40 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace util {
+
+// A read-only view of a whole file. It is memory-mapped where possible, read into memory elsewhere.
+// A missing or empty file gives an empty view.
+class MappedFile final {
+public:
+  MappedFile() = delete;
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+  explicit MappedFile(std::filesystem::path const& path);
+  ~MappedFile() noexcept;
+
+public:
+  [[nodiscard]] uint8_t const* data() const { return this->data_; }
+  [[nodiscard]] size_t size() const { return this->size_; }
+
+private:
+  uint8_t const* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(WIN32)
+  std::vector<uint8_t> buff_;
+#endif
+};
+
+}
@@ -0,0 +1,33 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include "Metrics.hpp"
+
+namespace util {
+
+void Metrics::add(std::string const& name, uint64_t const delta) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->counters_[name] += delta;
+}
+
+uint64_t Metrics::get(std::string const& name) const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto const it = this->counters_.find(name);
+  return it != this->counters_.end() ? it->second : 0;
+}
+
+std::map<std::string, uint64_t> Metrics::snapshot() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->counters_;
+}
+
+void Metrics::reset() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->counters_.clear();
+}
+
+}
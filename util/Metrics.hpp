@@ -0,0 +1,37 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+namespace util {
+
+// Named counters, shared by subsystems to report what happened, e.g. "donut.vm.preempted".
+class Metrics final {
+public:
+  Metrics() = default;
+  Metrics(Metrics const&) = delete;
+  Metrics(Metrics&&) = delete;
+  Metrics& operator=(Metrics const&) = delete;
+  Metrics& operator=(Metrics&&) = delete;
+
+public:
+  void add(std::string const& name, uint64_t delta = 1);
+  [[nodiscard]] uint64_t get(std::string const& name) const;
+  [[nodiscard]] std::map<std::string, uint64_t> snapshot() const;
+  void reset();
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, uint64_t> counters_;
+};
+
+}
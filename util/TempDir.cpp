@@ -0,0 +1,34 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <fmt/format.h>
+#include "TempDir.hpp"
+
+namespace util {
+
+TempDir::TempDir(std::string const& prefix) {
+  std::random_device seed;
+  std::mt19937_64 rand((uint64_t(seed()) << 32) | seed());
+  for (int i = 0; i < 16; ++i) {
+    std::filesystem::path const path = std::filesystem::temp_directory_path() / fmt::format("{}-{:016x}", prefix, rand());
+    // create_directory() is false if it already exists, so two instances never get the same one.
+    if (std::filesystem::create_directory(path)) {
+      this->path_ = path;
+      return;
+    }
+  }
+  throw std::runtime_error(fmt::format("Failed to create a temp directory for {}", prefix));
+}
+
+TempDir::~TempDir() noexcept {
+  std::error_code err;
+  std::filesystem::remove_all(this->path_, err);
+}
+
+}
@@ -0,0 +1,34 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+namespace util {
+
+// A new, empty directory under the system temp directory, removed with its contents on destruction.
+// The name is unique per instance, so that concurrent runs do not share it.
+class TempDir final {
+public:
+  TempDir() = delete;
+  TempDir(TempDir const&) = delete;
+  TempDir(TempDir&&) = delete;
+  TempDir& operator=(TempDir const&) = delete;
+  TempDir& operator=(TempDir&&) = delete;
+  explicit TempDir(std::string const& prefix);
+  ~TempDir() noexcept;
+
+public:
+  [[nodiscard]] std::filesystem::path const& path() const { return this->path_; }
+  [[nodiscard]] std::filesystem::path operator/(std::filesystem::path const& name) const { return this->path_ / name; }
+
+private:
+  std::filesystem::path path_;
+};
+
+}
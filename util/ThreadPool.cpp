@@ -0,0 +1,143 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include "ThreadPool.hpp"
+
+namespace util {
+
+namespace {
+
+constexpr uint64_t pack(uint64_t const begin, uint64_t const end) {
+  return begin | (end << 32u);
+}
+
+constexpr uint64_t beginOf(uint64_t const bounds) {
+  return bounds & 0xffffffffu;
+}
+
+constexpr uint64_t endOf(uint64_t const bounds) {
+  return bounds >> 32u;
+}
+
+}
+
+ThreadPool::ThreadPool(size_t const numWorkers)
+:ranges_(std::make_unique<Range[]>(std::max<size_t>(1, numWorkers)))
+{
+  for (size_t i = 1; i < std::max<size_t>(1, numWorkers); ++i) {
+    this->threads_.emplace_back([this, i]() { this->loop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stop_ = true;
+  }
+  this->wakeUp_.notify_all();
+  for (std::thread& th : this->threads_) {
+    th.join();
+  }
+}
+
+void ThreadPool::run(size_t const numTasks, Task const& f) {
+  if (numTasks > 0xffffffffu) {
+    throw std::invalid_argument("Too many tasks.");
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->task_ = &f;
+    size_t const numWorkers = this->numWorkers();
+    for (size_t w = 0; w < numWorkers; ++w) {
+      this->ranges_[w].bounds.store(pack(numTasks * w / numWorkers, numTasks * (w + 1) / numWorkers), std::memory_order_relaxed);
+    }
+    this->error_ = nullptr;
+    this->running_ = this->threads_.size();
+    this->generation_++;
+  }
+  this->wakeUp_.notify_all();
+  this->work(0);
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->finished_.wait(lock, [this]() { return this->running_ == 0; });
+  this->task_ = nullptr;
+  if (this->error_) {
+    std::rethrow_exception(this->error_);
+  }
+}
+
+void ThreadPool::work(size_t const worker) {
+  size_t i = 0;
+  for (;;) {
+    if (!this->pop(worker, i)) {
+      if (this->steal(worker)) {
+        continue;
+      }
+      return;
+    }
+    try {
+      (*this->task_)(worker, i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      if (!this->error_) {
+        this->error_ = std::current_exception();
+      }
+    }
+  }
+}
+
+bool ThreadPool::pop(size_t const worker, size_t& task) {
+  std::atomic<uint64_t>& bounds = this->ranges_[worker].bounds;
+  uint64_t cur = bounds.load(std::memory_order_acquire);
+  while (beginOf(cur) < endOf(cur)) {
+    if (bounds.compare_exchange_weak(cur, pack(beginOf(cur) + 1, endOf(cur)), std::memory_order_acq_rel)) {
+      task = beginOf(cur);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Called only when the worker has no tasks left, so nobody else writes its range meanwhile.
+bool ThreadPool::steal(size_t const worker) {
+  size_t const numWorkers = this->numWorkers();
+  for (size_t k = 1; k < numWorkers; ++k) {
+    std::atomic<uint64_t>& victim = this->ranges_[(worker + k) % numWorkers].bounds;
+    uint64_t cur = victim.load(std::memory_order_acquire);
+    while (beginOf(cur) < endOf(cur)) {
+      uint64_t const mid = beginOf(cur) + (endOf(cur) - beginOf(cur)) / 2;
+      if (victim.compare_exchange_weak(cur, pack(beginOf(cur), mid), std::memory_order_acq_rel)) {
+        this->ranges_[worker].bounds.store(pack(mid, endOf(cur)), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ThreadPool::loop(size_t const worker) {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      this->wakeUp_.wait(lock, [&]() { return this->stop_ || this->generation_ != seen; });
+      if (this->stop_) {
+        return;
+      }
+      seen = this->generation_;
+    }
+    this->work(worker);
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->running_--;
+    }
+    this->finished_.notify_one();
+  }
+}
+
+}
@@ -0,0 +1,70 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+// Tasks are split evenly among the workers; a worker that runs out of them steals the latter half
+// of the tasks left to another worker.
+class ThreadPool final {
+public:
+  // (worker index, task index)
+  using Task = std::function<void(size_t, size_t)>;
+
+public:
+  ThreadPool() = delete;
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+  // The calling thread works as the worker 0, so `numWorkers - 1` threads are spawned.
+  explicit ThreadPool(size_t numWorkers);
+  ~ThreadPool() noexcept;
+
+public:
+  // Runs f(worker, i) for every i in [0, numTasks), and waits for all of them.
+  // The first exception thrown by the tasks is rethrown.
+  void run(size_t numTasks, Task const& f);
+  [[nodiscard]] size_t numWorkers() const { return this->threads_.size() + 1; }
+
+private:
+  void work(size_t worker);
+  void loop(size_t worker);
+  bool pop(size_t worker, size_t& task);
+  bool steal(size_t worker);
+
+private:
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wakeUp_;
+  std::condition_variable finished_;
+  uint64_t generation_ = 0;
+  size_t running_ = 0;
+  bool stop_ = false;
+private:
+  // Tasks left to each worker: [begin, end), packed as begin | end << 32.
+  struct alignas(64) Range final {
+    std::atomic<uint64_t> bounds = 0;
+  };
+  std::unique_ptr<Range[]> ranges_;
+  Task const* task_ = nullptr;
+  std::exception_ptr error_;
+};
+
+}
@@ -0,0 +1,62 @@
+/* coding: utf-8 */
+/**
+ * wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include "./ThreadPool.hpp"
+
+namespace util {
+
+TEST(ThreadPoolTest, RunTest) {
+  for (size_t const numWorkers : {1, 2, 3, 8}) {
+    ThreadPool pool(numWorkers);
+    for (size_t const numTasks : {0, 1, 2, 7, 1000}) {
+      std::vector<std::atomic<int>> counts(numTasks);
+      pool.run(numTasks, [&](size_t const worker, size_t const i) {
+        EXPECT_LT(worker, numWorkers);
+        counts[i]++;
+      });
+      for (size_t i = 0; i < numTasks; ++i) {
+        EXPECT_EQ(1, counts[i].load()) << numWorkers << " workers, task " << i << "/" << numTasks;
+      }
+    }
+  }
+}
+
+// Tasks of a busy worker are stolen by the others.
+TEST(ThreadPoolTest, StealTest) {
+  ThreadPool pool(4);
+  std::vector<size_t> workers(64);
+  pool.run(workers.size(), [&](size_t const worker, size_t const i) {
+    if (i == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    workers[i] = worker;
+  });
+  // The first 16 tasks are given to the calling thread, which is stuck in the first one.
+  size_t stolen = 0;
+  for (size_t i = 1; i < 16; ++i) {
+    stolen += workers[i] != workers[0] ? 1 : 0;
+  }
+  EXPECT_LT(0, stolen);
+}
+
+TEST(ThreadPoolTest, ErrorTest) {
+  ThreadPool pool(2);
+  std::atomic<size_t> ran = 0;
+  EXPECT_THROW(pool.run(10, [&](size_t, size_t const i) {
+    ran++;
+    if (i == 3) {
+      throw std::runtime_error("error");
+    }
+  }), std::runtime_error);
+  EXPECT_EQ(10, ran.load());
+}
+
+}
@@ -0,0 +1,160 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#include <set>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fmt/format.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+#include "Watcher.hpp"
+
+namespace util {
+
+#if defined(__linux__)
+
+Watcher::Watcher(std::string dir, Callback callback, std::chrono::milliseconds const settle)
+:dir_(std::move(dir))
+,callback_(std::move(callback))
+,settle_(settle)
+{
+  this->inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (this->inotify_ < 0) {
+    throw std::runtime_error(fmt::format("Failed to init inotify: {}", std::strerror(errno)));
+  }
+  // Written in place, or renamed into the directory.
+  if (inotify_add_watch(this->inotify_, this->dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    int const err = errno;
+    close(this->inotify_);
+    throw std::runtime_error(fmt::format("Failed to watch \"{}\": {}", this->dir_, std::strerror(err)));
+  }
+  this->stop_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->stop_ < 0) {
+    int const err = errno;
+    close(this->inotify_);
+    throw std::runtime_error(fmt::format("Failed to make an eventfd: {}", std::strerror(err)));
+  }
+  this->thread_ = std::thread([this]() { this->loop(); });
+}
+
+Watcher::~Watcher() noexcept {
+  uint64_t const one = 1;
+  [[maybe_unused]] ssize_t const written = write(this->stop_, &one, sizeof(one));
+  this->thread_.join();
+  close(this->stop_);
+  close(this->inotify_);
+}
+
+void Watcher::loop() {
+  alignas(inotify_event) char buf[4096];
+  std::set<std::string> changed;
+  for (;;) {
+    pollfd fds[2] = {
+        {this->inotify_, POLLIN, 0},
+        {this->stop_, POLLIN, 0},
+    };
+    // Waits forever for the first event, then until no more events come.
+    int const timeout = changed.empty() ? -1 : static_cast<int>(this->settle_.count());
+    int const n = poll(fds, 2, timeout);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    if (fds[1].revents & POLLIN) {
+      return;
+    }
+    if (n == 0) {
+      std::vector<std::string> const paths(changed.begin(), changed.end());
+      changed.clear();
+      this->callback_(paths);
+      continue;
+    }
+    for (;;) {
+      ssize_t const len = read(this->inotify_, buf, sizeof(buf));
+      if (len <= 0) {
+        break;
+      }
+      for (char const* ptr = buf; ptr < buf + len;) {
+        auto const* ev = reinterpret_cast<inotify_event const*>(ptr);
+        if (ev->len > 0 && !(ev->mask & IN_ISDIR)) {
+          changed.emplace(fmt::format("{}/{}", this->dir_, ev->name));
+        }
+        ptr += sizeof(inotify_event) + ev->len;
+      }
+    }
+  }
+}
+
+#else
+
+Watcher::Watcher(std::string dir, Callback callback, std::chrono::milliseconds const settle)
+:dir_(std::move(dir))
+,callback_(std::move(callback))
+,settle_(settle)
+{
+  if (!std::filesystem::is_directory(this->dir_)) {
+    throw std::runtime_error(fmt::format("Failed to watch \"{}\": not a directory", this->dir_));
+  }
+  this->times_ = this->scan();
+  this->thread_ = std::thread([this]() { this->loop(); });
+}
+
+Watcher::~Watcher() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stopping_ = true;
+  }
+  this->wake_.notify_all();
+  this->thread_.join();
+}
+
+void Watcher::loop() {
+  std::set<std::string> changed;
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  while (!this->wake_.wait_for(lock, this->settle_, [this]() { return this->stopping_; })) {
+    lock.unlock();
+    auto times = this->scan();
+    bool quiet = true;
+    for (auto const& [path, time] : times) {
+      auto const it = this->times_.find(path);
+      if (it == this->times_.end() || it->second != time) {
+        changed.emplace(fmt::format("{}/{}", this->dir_, path.filename().string()));
+        quiet = false;
+      }
+    }
+    this->times_ = std::move(times);
+    // Nothing more has changed for a whole period.
+    if (!changed.empty() && quiet) {
+      std::vector<std::string> const paths(changed.begin(), changed.end());
+      changed.clear();
+      this->callback_(paths);
+    }
+    lock.lock();
+  }
+}
+
+std::map<std::filesystem::path, std::filesystem::file_time_type> Watcher::scan() const {
+  std::map<std::filesystem::path, std::filesystem::file_time_type> times;
+  std::error_code err;
+  for (auto const& entry : std::filesystem::directory_iterator(this->dir_, err)) {
+    if (entry.is_regular_file(err)) {
+      times.emplace(entry.path(), entry.last_write_time(err));
+    }
+  }
+  return times;
+}
+
+#endif
+
+}
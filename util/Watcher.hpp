@@ -0,0 +1,64 @@
+/* coding: utf-8 */
+/**
+ * YorabaTaiju/Wakaba
+ *
+ * Copyright 2020-, Kaede Fujisaki
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <functional>
+#if !defined(__linux__)
+#include <map>
+#include <mutex>
+#include <filesystem>
+#include <condition_variable>
+#endif
+
+namespace util {
+
+// Watches the files written in a directory (not recursively), using inotify on Linux.
+// Elsewhere, the modification times are polled every `settle`.
+// The callback runs on the watcher's own thread, with the paths changed since the last call.
+// Editors save a file in several steps, so events are collected until the directory has been quiet for `settle`.
+class Watcher final {
+public:
+  using Callback = std::function<void(std::vector<std::string> const& paths)>;
+
+public:
+  Watcher() = delete;
+  Watcher(Watcher const&) = delete;
+  Watcher(Watcher&&) = delete;
+  Watcher& operator=(Watcher const&) = delete;
+  Watcher& operator=(Watcher&&) = delete;
+  Watcher(std::string dir, Callback callback, std::chrono::milliseconds settle = std::chrono::milliseconds(50));
+  ~Watcher() noexcept;
+
+public:
+  [[nodiscard]] std::string const& dir() const { return this->dir_; }
+
+private:
+  void loop();
+
+private:
+  std::string const dir_;
+  Callback const callback_;
+  std::chrono::milliseconds const settle_;
+#if defined(__linux__)
+  int inotify_ = -1;
+  int stop_ = -1; // eventfd to wake up the thread
+#else
+  [[nodiscard]] std::map<std::filesystem::path, std::filesystem::file_time_type> scan() const;
+  std::map<std::filesystem::path, std::filesystem::file_time_type> times_; // as of the last scan
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+#endif
+  std::thread thread_;
+};
+
+}